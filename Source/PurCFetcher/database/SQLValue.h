@@ -37,4 +37,17 @@ namespace PurCFetcher {
 using SQLValue = Variant<std::nullptr_t, String, double>;
 using SQLValueH = Variant<std::nullptr_t, String, double, int>;
 
+// A value of the current row of a statement, as SQLite has it: the
+// integers with their 64 bits, the text in UTF-8 and the blobs as bytes,
+// both owned by the statement until its next step or reset.
+struct SQLValueView {
+    enum class Type : uint8_t { Null, Integer, Double, Text, Blob };
+
+    Type type { Type::Null };
+    int64_t integer { 0 };
+    double number { 0 };
+    const char* data { nullptr };
+    size_t length { 0 };
+};
+
 };
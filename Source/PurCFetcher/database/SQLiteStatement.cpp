@@ -256,6 +256,16 @@ unsigned SQLiteStatement::bindParameterCount() const
     return sqlite3_bind_parameter_count(m_statement);
 }
 
+String SQLiteStatement::bindParameterName(int index) const
+{
+    ASSERT(m_isPrepared);
+    ASSERT(index > 0);
+    ASSERT(static_cast<unsigned>(index) <= bindParameterCount());
+    if (!m_statement)
+        return String();
+    return String::fromUTF8(sqlite3_bind_parameter_name(m_statement, index));
+}
+
 int SQLiteStatement::columnCount()
 {
     ASSERT(m_isPrepared);
@@ -360,6 +370,46 @@ SQLValueH SQLiteStatement::getColumnValueH(int col)
     return nullptr;
 }
 
+SQLValueView SQLiteStatement::getColumnValueView(int col)
+{
+    ASSERT(col >= 0);
+    SQLValueView view;
+    if (!m_statement)
+        if (prepareAndStep() != SQLITE_ROW)
+            return view;
+    if (columnCount() <= col)
+        return view;
+
+    switch (sqlite3_column_type(m_statement, col)) {
+        case SQLITE_INTEGER:
+            view.type = SQLValueView::Type::Integer;
+            view.integer = sqlite3_column_int64(m_statement, col);
+            break;
+        case SQLITE_FLOAT:
+            view.type = SQLValueView::Type::Double;
+            view.number = sqlite3_column_double(m_statement, col);
+            break;
+        case SQLITE_TEXT:
+            // sqlite3_column_bytes() after sqlite3_column_text(): the length
+            // of the UTF-8
+            view.type = SQLValueView::Type::Text;
+            view.data = reinterpret_cast<const char*>(sqlite3_column_text(m_statement, col));
+            view.length = sqlite3_column_bytes(m_statement, col);
+            break;
+        case SQLITE_BLOB:
+            view.type = SQLValueView::Type::Blob;
+            view.data = static_cast<const char*>(sqlite3_column_blob(m_statement, col));
+            view.length = sqlite3_column_bytes(m_statement, col);
+            break;
+        case SQLITE_NULL:
+            break;
+        default:
+            ASSERT_NOT_REACHED();
+            break;
+    }
+    return view;
+}
+
 String SQLiteStatement::getColumnText(int col)
 {
     ASSERT(col >= 0);
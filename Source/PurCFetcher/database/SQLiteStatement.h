@@ -49,6 +49,8 @@ public:
     PURCFETCHER_EXPORT int bindNull(int index);
     PURCFETCHER_EXPORT int bindValue(int index, const SQLValue&);
     PURCFETCHER_EXPORT unsigned bindParameterCount() const;
+    // The name of the parameter with its prefix, as ":name"; null for "?".
+    PURCFETCHER_EXPORT String bindParameterName(int index) const;
 
     PURCFETCHER_EXPORT int step();
     PURCFETCHER_EXPORT int finalize();
@@ -77,6 +79,8 @@ public:
     String getColumnName(int col);
     SQLValue getColumnValue(int col);
     SQLValueH getColumnValueH(int col);
+    // no conversion and no copy, for the values written out at once
+    SQLValueView getColumnValueView(int col);
     PURCFETCHER_EXPORT String getColumnText(int col);
     PURCFETCHER_EXPORT double getColumnDouble(int col);
     PURCFETCHER_EXPORT int getColumnInt(int col);
@@ -0,0 +1,99 @@
+/**
+ * @file purc_fetcher_local.h
+ * @author XueShuming
+ * @date 2021/11/16
+ * @brief The interface to run PurCFetcher in the calling process.
+ *
+ * Copyright (C) 2021 FMSoft <https://www.fmsoft.cn>
+ *
+ * This file is a part of PurCFetcher, which contains the examples of my course:
+ * _the Best Practices of C Language_.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the “Software”), to
+ * deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef PURCFETCHER_PURCFETCHER_LOCAL_H
+#define PURCFETCHER_PURCFETCHER_LOCAL_H
+
+#include "purc_fetcher_macros.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * The callbacks of a load. They are called on the fetcher thread, so
+ * they should return quickly.
+ */
+struct purc_fetcher_local_client {
+    void (*did_receive_response)(void* ctxt, int status_code,
+            const char* mime_type, int64_t expected_length);
+    void (*did_receive_data)(void* ctxt, const char* data, size_t size);
+
+    /* status_code is 408 if the load failed. */
+    void (*did_finish)(void* ctxt, int status_code);
+};
+
+PURCFETCHER_EXTERN_C_BEGIN
+
+/**
+ * purc_fetcher_local_start:
+ *
+ * @max_conns: the maximum number of connections, 0 for the default.
+ * @cache_quota: the size of the disk cache in bytes, 0 for no quota.
+ *
+ * Starts the network process on a dedicated thread of the calling process.
+ * The thread becomes the main thread of WTF, so the calling process must
+ * not use WTF itself. Once started, the fetcher thread keeps running until
+ * purc_fetcher_local_stop() or the process exits; calling this function
+ * again only updates the limits. A stopped fetcher can not start again.
+ *
+ * Returns: @true on success.
+ */
+PURCFETCHER_EXPORT bool purc_fetcher_local_start(size_t max_conns,
+        size_t cache_quota);
+
+/**
+ * purc_fetcher_local_load:
+ *
+ * Starts loading @url. The callbacks of @client are called on the fetcher
+ * thread; did_finish is always the last one.
+ *
+ * Returns: the identifier of the load; 0 if the fetcher is not started.
+ */
+PURCFETCHER_EXPORT uint64_t purc_fetcher_local_load(const char* url,
+        const char* method, uint32_t timeout,
+        const struct purc_fetcher_local_client* client, void* ctxt);
+
+/**
+ * purc_fetcher_local_stop:
+ *
+ * Stops the fetcher thread and waits for it to exit. The loads in flight
+ * fail with status code 500; their did_finish is called on the fetcher
+ * thread before this function returns. Not to be called from a callback.
+ */
+PURCFETCHER_EXPORT void purc_fetcher_local_stop(void);
+
+PURCFETCHER_EXPORT void purc_fetcher_local_set_max_conns(size_t max_conns);
+
+PURCFETCHER_EXPORT void purc_fetcher_local_set_cache_quota(size_t cache_quota);
+
+PURCFETCHER_EXTERN_C_END
+
+#endif /* not defined PURCFETCHER_PURCFETCHER_LOCAL_H */
@@ -26,6 +26,7 @@
 #include "config.h"
 #include "Connection.h"
 #include "MessageFlags.h"
+#include "MessageStatistics.h"
 
 #include <memory>
 #include <wtf/HashSet.h>
@@ -36,6 +37,7 @@
 #include <wtf/threads/BinarySemaphore.h>
 
 #if USE(UNIX_DOMAIN_SOCKETS)
+#include "MessageRing.h"
 #include "UnixMessage.h"
 #endif
 
@@ -43,6 +45,15 @@ namespace IPC {
 
 std::atomic<unsigned> UnboundedSynchronousIPCScope::unboundedSynchronousIPCCount = 0;
 
+static void recordQueueingDelay(const Decoder& decoder)
+{
+    auto& statistics = MessageStatistics::singleton();
+    if (!statistics.isEnabled() || !decoder.sendTime())
+        return;
+
+    statistics.didDispatch(decoder.messageName(), MonotonicTime::now() - decoder.sendTime());
+}
+
 struct Connection::WaitForMessageState {
     WaitForMessageState(MessageName messageName, uint64_t destinationID, OptionSet<WaitForOption> waitForOptions)
         : messageName(messageName)
@@ -317,6 +328,8 @@ void Connection::removeWorkQueueMessageReceiver(ReceiverName messageReceiverName
 
 void Connection::dispatchWorkQueueMessageReceiverMessage(WorkQueueMessageReceiver& workQueueMessageReceiver, Decoder& decoder)
 {
+    recordQueueingDelay(decoder);
+
     if (!decoder.isSyncMessage()) {
         workQueueMessageReceiver.didReceiveMessage(*this, decoder);
         return;
@@ -364,6 +377,8 @@ void Connection::removeThreadMessageReceiver(ReceiverName messageReceiverName)
 
 void Connection::dispatchThreadMessageReceiverMessage(ThreadMessageReceiver& threadMessageReceiver, Decoder& decoder)
 {
+    recordQueueingDelay(decoder);
+
     if (!decoder.isSyncMessage()) {
         threadMessageReceiver.didReceiveMessage(*this, decoder);
         return;
@@ -449,10 +464,16 @@ bool Connection::sendMessage(std::unique_ptr<Encoder> encoder, OptionSet<SendOpt
     else if (sendOptions.contains(SendOption::DispatchMessageEvenWhenWaitingForUnboundedSyncReply))
         encoder->setShouldDispatchMessageWhenWaitingForSyncReply(ShouldDispatchWhenWaitingForSyncReply::YesDuringUnboundedIPC);
 
+    encoder->setSendTime(MonotonicTime::now());
+    auto messageName = encoder->messageName();
+    size_t messageSize = encoder->bufferSize();
+    size_t sendQueueDepth;
     {
         auto locker = holdLock(m_outgoingMessagesMutex);
         m_outgoingMessages.append(WTFMove(encoder));
+        sendQueueDepth = m_outgoingMessages.size();
     }
+    MessageStatistics::singleton().didSend(messageName, messageSize, sendQueueDepth);
 
     // FIXME: We should add a boolean flag so we don't call this when work has already been scheduled.
     m_connectionQueue->dispatch([protectedThis = makeRef(*this)]() mutable {
@@ -687,7 +708,10 @@ void Connection::processIncomingMessage(std::unique_ptr<Decoder> message)
 {
     ASSERT(message->messageReceiverName() != ReceiverName::Invalid);
 
+    MessageStatistics::singleton().didReceive(message->messageName(), message->length());
+
     if (message->messageName() == MessageName::SyncMessageReply) {
+        recordQueueingDelay(*message);
         processIncomingSyncReply(WTFMove(message));
         return;
     }
@@ -1004,6 +1028,8 @@ void Connection::dispatchMessage(std::unique_ptr<Decoder> message)
     if (dispatchMessageToWorkQueueReceiver(message))
         return;
 
+    recordQueueingDelay(*message);
+
     if (message->shouldUseFullySynchronousModeForTesting()) {
         if (!m_fullySynchronousModeIsAllowedForTesting) {
             m_client.didReceiveInvalidMessage(*this, message->messageName());
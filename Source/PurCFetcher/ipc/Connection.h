@@ -96,6 +96,7 @@ template<typename AsyncReplyResult> struct AsyncReplyError {
 };
 
 class MachMessage;
+class MessageRing;
 class UnixMessage;
 
 class Connection : public ThreadSafeRefCounted<Connection, WTF::DestructionThread::MainRunLoop> {
@@ -355,6 +356,12 @@ private:
     Vector<int> m_fileDescriptors;
     int m_socketDescriptor;
     std::unique_ptr<UnixMessage> m_pendingOutputMessage;
+
+    // the rings for the bodies of large messages, see MessageRing
+    bool sendBodyThroughRing(UnixMessage&);
+    RefPtr<MessageRing> m_sendRing;
+    RefPtr<MessageRing> m_receiveRing;
+    bool m_sendRingFailed { false };
 #if USE(GLIB)
     GRefPtr<GSocket> m_socket;
     GSocketMonitor m_readSocketMonitor;
@@ -29,6 +29,7 @@
 #include "Attachment.h"
 #include "MessageNames.h"
 #include "StringReference.h"
+#include <wtf/MonotonicTime.h>
 #include <wtf/OptionSet.h>
 #include <wtf/Vector.h>
 
@@ -61,6 +62,10 @@ public:
 
     size_t length() const { return m_bufferEnd - m_buffer; }
 
+    // The send time of the encoder, when the transport carries it.
+    void setSendTime(MonotonicTime sendTime) { m_sendTime = sendTime; }
+    MonotonicTime sendTime() const { return m_sendTime; }
+
     WARN_UNUSED_RETURN bool isValid() const { return m_bufferPos != nullptr; }
     void markInvalid() { m_bufferPos = nullptr; }
 
@@ -173,6 +178,8 @@ private:
     MessageName m_messageName;
 
     uint64_t m_destinationID;
+
+    MonotonicTime m_sendTime;
 };
 
 } // namespace IPC
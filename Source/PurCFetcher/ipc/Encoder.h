@@ -29,6 +29,7 @@
 #include "Attachment.h"
 #include "MessageNames.h"
 #include "StringReference.h"
+#include <wtf/MonotonicTime.h>
 #include <wtf/OptionSet.h>
 #include <wtf/Vector.h>
 
@@ -55,6 +56,10 @@ public:
     void setShouldDispatchMessageWhenWaitingForSyncReply(ShouldDispatchWhenWaitingForSyncReply);
     ShouldDispatchWhenWaitingForSyncReply shouldDispatchMessageWhenWaitingForSyncReply() const;
 
+    // When the message was handed to the connection, for the queueing delay.
+    void setSendTime(MonotonicTime sendTime) { m_sendTime = sendTime; }
+    MonotonicTime sendTime() const { return m_sendTime; }
+
     void setFullySynchronousModeForTesting();
 
     void wrapForTesting(std::unique_ptr<Encoder>);
@@ -125,6 +130,8 @@ private:
     size_t m_bufferCapacity;
 
     Vector<Attachment> m_attachments;
+
+    MonotonicTime m_sendTime;
 };
 
 } // namespace IPC
@@ -60,10 +60,43 @@ public:
     size_t bodySize() const { return m_bodySize; }
     size_t attachmentCount() const { return m_attachmentCount; }
 
+    // The body is in the MessageRing of the connection, at bodyOffset().
+    void setBodyInRing(uint64_t offset)
+    {
+        ASSERT(!isBodyOutOfLine());
+
+        m_isBodyInRing = true;
+        m_bodyOffset = offset;
+    }
+
+    bool isBodyInRing() const { return m_isBodyInRing; }
+    uint64_t bodyOffset() const { return m_bodyOffset; }
+    bool isBodyInline() const { return !m_isBodyOutOfLine && !m_isBodyInRing; }
+
+    // The last attachment is the MessageRing the sender starts using.
+    void setCarriesRing()
+    {
+        ASSERT(!carriesRing());
+
+        m_carriesRing = true;
+        m_attachmentCount++;
+    }
+
+    bool carriesRing() const { return m_carriesRing; }
+
+    // The send time of the encoder, in seconds of the monotonic clock
+    // shared by both ends.
+    void setSendTime(double sendTime) { m_sendTime = sendTime; }
+    double sendTime() const { return m_sendTime; }
+
 private:
     size_t m_bodySize { 0 };
-    size_t m_attachmentCount { 0 };
+    uint64_t m_bodyOffset { 0 };
+    double m_sendTime { 0 };
+    uint32_t m_attachmentCount { 0 };
     bool m_isBodyOutOfLine { false };
+    bool m_isBodyInRing { false };
+    bool m_carriesRing { false };
 };
 
 class UnixMessage {
@@ -74,6 +107,7 @@ public:
         , m_messageInfo(encoder.bufferSize(), m_attachments.size())
         , m_body(encoder.buffer())
     {
+        m_messageInfo.setSendTime(encoder.sendTime().secondsSinceEpoch().seconds());
     }
 
     UnixMessage(UnixMessage&& other)
@@ -83,7 +117,7 @@ public:
         if (other.m_bodyOwned) {
             std::swap(m_body, other.m_body);
             std::swap(m_bodyOwned, other.m_bodyOwned);
-        } else if (!m_messageInfo.isBodyOutOfLine()) {
+        } else if (m_messageInfo.isBodyInline()) {
             m_body = static_cast<uint8_t*>(fastMalloc(m_messageInfo.bodySize()));
             memcpy(m_body, other.m_body, m_messageInfo.bodySize());
             m_bodyOwned = true;
@@ -0,0 +1,309 @@
+/* 
+ * Copyright (C) 2020 Beijing FMSoft Technologies Co., Ltd.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ * 
+ * Or,
+ * 
+ * As this component is a program released under LGPLv3, which claims
+ * explicitly that the program could be modified by any end user
+ * even if the program is conveyed in non-source form on the system it runs.
+ * Generally, if you distribute this program in embedded devices,
+ * you might not satisfy this condition. Under this situation or you can
+ * not accept any condition of LGPLv3, you need to get a commercial license
+ * from FMSoft, along with a patent license for the patents owned by FMSoft.
+ * 
+ * If you have got a commercial/patent license of this program, please use it
+ * under the terms and conditions of the commercial license.
+ * 
+ * For more information about the commercial license and patent license,
+ * please refer to
+ * <https://hybridos.fmsoft.cn/blog/hybridos-licensing-policy/>.
+ * 
+ * Also note that the LGPLv3 license does not apply to any entity in the
+ * Exception List published by Beijing FMSoft Technologies Co., Ltd.
+ * 
+ * If you are or the entity you represent is listed in the Exception List,
+ * the above open source or free software license does not apply to you
+ * or the entity you represent. Regardless of the purpose, you should not
+ * use the software in any way whatsoever, including but not limited to
+ * downloading, viewing, copying, distributing, compiling, and running.
+ * If you have already downloaded it, you MUST destroy all of its copies.
+ * 
+ * The Exception List is published by FMSoft and may be updated
+ * from time to time. For more information, please see
+ * <https://www.fmsoft.cn/exception-list>.
+ */ 
+
+#include "config.h"
+#include "JSONStreamWriter.h"
+
+#include <wtf/ASCIICType.h>
+#include <wtf/dtoa.h>
+#include <wtf/unicode/CharacterNames.h>
+
+namespace PurCFetcher {
+
+JSONStreamWriter::JSONStreamWriter(size_t segmentSize)
+    : m_segmentSize(std::max<size_t>(segmentSize, 1))
+    , m_buffer(SharedBuffer::create())
+{
+}
+
+JSONStreamWriter::~JSONStreamWriter()
+{
+}
+
+void JSONStreamWriter::beginValue()
+{
+    if (m_needsComma)
+        append(',');
+    m_needsComma = true;
+}
+
+void JSONStreamWriter::beginObject()
+{
+    beginValue();
+    append('{');
+    m_needsComma = false;
+}
+
+void JSONStreamWriter::endObject()
+{
+    append('}');
+    m_needsComma = true;
+}
+
+void JSONStreamWriter::beginArray()
+{
+    beginValue();
+    append('[');
+    m_needsComma = false;
+}
+
+void JSONStreamWriter::endArray()
+{
+    append(']');
+    m_needsComma = true;
+}
+
+void JSONStreamWriter::writeKey(StringView key)
+{
+    writeString(key);
+    append(':');
+    m_needsComma = false;
+}
+
+void JSONStreamWriter::writeString(StringView string)
+{
+    beginValue();
+    append('"');
+    if (string.is8Bit())
+        appendEscaped(string.characters8(), string.length());
+    else
+        appendEscaped(string.characters16(), string.length());
+    append('"');
+}
+
+void JSONStreamWriter::writeUTF8String(const char* characters, size_t length)
+{
+    beginValue();
+    append('"');
+    appendEscapedUTF8(reinterpret_cast<const LChar*>(characters), length);
+    append('"');
+}
+
+void JSONStreamWriter::writeInteger(int64_t value)
+{
+    beginValue();
+
+    char digits[24];
+    char* end = digits + sizeof(digits);
+    char* start = end;
+    // the magnitude as unsigned, INT64_MIN included
+    uint64_t magnitude = value < 0 ? -static_cast<uint64_t>(value) : value;
+    do {
+        *--start = '0' + magnitude % 10;
+        magnitude /= 10;
+    } while (magnitude);
+    if (value < 0)
+        *--start = '-';
+    append(start, end - start);
+}
+
+void JSONStreamWriter::writeDouble(double value)
+{
+    if (!std::isfinite(value)) {
+        writeNull();
+        return;
+    }
+
+    beginValue();
+    NumberToStringBuffer buffer;
+    const char* number = numberToString(value, buffer);
+    append(number, strlen(number));
+}
+
+void JSONStreamWriter::writeBoolean(bool value)
+{
+    beginValue();
+    if (value)
+        append("true", 4);
+    else
+        append("false", 5);
+}
+
+void JSONStreamWriter::writeNull()
+{
+    beginValue();
+    append("null", 4);
+}
+
+void JSONStreamWriter::writeJSON(Ref<SharedBuffer>&& json)
+{
+    beginValue();
+    flushSegment();
+    m_buffer->append(json.get());
+}
+
+void JSONStreamWriter::endLine()
+{
+    append('\n');
+    m_needsComma = false;
+}
+
+Ref<SharedBuffer> JSONStreamWriter::take()
+{
+    flushSegment();
+    return std::exchange(m_buffer, SharedBuffer::create());
+}
+
+void JSONStreamWriter::flushSegment()
+{
+    if (m_segment.isEmpty())
+        return;
+    m_buffer->append(WTFMove(m_segment));
+    m_segment = { };
+}
+
+void JSONStreamWriter::append(const char* characters, size_t length)
+{
+    while (length) {
+        if (m_segment.size() == m_segmentSize)
+            flushSegment();
+        size_t count = std::min(length, m_segmentSize - m_segment.size());
+        m_segment.append(characters, count);
+        characters += count;
+        length -= count;
+    }
+}
+
+void JSONStreamWriter::append(const UChar* characters, size_t length)
+{
+    // only called with ASCII, the rest is escaped
+    for (size_t i = 0; i < length; i++)
+        append(static_cast<char>(characters[i]));
+}
+
+template<typename CharacterType>
+void JSONStreamWriter::appendEscaped(const CharacterType* characters, size_t length)
+{
+    // the runs of characters written as they are go in one append
+    size_t start = 0;
+    for (size_t i = 0; i < length; i++) {
+        CharacterType character = characters[i];
+        if (character >= 32 && character < 127 && character != '"' && character != '\\'
+            && character != '<' && character != '>')
+            continue;
+
+        append(characters + start, i - start);
+        appendEscapedCharacter(character);
+        start = i + 1;
+    }
+    append(characters + start, length - start);
+}
+
+void JSONStreamWriter::appendEscapedUTF8(const LChar* characters, size_t length)
+{
+    // the same escapes as for UTF-16: the characters out of ASCII as
+    // \uXXXX, two of them out of the BMP
+    size_t start = 0;
+    size_t i = 0;
+    while (i < length) {
+        LChar character = characters[i];
+        if (character >= 32 && character < 127 && character != '"' && character != '\\'
+            && character != '<' && character != '>') {
+            i++;
+            continue;
+        }
+
+        append(characters + start, i - start);
+        if (isASCII(character)) {
+            appendEscapedCharacter(character);
+            i++;
+        } else {
+            // a sequence is at most 4 bytes long
+            int32_t offset = 0;
+            UChar32 codePoint;
+            U8_NEXT(characters + i, offset, static_cast<int32_t>(std::min<size_t>(length - i, 4)), codePoint);
+            i += offset;
+            if (codePoint < 0)
+                codePoint = replacementCharacter;
+            if (U_IS_BMP(codePoint))
+                appendEscapedCharacter(codePoint);
+            else {
+                appendEscapedCharacter(U16_LEAD(codePoint));
+                appendEscapedCharacter(U16_TRAIL(codePoint));
+            }
+        }
+        start = i;
+    }
+    append(characters + start, length - start);
+}
+
+void JSONStreamWriter::appendEscapedCharacter(UChar character)
+{
+    switch (character) {
+    case '\b':
+        append("\\b", 2);
+        return;
+    case '\f':
+        append("\\f", 2);
+        return;
+    case '\n':
+        append("\\n", 2);
+        return;
+    case '\r':
+        append("\\r", 2);
+        return;
+    case '\t':
+        append("\\t", 2);
+        return;
+    case '\\':
+        append("\\\\", 2);
+        return;
+    case '"':
+        append("\\\"", 2);
+        return;
+    }
+
+    char escaped[6] = {
+        '\\', 'u',
+        upperNibbleToASCIIHexDigit(character >> 8), lowerNibbleToASCIIHexDigit(character >> 8),
+        upperNibbleToASCIIHexDigit(character), lowerNibbleToASCIIHexDigit(character)
+    };
+    append(escaped, sizeof(escaped));
+}
+
+} // namespace PurCFetcher
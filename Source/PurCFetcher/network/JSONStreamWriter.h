@@ -0,0 +1,136 @@
+/* 
+ * Copyright (C) 2020 Beijing FMSoft Technologies Co., Ltd.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ * 
+ * Or,
+ * 
+ * As this component is a program released under LGPLv3, which claims
+ * explicitly that the program could be modified by any end user
+ * even if the program is conveyed in non-source form on the system it runs.
+ * Generally, if you distribute this program in embedded devices,
+ * you might not satisfy this condition. Under this situation or you can
+ * not accept any condition of LGPLv3, you need to get a commercial license
+ * from FMSoft, along with a patent license for the patents owned by FMSoft.
+ * 
+ * If you have got a commercial/patent license of this program, please use it
+ * under the terms and conditions of the commercial license.
+ * 
+ * For more information about the commercial license and patent license,
+ * please refer to
+ * <https://hybridos.fmsoft.cn/blog/hybridos-licensing-policy/>.
+ * 
+ * Also note that the LGPLv3 license does not apply to any entity in the
+ * Exception List published by Beijing FMSoft Technologies Co., Ltd.
+ * 
+ * If you are or the entity you represent is listed in the Exception List,
+ * the above open source or free software license does not apply to you
+ * or the entity you represent. Regardless of the purpose, you should not
+ * use the software in any way whatsoever, including but not limited to
+ * downloading, viewing, copying, distributing, compiling, and running.
+ * If you have already downloaded it, you MUST destroy all of its copies.
+ * 
+ * The Exception List is published by FMSoft and may be updated
+ * from time to time. For more information, please see
+ * <https://www.fmsoft.cn/exception-list>.
+ */ 
+
+#pragma once
+
+#include "SharedBuffer.h"
+#include <wtf/FastMalloc.h>
+#include <wtf/Noncopyable.h>
+#include <wtf/Vector.h>
+#include <wtf/text/StringView.h>
+
+namespace PurCFetcher {
+
+// Writes JSON text straight into the segments of a SharedBuffer, so a
+// response is serialized in one pass, without building the JSON::Value
+// tree first. A segment is handed to the buffer as it fills up; the text
+// written so far can be taken at any time, to be sent while the rest is
+// being written.
+//
+// The strings are escaped as JSON::Value::toJSONString() does: everything
+// outside of printable ASCII, and '<' and '>', as \u sequences of the code
+// units. The keys are written as given, a key given twice is not merged.
+class JSONStreamWriter {
+    WTF_MAKE_NONCOPYABLE(JSONStreamWriter);
+    WTF_MAKE_FAST_ALLOCATED;
+public:
+    explicit JSONStreamWriter(size_t segmentSize = defaultSegmentSize);
+    ~JSONStreamWriter();
+
+    void beginObject();
+    void endObject();
+    void beginArray();
+    void endArray();
+
+    // The key of the next value, in an object.
+    void writeKey(StringView);
+
+    void writeString(StringView);
+    // A string in UTF-8, as SQLite has it: escaped as writeString() does
+    // with no String made of it. The bytes that are not UTF-8 are written
+    // as U+FFFD.
+    void writeUTF8String(const char*, size_t length);
+    void writeInteger(int64_t);
+    // null if the number is not finite
+    void writeDouble(double);
+    void writeBoolean(bool);
+    void writeNull();
+
+    // A value already written as JSON, by another writer. The segments
+    // are moved, not copied.
+    void writeJSON(Ref<SharedBuffer>&&);
+
+    // Ends a top level value with a line feed, as in NDJSON.
+    void endLine();
+
+    // The size of all the text written since the last take().
+    size_t size() const { return m_buffer->size() + m_segment.size(); }
+    bool isEmpty() const { return !size(); }
+
+    // The text written since the last call.
+    Ref<SharedBuffer> take();
+
+    static constexpr size_t defaultSegmentSize = 64 * 1024;
+
+private:
+    void beginValue();
+    void append(char);
+    void append(const char*, size_t);
+    void append(const LChar* characters, size_t length) { append(reinterpret_cast<const char*>(characters), length); }
+    void append(const UChar*, size_t);
+    template<typename CharacterType> void appendEscaped(const CharacterType*, size_t);
+    void appendEscapedUTF8(const LChar*, size_t);
+    void appendEscapedCharacter(UChar);
+    void flushSegment();
+
+    size_t m_segmentSize;
+    Vector<char> m_segment;
+    Ref<SharedBuffer> m_buffer;
+
+    // a value written at this level is preceded by a comma
+    bool m_needsComma { false };
+};
+
+inline void JSONStreamWriter::append(char character)
+{
+    if (m_segment.size() == m_segmentSize)
+        flushSegment();
+    m_segment.append(character);
+}
+
+} // namespace PurCFetcher
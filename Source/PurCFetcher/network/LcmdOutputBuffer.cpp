@@ -0,0 +1,180 @@
+/* 
+ * Copyright (C) 2020 Beijing FMSoft Technologies Co., Ltd.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ * 
+ * Or,
+ * 
+ * As this component is a program released under LGPLv3, which claims
+ * explicitly that the program could be modified by any end user
+ * even if the program is conveyed in non-source form on the system it runs.
+ * Generally, if you distribute this program in embedded devices,
+ * you might not satisfy this condition. Under this situation or you can
+ * not accept any condition of LGPLv3, you need to get a commercial license
+ * from FMSoft, along with a patent license for the patents owned by FMSoft.
+ * 
+ * If you have got a commercial/patent license of this program, please use it
+ * under the terms and conditions of the commercial license.
+ * 
+ * For more information about the commercial license and patent license,
+ * please refer to
+ * <https://hybridos.fmsoft.cn/blog/hybridos-licensing-policy/>.
+ * 
+ * Also note that the LGPLv3 license does not apply to any entity in the
+ * Exception List published by Beijing FMSoft Technologies Co., Ltd.
+ * 
+ * If you are or the entity you represent is listed in the Exception List,
+ * the above open source or free software license does not apply to you
+ * or the entity you represent. Regardless of the purpose, you should not
+ * use the software in any way whatsoever, including but not limited to
+ * downloading, viewing, copying, distributing, compiling, and running.
+ * If you have already downloaded it, you MUST destroy all of its copies.
+ * 
+ * The Exception List is published by FMSoft and may be updated
+ * from time to time. For more information, please see
+ * <https://www.fmsoft.cn/exception-list>.
+ */ 
+
+#include "config.h"
+#include "LcmdOutputBuffer.h"
+
+#if ENABLE(LCMD)
+
+#include <string.h>
+
+namespace PurCFetcher {
+
+static constexpr size_t maximumSegmentSize = 4 * 1024 * 1024;
+
+LcmdOutputBuffer::LcmdOutputBuffer()
+{
+}
+
+LcmdOutputBuffer::~LcmdOutputBuffer()
+{
+}
+
+char* LcmdOutputBuffer::writableData()
+{
+    if (m_segments.isEmpty() || lastSegment().capacity - lastSegment().size < minimumReadSize)
+        addSegment();
+    return lastSegment().data.get() + lastSegment().size;
+}
+
+size_t LcmdOutputBuffer::writableSize() const
+{
+    ASSERT(!m_segments.isEmpty());
+    return lastSegment().capacity - lastSegment().size;
+}
+
+void LcmdOutputBuffer::addSegment()
+{
+    // the segments double in size so a large output takes few of them
+    size_t capacity = minimumReadSize * 2;
+    size_t partialLineSize = 0;
+    if (!m_segments.isEmpty()) {
+        capacity = std::min(lastSegment().capacity * 2, maximumSegmentSize);
+        partialLineSize = lastSegment().size - m_lineStart;
+    }
+    capacity = std::max(capacity, partialLineSize + minimumReadSize);
+
+    auto segment = makeUnique<Segment>(capacity);
+    if (partialLineSize) {
+        memcpy(segment->data.get(), lastSegment().data.get() + m_lineStart, partialLineSize);
+        segment->size = partialLineSize;
+    }
+
+    // a segment holding only the start of a long line is no longer needed
+    if (!m_segments.isEmpty() && !lastSegment().hasLines)
+        m_segments.removeLast();
+
+    m_segments.append(WTFMove(segment));
+    m_lineStart = 0;
+}
+
+void LcmdOutputBuffer::indexLine(Segment& segment, size_t end)
+{
+    // empty lines are dropped, as String::split() does
+    if (end > m_lineStart) {
+        m_lines.append({ segment.data.get() + m_lineStart, static_cast<unsigned>(end - m_lineStart) });
+        segment.hasLines = true;
+    }
+}
+
+void LcmdOutputBuffer::didWrite(size_t size)
+{
+    auto& segment = lastSegment();
+    ASSERT(segment.size + size <= segment.capacity);
+
+    const char* data = segment.data.get();
+    size_t position = segment.size;
+    segment.size += size;
+
+    while (position < segment.size) {
+        auto* lineFeed = static_cast<const char*>(memchr(data + position, '\n', segment.size - position));
+        if (!lineFeed)
+            break;
+
+        size_t end = lineFeed - data;
+        indexLine(segment, end);
+        m_lineStart = end + 1;
+        position = end + 1;
+    }
+}
+
+void LcmdOutputBuffer::finish()
+{
+    if (m_segments.isEmpty())
+        return;
+
+    auto& segment = lastSegment();
+    indexLine(segment, segment.size);
+    m_lineStart = segment.size;
+}
+
+StringView LcmdOutputBuffer::line(size_t index) const
+{
+    auto& line = m_lines[index];
+    return StringView(reinterpret_cast<const LChar*>(line.data), line.length);
+}
+
+Vector<StringView> LcmdOutputBuffer::lines() const
+{
+    Vector<StringView> lines;
+    lines.reserveInitialCapacity(m_lines.size());
+    for (size_t i = 0; i < m_lines.size(); ++i)
+        lines.uncheckedAppend(line(i));
+    return lines;
+}
+
+void LcmdOutputBuffer::discardLines()
+{
+    m_lines.clear();
+    if (m_segments.isEmpty())
+        return;
+
+    // only the last segment may hold the line being read
+    if (m_segments.size() > 1)
+        m_segments.remove(0, m_segments.size() - 1);
+    lastSegment().hasLines = false;
+}
+
+bool LcmdOutputBuffer::isEmpty() const
+{
+    return m_lines.isEmpty() && (m_segments.isEmpty() || m_lineStart == lastSegment().size);
+}
+
+} // namespace PurCFetcher
+
+#endif // ENABLE(LCMD)
@@ -0,0 +1,130 @@
+/* 
+ * Copyright (C) 2020 Beijing FMSoft Technologies Co., Ltd.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ * 
+ * Or,
+ * 
+ * As this component is a program released under LGPLv3, which claims
+ * explicitly that the program could be modified by any end user
+ * even if the program is conveyed in non-source form on the system it runs.
+ * Generally, if you distribute this program in embedded devices,
+ * you might not satisfy this condition. Under this situation or you can
+ * not accept any condition of LGPLv3, you need to get a commercial license
+ * from FMSoft, along with a patent license for the patents owned by FMSoft.
+ * 
+ * If you have got a commercial/patent license of this program, please use it
+ * under the terms and conditions of the commercial license.
+ * 
+ * For more information about the commercial license and patent license,
+ * please refer to
+ * <https://hybridos.fmsoft.cn/blog/hybridos-licensing-policy/>.
+ * 
+ * Also note that the LGPLv3 license does not apply to any entity in the
+ * Exception List published by Beijing FMSoft Technologies Co., Ltd.
+ * 
+ * If you are or the entity you represent is listed in the Exception List,
+ * the above open source or free software license does not apply to you
+ * or the entity you represent. Regardless of the purpose, you should not
+ * use the software in any way whatsoever, including but not limited to
+ * downloading, viewing, copying, distributing, compiling, and running.
+ * If you have already downloaded it, you MUST destroy all of its copies.
+ * 
+ * The Exception List is published by FMSoft and may be updated
+ * from time to time. For more information, please see
+ * <https://www.fmsoft.cn/exception-list>.
+ */ 
+
+#pragma once
+
+#if ENABLE(LCMD)
+
+#include <wtf/FastMalloc.h>
+#include <wtf/Noncopyable.h>
+#include <wtf/UniqueArray.h>
+#include <wtf/Vector.h>
+#include <wtf/text/StringView.h>
+
+namespace PurCFetcher {
+
+// The output of an lcmd command, read straight into large segments, with
+// an index of the lines in it. A line never spans two segments: the part
+// of a line left at the end of a full segment is moved to the next one,
+// so every line can be handed out as a StringView over the buffer.
+//
+// The bytes are seen as Latin-1 characters, as the output has always been,
+// which lets the UTF-8 text go through the JSON unchanged.
+class LcmdOutputBuffer {
+    WTF_MAKE_NONCOPYABLE(LcmdOutputBuffer);
+    WTF_MAKE_FAST_ALLOCATED;
+public:
+    LcmdOutputBuffer();
+    ~LcmdOutputBuffer();
+
+    // Space for the next read, at least minimumReadSize bytes.
+    char* writableData();
+    size_t writableSize() const;
+
+    // Indexes the lines completed by the size bytes just read.
+    void didWrite(size_t size);
+
+    // Indexes the last line if it has no line feed.
+    void finish();
+
+    size_t lineCount() const { return m_lines.size(); }
+    StringView line(size_t index) const;
+    Vector<StringView> lines() const;
+
+    // Drops the indexed lines and the segments only they used.
+    void discardLines();
+
+    bool isEmpty() const;
+
+    static constexpr size_t minimumReadSize = 64 * 1024;
+
+private:
+    struct Segment {
+        WTF_MAKE_STRUCT_FAST_ALLOCATED;
+
+        explicit Segment(size_t capacity)
+            : data(makeUniqueArray<char>(capacity))
+            , capacity(capacity)
+        {
+        }
+
+        UniqueArray<char> data;
+        size_t capacity;
+        size_t size { 0 };
+        bool hasLines { false };
+    };
+
+    struct Line {
+        const char* data;
+        unsigned length;
+    };
+
+    Segment& lastSegment() const { return *m_segments.last(); }
+    void addSegment();
+    void indexLine(Segment&, size_t end);
+
+    Vector<std::unique_ptr<Segment>> m_segments;
+    Vector<Line> m_lines;
+
+    // the start of the line being read, in the last segment
+    size_t m_lineStart { 0 };
+};
+
+} // namespace PurCFetcher
+
+#endif // ENABLE(LCMD)
@@ -0,0 +1,394 @@
+/* 
+ * Copyright (C) 2020 Beijing FMSoft Technologies Co., Ltd.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ * 
+ * Or,
+ * 
+ * As this component is a program released under LGPLv3, which claims
+ * explicitly that the program could be modified by any end user
+ * even if the program is conveyed in non-source form on the system it runs.
+ * Generally, if you distribute this program in embedded devices,
+ * you might not satisfy this condition. Under this situation or you can
+ * not accept any condition of LGPLv3, you need to get a commercial license
+ * from FMSoft, along with a patent license for the patents owned by FMSoft.
+ * 
+ * If you have got a commercial/patent license of this program, please use it
+ * under the terms and conditions of the commercial license.
+ * 
+ * For more information about the commercial license and patent license,
+ * please refer to
+ * <https://hybridos.fmsoft.cn/blog/hybridos-licensing-policy/>.
+ * 
+ * Also note that the LGPLv3 license does not apply to any entity in the
+ * Exception List published by Beijing FMSoft Technologies Co., Ltd.
+ * 
+ * If you are or the entity you represent is listed in the Exception List,
+ * the above open source or free software license does not apply to you
+ * or the entity you represent. Regardless of the purpose, you should not
+ * use the software in any way whatsoever, including but not limited to
+ * downloading, viewing, copying, distributing, compiling, and running.
+ * If you have already downloaded it, you MUST destroy all of its copies.
+ * 
+ * The Exception List is published by FMSoft and may be updated
+ * from time to time. For more information, please see
+ * <https://www.fmsoft.cn/exception-list>.
+ */ 
+
+#include "config.h"
+#include "LsqlDatabasePool.h"
+
+#if ENABLE(LSQL)
+
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <wtf/NumberOfCores.h>
+
+namespace PurCFetcher {
+
+#define PURC_ENVV_FETCHER_LSQL_MAX_HANDLES "PURC_FETCHER_LSQL_MAX_HANDLES"
+#define PURC_ENVV_FETCHER_LSQL_IDLE_TIMEOUT "PURC_FETCHER_LSQL_IDLE_TIMEOUT"
+#define PURC_ENVV_FETCHER_LSQL_MAX_STATEMENTS "PURC_FETCHER_LSQL_MAX_STATEMENTS"
+#define PURC_ENVV_FETCHER_LSQL_READERS "PURC_FETCHER_LSQL_READERS"
+#define PURC_ENVV_FETCHER_LSQL_WRITERS "PURC_FETCHER_LSQL_WRITERS"
+#define PURC_ENVV_FETCHER_LSQL_QUERY_TIMEOUT "PURC_FETCHER_LSQL_QUERY_TIMEOUT"
+
+// the instructions of a statement between two checks of its deadline
+static const int progressHandlerPeriod = 10000;
+
+LsqlDatabase::LsqlDatabase(const String& path, size_t maxStatements)
+    : m_path(path.isolatedCopy())
+    , m_maxStatements(maxStatements)
+{
+}
+
+LsqlDatabase::~LsqlDatabase()
+{
+    // finalized before the database is closed
+    m_statements.clear();
+    if (m_database.isOpen())
+        m_database.close();
+}
+
+std::unique_ptr<SQLiteStatement> LsqlDatabase::takeStatement(const String& query)
+{
+    for (size_t i = m_statements.size(); i--;) {
+        if (m_statements[i]->query() != query)
+            continue;
+        auto statement = WTFMove(m_statements[i]);
+        m_statements.remove(i);
+        return statement;
+    }
+    return nullptr;
+}
+
+void LsqlDatabase::giveBackStatement(std::unique_ptr<SQLiteStatement>&& statement)
+{
+    if (!m_maxStatements)
+        return;
+
+    // the bindings go too
+    statement->reset();
+    m_statements.append(WTFMove(statement));
+    if (m_statements.size() > m_maxStatements)
+        m_statements.remove(0);
+}
+
+void LsqlDatabase::setInterruption(MonotonicTime deadline, const std::atomic<bool>* canceled)
+{
+    m_deadline = deadline;
+    m_canceled = canceled;
+    m_timedOut = false;
+}
+
+int LsqlDatabase::progressHandler(void* context)
+{
+    auto* database = static_cast<LsqlDatabase*>(context);
+    if (database->m_canceled && *database->m_canceled)
+        return 1;
+    if (MonotonicTime::now() >= database->m_deadline) {
+        database->m_timedOut = true;
+        return 1;
+    }
+    return 0;
+}
+
+LsqlStatement::LsqlStatement(LsqlDatabase& database, const String& query)
+    : m_database(database)
+    // kept by the cache of the database, used on other threads
+    , m_query(query.isolatedCopy())
+    , m_statement(database.takeStatement(query))
+    , m_isPrepared(!!m_statement)
+{
+}
+
+LsqlStatement::~LsqlStatement()
+{
+    if (m_isPrepared)
+        m_database->giveBackStatement(WTFMove(m_statement));
+}
+
+int LsqlStatement::prepare()
+{
+    if (m_isPrepared)
+        return SQLITE_OK;
+
+    m_statement = makeUnique<SQLiteStatement>(m_database->database(), m_query);
+    int error = m_statement->prepare();
+    m_isPrepared = error == SQLITE_OK;
+    return error;
+}
+
+bool LsqlDatabase::FileIdentity::operator==(const FileIdentity& other) const
+{
+    return device == other.device
+        && inode == other.inode
+        && modificationTime == other.modificationTime
+        && modificationTimeNanoseconds == other.modificationTimeNanoseconds
+        && size == other.size;
+}
+
+bool LsqlDatabase::fileIdentity(const String& path, FileIdentity& identity)
+{
+    struct stat info;
+    if (stat(path.utf8().data(), &info) < 0)
+        return false;
+
+    identity.device = info.st_dev;
+    identity.inode = info.st_ino;
+    identity.modificationTime = info.st_mtime;
+#if OS(DARWIN)
+    identity.modificationTimeNanoseconds = info.st_mtimespec.tv_nsec;
+#else
+    identity.modificationTimeNanoseconds = info.st_mtim.tv_nsec;
+#endif
+    identity.size = info.st_size;
+    return true;
+}
+
+LsqlDatabasePool& LsqlDatabasePool::singleton()
+{
+    static NeverDestroyed<LsqlDatabasePool> pool;
+    return pool;
+}
+
+LsqlDatabasePool::LsqlDatabasePool()
+    : m_evictionTimer(RunLoop::main(), this, &LsqlDatabasePool::evictionTimerFired)
+{
+    if (const char* maxHandles = getenv(PURC_ENVV_FETCHER_LSQL_MAX_HANDLES)) {
+        int value = atoi(maxHandles);
+        if (value >= 0)
+            m_maxHandles = value;
+    }
+
+    if (const char* timeout = getenv(PURC_ENVV_FETCHER_LSQL_IDLE_TIMEOUT)) {
+        double value = atof(timeout);
+        if (value >= 0)
+            m_idleTimeout = Seconds(value);
+    }
+
+    if (const char* maxStatements = getenv(PURC_ENVV_FETCHER_LSQL_MAX_STATEMENTS)) {
+        int value = atoi(maxStatements);
+        if (value >= 0)
+            m_maxStatements = value;
+    }
+}
+
+RefPtr<LsqlDatabase> LsqlDatabasePool::take(const String& path)
+{
+    LsqlDatabase::FileIdentity identity;
+    if (!LsqlDatabase::fileIdentity(path, identity))
+        return nullptr;
+
+    // the ones replaced are closed out of the lock
+    Vector<Ref<LsqlDatabase>> staleDatabases;
+    {
+        auto locker = holdLock(m_lock);
+        // the most recently used first, its pages are the most likely cached
+        for (size_t i = m_idleDatabases.size(); i--;) {
+            if (m_idleDatabases[i]->path() != path)
+                continue;
+
+            Ref<LsqlDatabase> database = m_idleDatabases[i].copyRef();
+            m_idleDatabases.remove(i);
+            if (database->m_identity == identity)
+                return database;
+            // replaced or written by someone else: its caches may be stale
+            staleDatabases.append(WTFMove(database));
+        }
+    }
+
+    auto database = LsqlDatabase::create(path, m_maxStatements);
+    if (!database->m_database.open(path))
+        return nullptr;
+    // used on the thread of any queue, one at a time
+    database->m_database.disableThreadingChecks();
+    sqlite3_progress_handler(database->m_database.sqlite3Handle(), progressHandlerPeriod, LsqlDatabase::progressHandler, database.ptr());
+    database->m_identity = identity;
+    return database;
+}
+
+void LsqlDatabasePool::giveBack(Ref<LsqlDatabase>&& database)
+{
+    // the flag is the one of the request
+    database->setInterruption(MonotonicTime::infinity(), nullptr);
+
+    // a transaction left open would be seen by the next request
+    if (!m_maxHandles || !m_idleTimeout || !database->m_database.isAutoCommitOn())
+        return;
+
+    // the writes of the request are not a change of the file
+    if (!LsqlDatabase::fileIdentity(database->path(), database->m_identity))
+        return;
+
+    database->m_lastUsedTime = MonotonicTime::now();
+    RefPtr<LsqlDatabase> evictedDatabase;
+    {
+        auto locker = holdLock(m_lock);
+        m_idleDatabases.append(WTFMove(database));
+        if (m_idleDatabases.size() > m_maxHandles) {
+            evictedDatabase = m_idleDatabases.first().copyRef();
+            m_idleDatabases.remove(0);
+        }
+    }
+
+    if (RunLoop::isMain()) {
+        scheduleEviction();
+        return;
+    }
+    RunLoop::main().dispatch([this] {
+        scheduleEviction();
+    });
+}
+
+void LsqlDatabasePool::clear()
+{
+    ASSERT(RunLoop::isMain());
+
+    m_evictionTimer.stop();
+    Vector<Ref<LsqlDatabase>> databases;
+    {
+        auto locker = holdLock(m_lock);
+        databases = WTFMove(m_idleDatabases);
+    }
+}
+
+void LsqlDatabasePool::scheduleEviction()
+{
+    ASSERT(RunLoop::isMain());
+
+    auto locker = holdLock(m_lock);
+    if (m_idleDatabases.isEmpty() || m_evictionTimer.isActive())
+        return;
+
+    Seconds idleTime = MonotonicTime::now() - m_idleDatabases.first()->m_lastUsedTime;
+    m_evictionTimer.startOneShot(std::max(m_idleTimeout - idleTime, 0_s));
+}
+
+void LsqlDatabasePool::evictionTimerFired()
+{
+    Vector<Ref<LsqlDatabase>> expiredDatabases;
+    {
+        auto locker = holdLock(m_lock);
+        MonotonicTime now = MonotonicTime::now();
+        size_t expired = 0;
+        while (expired < m_idleDatabases.size()
+            && now - m_idleDatabases[expired]->m_lastUsedTime >= m_idleTimeout)
+            expired++;
+        for (size_t i = 0; i < expired; i++)
+            expiredDatabases.append(m_idleDatabases[i].copyRef());
+        m_idleDatabases.remove(0, expired);
+    }
+    expiredDatabases.clear();
+
+    scheduleEviction();
+}
+
+LsqlWorkQueuePool::Queue::Queue(const char* name)
+    : m_workQueue(WorkQueue::create(name))
+{
+}
+
+void LsqlWorkQueuePool::Queue::dispatch(Function<void()>&& function)
+{
+    m_pendingCount++;
+    m_workQueue->dispatch([this, protectedThis = makeRef(*this), function = WTFMove(function)] {
+        function();
+        m_pendingCount--;
+    });
+}
+
+LsqlWorkQueuePool& LsqlWorkQueuePool::singleton()
+{
+    static NeverDestroyed<LsqlWorkQueuePool> pool;
+    return pool;
+}
+
+LsqlWorkQueuePool::LsqlWorkQueuePool()
+    : m_maxReaders(std::min(WTF::numberOfProcessorCores(), 4))
+{
+    if (const char* readers = getenv(PURC_ENVV_FETCHER_LSQL_READERS)) {
+        int value = atoi(readers);
+        if (value > 0)
+            m_maxReaders = value;
+    }
+
+    if (const char* writers = getenv(PURC_ENVV_FETCHER_LSQL_WRITERS)) {
+        int value = atoi(writers);
+        if (value > 0)
+            m_maxWriters = value;
+    }
+
+    if (const char* timeout = getenv(PURC_ENVV_FETCHER_LSQL_QUERY_TIMEOUT)) {
+        double value = atof(timeout);
+        if (value >= 0)
+            m_queryTimeout = Seconds(value);
+    }
+
+    m_writeQueues.grow(m_maxWriters);
+}
+
+LsqlWorkQueuePool::Queue& LsqlWorkQueuePool::queue(const String& path, bool writes)
+{
+    ASSERT(RunLoop::isMain());
+
+    if (writes) {
+        auto& queue = m_writeQueues[path.hash() % m_maxWriters];
+        if (!queue)
+            queue = Queue::create("PurCFetcher.Lsql.Writer");
+        return *queue;
+    }
+
+    Queue* leastBusy = nullptr;
+    for (auto& queue : m_readQueues) {
+        if (!leastBusy || queue->pendingCount() < leastBusy->pendingCount())
+            leastBusy = queue.ptr();
+    }
+    if (leastBusy && (!leastBusy->pendingCount() || m_readQueues.size() == m_maxReaders))
+        return *leastBusy;
+
+    m_readQueues.append(Queue::create("PurCFetcher.Lsql.Reader"));
+    return m_readQueues.last();
+}
+
+MonotonicTime LsqlWorkQueuePool::queryDeadline() const
+{
+    if (!m_queryTimeout)
+        return MonotonicTime::infinity();
+    return MonotonicTime::now() + m_queryTimeout;
+}
+
+} // namespace PurCFetcher
+
+#endif // ENABLE(LSQL)
@@ -0,0 +1,245 @@
+/* 
+ * Copyright (C) 2020 Beijing FMSoft Technologies Co., Ltd.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ * 
+ * Or,
+ * 
+ * As this component is a program released under LGPLv3, which claims
+ * explicitly that the program could be modified by any end user
+ * even if the program is conveyed in non-source form on the system it runs.
+ * Generally, if you distribute this program in embedded devices,
+ * you might not satisfy this condition. Under this situation or you can
+ * not accept any condition of LGPLv3, you need to get a commercial license
+ * from FMSoft, along with a patent license for the patents owned by FMSoft.
+ * 
+ * If you have got a commercial/patent license of this program, please use it
+ * under the terms and conditions of the commercial license.
+ * 
+ * For more information about the commercial license and patent license,
+ * please refer to
+ * <https://hybridos.fmsoft.cn/blog/hybridos-licensing-policy/>.
+ * 
+ * Also note that the LGPLv3 license does not apply to any entity in the
+ * Exception List published by Beijing FMSoft Technologies Co., Ltd.
+ * 
+ * If you are or the entity you represent is listed in the Exception List,
+ * the above open source or free software license does not apply to you
+ * or the entity you represent. Regardless of the purpose, you should not
+ * use the software in any way whatsoever, including but not limited to
+ * downloading, viewing, copying, distributing, compiling, and running.
+ * If you have already downloaded it, you MUST destroy all of its copies.
+ * 
+ * The Exception List is published by FMSoft and may be updated
+ * from time to time. For more information, please see
+ * <https://www.fmsoft.cn/exception-list>.
+ */ 
+
+#pragma once
+
+#if ENABLE(LSQL)
+
+#include "SQLiteDatabase.h"
+#include "SQLiteStatement.h"
+#include <atomic>
+#include <sys/types.h>
+#include <wtf/Lock.h>
+#include <wtf/MonotonicTime.h>
+#include <wtf/NeverDestroyed.h>
+#include <wtf/RunLoop.h>
+#include <wtf/ThreadSafeRefCounted.h>
+#include <wtf/Vector.h>
+#include <wtf/WorkQueue.h>
+#include <wtf/text/WTFString.h>
+
+namespace PurCFetcher {
+
+// An open lsql database, used by one request at a time, on the thread of
+// the queue the request runs on. It goes back to LsqlDatabasePool when the
+// request is done with it, still open, with the schema and the page cache
+// of SQLite, and the statements prepared last.
+class LsqlDatabase : public ThreadSafeRefCounted<LsqlDatabase> {
+public:
+    static Ref<LsqlDatabase> create(const String& path, size_t maxStatements)
+    {
+        return adoptRef(*new LsqlDatabase(path, maxStatements));
+    }
+
+    ~LsqlDatabase();
+
+    const String& path() const { return m_path; }
+    SQLiteDatabase& database() { return m_database; }
+
+    // The statement of the query, prepared and with no bindings, if it ran
+    // lately; null otherwise. It is not in the cache until given back.
+    std::unique_ptr<SQLiteStatement> takeStatement(const String& query);
+
+    // Resets the statement and keeps it, the least recently used is
+    // finalized when there are more than maxStatements.
+    void giveBackStatement(std::unique_ptr<SQLiteStatement>&&);
+
+    // The statements run from now on are stopped with SQLITE_INTERRUPT at
+    // the deadline, or once *canceled is set.
+    void setInterruption(MonotonicTime deadline, const std::atomic<bool>* canceled);
+    // the last statement stopped was stopped by the deadline
+    bool timedOut() const { return m_timedOut; }
+
+private:
+    friend class LsqlDatabasePool;
+
+    LsqlDatabase(const String& path, size_t maxStatements);
+
+    // called by SQLite every progressHandlerPeriod instructions
+    static int progressHandler(void*);
+
+    // What tells the file apart from the one opened: it was not replaced
+    // or written by someone else since.
+    struct FileIdentity {
+        dev_t device { 0 };
+        ino_t inode { 0 };
+        time_t modificationTime { 0 };
+        long modificationTimeNanoseconds { 0 };
+        off_t size { 0 };
+
+        bool operator==(const FileIdentity&) const;
+        bool operator!=(const FileIdentity& other) const { return !(*this == other); }
+    };
+    static bool fileIdentity(const String& path, FileIdentity&);
+
+    String m_path;
+    SQLiteDatabase m_database;
+    FileIdentity m_identity;
+    MonotonicTime m_lastUsedTime;
+
+    MonotonicTime m_deadline { MonotonicTime::infinity() };
+    const std::atomic<bool>* m_canceled { nullptr };
+    bool m_timedOut { false };
+
+    // the least recently used first
+    Vector<std::unique_ptr<SQLiteStatement>> m_statements;
+    size_t m_maxStatements;
+};
+
+// A statement run by a request, taken from the cache of the database and
+// given back to it when done.
+class LsqlStatement {
+    WTF_MAKE_NONCOPYABLE(LsqlStatement);
+    WTF_MAKE_FAST_ALLOCATED;
+public:
+    LsqlStatement(LsqlDatabase&, const String& query);
+    ~LsqlStatement();
+
+    // SQLITE_OK at once for a statement from the cache.
+    int prepare();
+
+    SQLiteStatement& operator*() { return *m_statement; }
+    SQLiteStatement* operator->() { return m_statement.get(); }
+
+private:
+    Ref<LsqlDatabase> m_database;
+    String m_query;
+    std::unique_ptr<SQLiteStatement> m_statement;
+    bool m_isPrepared { false };
+};
+
+// The lsql databases left open between the requests, keyed by the path.
+// Used from the queues of LsqlWorkQueuePool, the eviction runs on the main
+// thread.
+// At most PURC_FETCHER_LSQL_MAX_HANDLES (16 by default) are kept, the
+// least recently used is closed first, and a database is closed once
+// unused for PURC_FETCHER_LSQL_IDLE_TIMEOUT seconds (60 by default); 0
+// keeps none. A database whose file was replaced or written by another
+// process since is opened again. Each keeps the last
+// PURC_FETCHER_LSQL_MAX_STATEMENTS (32 by default) statements prepared.
+class LsqlDatabasePool {
+    WTF_MAKE_NONCOPYABLE(LsqlDatabasePool);
+public:
+    static LsqlDatabasePool& singleton();
+
+    // An open database for the path, null if it cannot be opened.
+    RefPtr<LsqlDatabase> take(const String& path);
+
+    // The request is done with the database.
+    void giveBack(Ref<LsqlDatabase>&&);
+
+    // Closes all the databases kept. On the main thread.
+    void clear();
+
+private:
+    friend class NeverDestroyed<LsqlDatabasePool>;
+    LsqlDatabasePool();
+
+    void evictionTimerFired();
+    void scheduleEviction();
+
+    size_t m_maxHandles { 16 };
+    size_t m_maxStatements { 32 };
+    Seconds m_idleTimeout { 60_s };
+
+    Lock m_lock;
+    // the least recently used first
+    Vector<Ref<LsqlDatabase>> m_idleDatabases;
+    RunLoop::Timer<LsqlDatabasePool> m_evictionTimer;
+};
+
+// The threads the lsql queries run on, so that a long query does not hold
+// the main thread. A query that writes runs on the writer queue of its
+// path, the same for all its requests, so the writes to a file are done
+// one after the other; a query that only reads runs on the least busy of
+// the reader queues, next to the writes as the databases are in WAL mode.
+// PURC_FETCHER_LSQL_READERS (4 at most by default) and
+// PURC_FETCHER_LSQL_WRITERS (2 by default) set the number of queues, and a
+// statement running for more than PURC_FETCHER_LSQL_QUERY_TIMEOUT seconds
+// (30 by default, 0 for none) is stopped.
+class LsqlWorkQueuePool {
+    WTF_MAKE_NONCOPYABLE(LsqlWorkQueuePool);
+public:
+    class Queue : public ThreadSafeRefCounted<Queue> {
+    public:
+        static Ref<Queue> create(const char* name) { return adoptRef(*new Queue(name)); }
+
+        void dispatch(Function<void()>&&);
+        unsigned pendingCount() const { return m_pendingCount; }
+
+    private:
+        explicit Queue(const char* name);
+
+        Ref<WorkQueue> m_workQueue;
+        std::atomic<unsigned> m_pendingCount { 0 };
+    };
+
+    static LsqlWorkQueuePool& singleton();
+
+    // The queue for a query on the database at path. On the main thread.
+    Queue& queue(const String& path, bool writes);
+
+    // The deadline of a statement started now.
+    MonotonicTime queryDeadline() const;
+
+private:
+    friend class NeverDestroyed<LsqlWorkQueuePool>;
+    LsqlWorkQueuePool();
+
+    size_t m_maxReaders;
+    size_t m_maxWriters { 2 };
+    Seconds m_queryTimeout { 30_s };
+
+    // created as they are needed
+    Vector<Ref<Queue>> m_readQueues;
+    Vector<RefPtr<Queue>> m_writeQueues;
+};
+
+} // namespace PurCFetcher
+
+#endif // ENABLE(LSQL)
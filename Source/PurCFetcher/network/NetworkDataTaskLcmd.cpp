@@ -68,8 +68,15 @@
 #include "NetworkStorageSession.h"
 #include "SharedBuffer.h"
 #include "TextEncoding.h"
+#include <wtf/Deque.h>
 #include <wtf/MainThread.h>
+#include <wtf/NeverDestroyed.h>
+#include <wtf/NumberOfCores.h>
+#include <wtf/glib/GUniquePtr.h>
 #include <wtf/glib/RunLoopSourcePriority.h>
+#include <gio/gio.h>
+#include <signal.h>
+#include <stdlib.h>
 #include <sys/types.h>
 #include <unistd.h>
 
@@ -77,7 +84,8 @@
 namespace PurCFetcher {
 using namespace PurCFetcher;
 
-#define  DEFAULT_READBUFFER_SIZE 8192
+#define PURC_ENVV_FETCHER_LCMD_MAX_JOBS "PURC_FETCHER_LCMD_MAX_JOBS"
+#define PURC_ENVV_FETCHER_LCMD_TIMEOUT "PURC_FETCHER_LCMD_TIMEOUT"
 
 const char* KEY_STATUS_CODE = "statusCode";
 const char* KEY_ERROR_MSG = "errorMsg";
@@ -86,6 +94,73 @@ const char* KEY_LINES = "lines";
 
 const char* CMD_FILTER = "cmdfilter";
 const char* CMD_LINE = "cmdline";
+const char* CMD_FORMAT = "format";
+const char* FORMAT_NDJSON = "ndjson";
+const char* CMD_SHELL = "shell";
+
+// Starts the lcmd commands in turn, at most PURC_FETCHER_LCMD_MAX_JOBS
+// (the number of CPU cores by default) at the same time. A command is
+// killed after the timeout of its request, or PURC_FETCHER_LCMD_TIMEOUT
+// seconds if the request has none; 0 means no limit.
+class LcmdJobQueue {
+    WTF_MAKE_NONCOPYABLE(LcmdJobQueue);
+public:
+    static LcmdJobQueue& singleton()
+    {
+        static NeverDestroyed<LcmdJobQueue> queue;
+        return queue;
+    }
+
+    Seconds defaultTimeout() const { return m_defaultTimeout; }
+
+    void schedule(NetworkDataTaskLcmd& task)
+    {
+        ASSERT(RunLoop::isMain());
+        if (m_runningJobs >= m_maxJobs) {
+            m_pendingJobs.append(task);
+            return;
+        }
+
+        m_runningJobs++;
+        task.startCommand();
+    }
+
+    void jobFinished()
+    {
+        ASSERT(RunLoop::isMain());
+        ASSERT(m_runningJobs);
+        m_runningJobs--;
+
+        while (!m_pendingJobs.isEmpty() && m_runningJobs < m_maxJobs) {
+            auto task = m_pendingJobs.takeFirst();
+            m_runningJobs++;
+            task->startCommand();
+        }
+    }
+
+private:
+    friend class NeverDestroyed<LcmdJobQueue>;
+    LcmdJobQueue()
+        : m_maxJobs(std::max(WTF::numberOfProcessorCores(), 1))
+    {
+        if (const char* maxJobs = getenv(PURC_ENVV_FETCHER_LCMD_MAX_JOBS)) {
+            int value = atoi(maxJobs);
+            if (value > 0)
+                m_maxJobs = value;
+        }
+
+        if (const char* timeout = getenv(PURC_ENVV_FETCHER_LCMD_TIMEOUT)) {
+            double value = atof(timeout);
+            if (value > 0)
+                m_defaultTimeout = Seconds(value);
+        }
+    }
+
+    size_t m_maxJobs;
+    size_t m_runningJobs { 0 };
+    Seconds m_defaultTimeout;
+    Deque<Ref<NetworkDataTaskLcmd>> m_pendingJobs;
+};
 
 String decodeEscapeSequencesFromParsedURL(StringView input)
 {
@@ -110,7 +185,7 @@ String decodeEscapeSequencesFromParsedURL(StringView input)
 
 NetworkDataTaskLcmd::NetworkDataTaskLcmd(NetworkSession& session, NetworkDataTaskClient& client, const ResourceRequest& requestWithCredentials, StoredCredentialsPolicy storedCredentialsPolicy, ContentSniffingPolicy shouldContentSniff, PurCFetcher::ContentEncodingSniffingPolicy, bool shouldClearReferrerOnHTTPSToHTTPRedirect, bool dataTaskIsForMainFrameNavigation)
     : NetworkDataTask(session, client, requestWithCredentials, storedCredentialsPolicy, shouldClearReferrerOnHTTPSToHTTPRedirect, dataTaskIsForMainFrameNavigation)
-    , m_filterManager(adoptRef(*new CmdFilterManager()))
+    , m_timeoutTimer(RunLoop::main(), this, &NetworkDataTaskLcmd::timeoutTimerFired)
 {
     UNUSED_PARAM(shouldContentSniff);
     m_session->registerNetworkDataTask(*this);
@@ -146,6 +221,7 @@ void NetworkDataTaskLcmd::cancel()
         return;
 
     m_state = State::Canceling;
+    killCommand();
 }
 
 void NetworkDataTaskLcmd::resume()
@@ -166,6 +242,7 @@ void NetworkDataTaskLcmd::resume()
 
 void NetworkDataTaskLcmd::invalidateAndCancel()
 {
+    cancel();
 }
 
 NetworkDataTask::State NetworkDataTaskLcmd::state() const
@@ -188,7 +265,7 @@ void NetworkDataTaskLcmd::dispatchDidReceiveResponse()
     const char* contentType = "application/json";
     m_response.setMimeType(extractMIMETypeFromMediaType(contentType));
     m_response.setTextEncodingName(extractCharsetFromMediaType(contentType));
-    m_response.setExpectedContentLength(m_responseBuffer.size());
+    m_response.setExpectedContentLength(m_responseBuffer->size());
     m_response.setHTTPHeaderField(HTTPHeaderName::AccessControlAllowOrigin, "*");
     m_response.setHTTPHeaderField(HTTPHeaderName::Expires, "-1");
     m_response.setHTTPHeaderField(HTTPHeaderName::CacheControl, "no-cache");
@@ -203,7 +280,7 @@ void NetworkDataTaskLcmd::dispatchDidReceiveResponse()
         switch (policyAction) {
         case PolicyAction::Use:
             {
-                m_client->didReceiveData(SharedBuffer::create(WTFMove(m_responseBuffer)));
+                m_client->didReceiveData(m_responseBuffer.releaseNonNull());
                 dispatchDidCompleteWithError({ });
             }
             break;
@@ -225,142 +302,435 @@ void NetworkDataTaskLcmd::createRequest(PurCFetcher::ResourceRequest&& request)
 void NetworkDataTaskLcmd::sendRequest()
 {
     runCmdInner();
-    buildResponse();
-    dispatchDidReceiveResponse();
+    LcmdJobQueue::singleton().schedule(*this);
 }
 
-void NetworkDataTaskLcmd::runCmdInner()
+// The commands run with -c instead of a tokenized command line.
+static bool isShell(const String& name)
 {
-    m_readBuffer.clear();
-	char data[DEFAULT_READBUFFER_SIZE] = {'0'};
+    static const char* const shells[] = { "sh", "bash", "dash", "zsh", "ksh", "mksh", "ash", "csh", "tcsh", "fish" };
+    for (auto* shell : shells) {
+        if (name == shell)
+            return true;
+    }
+    return false;
+}
 
-    String cmdLine;
+void NetworkDataTaskLcmd::runCmdInner()
+{
     if (m_currentRequest.url().hasQuery())
     {
         parseQueryString(m_currentRequest.url().query().toString());
-        if (!m_cmdFilter.isEmpty())
-        {
-            parseCmdFilter(m_cmdFilter);
-        }
-
-        if (!m_cmdLine.isEmpty())
-        {
-            cmdLine = parseCmdLine(m_cmdLine);
-        }
-
     }
 
-#if 0
-    if (m_currentRequest.url().hasFragment())
-        printf("......................Fragment=%s\n", m_currentRequest.url().fragmentIdentifier().utf8().data());
-#endif
-
+    // compiled once for all the requests with the same filters
+    m_filterPipeline = makeUnique<CmdFilterPipeline>(CmdFilterManager::planFor(m_cmdFilter).get(),
+        m_streamsNDJSON ? CmdFilterPipeline::RecordLayout::Lines : CmdFilterPipeline::RecordLayout::Array);
 
     String path = m_currentRequest.url().path().toString().stripWhiteSpace();
-    const char* command;
-    if (cmdLine.isEmpty())
+    m_argv.clear();
+
+    size_t rfindResult = path.reverseFind("/");
+    String name = (rfindResult == notFound) ? path : path.substring(rfindResult + 1);
+
+    if (isShell(name))
     {
-        command = (const char*)path.characters8();
+        // the shell is the command, run it directly with -c
+        m_argv.append(path.utf8());
+        if (!m_cmdLine.isEmpty())
+        {
+            m_argv.append("-c");
+            m_argv.append(parseCmdLine(m_cmdLine).utf8());
+        }
+        return;
     }
-    else
+
+    if (m_usesShell)
     {
+        // the command line as popen() would run it
         StringBuilder sb;
         sb.append(path);
-        if (path.endsWith("sh"))
-        {
-            sb.append(" -c \"");
-            sb.append(cmdLine);
-            sb.append(" \"");
-        }
-        else
+        String cmdLine = parseCmdLine(m_cmdLine);
+        if (!cmdLine.isEmpty())
         {
             sb.append(" ");
-
-            size_t rfindResult = path.reverseFind("/");
-            String prefix = (rfindResult == notFound) ? path + " ": path.substring(rfindResult + 1) + " ";
+            String prefix = name + " ";
             if (cmdLine.startsWith(prefix))
-            {
                 sb.append(cmdLine.substring(prefix.length()));
+            else
+                sb.append(cmdLine);
+        }
+        m_argv.append("/bin/sh");
+        m_argv.append("-c");
+        m_argv.append(sb.toString().utf8());
+        return;
+    }
+
+    // no shell: each argument has its parameters substituted on its own,
+    // so a value with spaces or quotes stays one argument
+    Vector<String> args = tokenizeCmdLine(m_cmdLine);
+    if (!args.isEmpty() && (args[0] == name || args[0] == path))
+        args.remove(0);
+
+    m_argv.append(path.utf8());
+    for (auto& arg : args)
+        m_argv.append(arg.utf8());
+}
+
+Vector<String> NetworkDataTaskLcmd::tokenizeCmdLine(const String& cmdLine)
+{
+    Vector<String> args;
+    StringBuilder arg;
+    StringBuilder segment;
+    bool inArg = false;
+    UChar quote = 0;
+
+    // the text outside single quotes gets the $param substitution
+    auto flushSegment = [&] {
+        if (segment.isEmpty())
+            return;
+        arg.append(quote == '\'' ? segment.toString() : parseCmdLine(segment.toString()));
+        segment.clear();
+    };
+
+    unsigned length = cmdLine.length();
+    for (unsigned i = 0; i < length; i++)
+    {
+        UChar c = cmdLine[i];
+        if (quote)
+        {
+            if (c == quote)
+            {
+                flushSegment();
+                quote = 0;
             }
+            else if (c == '\\' && quote == '"' && i + 1 < length
+                    && (cmdLine[i + 1] == '"' || cmdLine[i + 1] == '\\'))
+                segment.append(cmdLine[++i]);
             else
+                segment.append(c);
+            continue;
+        }
+
+        if (isASCIISpace(c))
+        {
+            if (inArg)
             {
-                sb.append(cmdLine);
+                flushSegment();
+                args.append(arg.toString());
+                arg.clear();
+                inArg = false;
             }
+            continue;
         }
-        const CString& tmp = sb.toString().utf8();
-        command = (const char*)tmp.data();
+
+        inArg = true;
+        if (c == '\'' || c == '"')
+        {
+            flushSegment();
+            quote = c;
+        }
+        else if (c == '\\' && i + 1 < length)
+            segment.append(cmdLine[++i]);
+        else
+            segment.append(c);
+    }
+
+    if (inArg)
+    {
+        flushSegment();
+        args.append(arg.toString());
     }
+    return args;
+}
 
-	FILE* fp = popen(command, "r");
-	if (fp == NULL)
-	{
-        m_statusCode = 500;
-        m_errorMsg = String(strerror(errno));
+void NetworkDataTaskLcmd::startCommand()
+{
+    if (m_state == State::Canceling || m_state == State::Completed) {
+        LcmdJobQueue::singleton().jobFinished();
         return;
-	}
-	while (fgets(data, sizeof(data), fp) != NULL)
-	{
-        m_readBuffer.append(data, strlen(data));
-        if (m_state == State::Canceling)
-        {
-            m_statusCode = 503;
-            m_errorMsg = String(strerror(errno));
+    }
+
+    Vector<const char*> argv;
+    for (auto& arg : m_argv)
+        argv.append(arg.data());
+    argv.append(nullptr);
+
+    // GSubprocess uses posix_spawn() when it can
+    GUniqueOutPtr<GError> error;
+    m_process = adoptGRef(g_subprocess_newv(argv.data(), G_SUBPROCESS_FLAGS_STDOUT_PIPE, &error.outPtr()));
+    if (!m_process) {
+        LcmdJobQueue::singleton().jobFinished();
+        if (g_error_matches(error.get(), G_SPAWN_ERROR, G_SPAWN_ERROR_NOENT)) {
+            // as the shell would have reported it
+            m_statusCode = 404;
+            m_exitCode = 127;
+            m_errorMsg = "Not Found";
+        } else {
+            m_statusCode = 500;
+            m_errorMsg = String::fromUTF8(error->message);
+        }
+        if (m_streamsNDJSON) {
+            dispatchNDJSONResponse();
+            finishNDJSON();
             return;
         }
-	}
+        buildResponse();
+        dispatchDidReceiveResponse();
+        return;
+    }
 
-    m_readLines = String(m_readBuffer.data(),m_readBuffer.size()).split("\n");
+    if (m_streamsNDJSON)
+        dispatchNDJSONResponse();
 
-	int status = pclose(fp);
-    m_exitCode = WEXITSTATUS(status);
-    if (m_exitCode == 127)
-    {
-        m_statusCode = 404;
-        m_errorMsg = "Not Found";
+    Seconds timeout = m_currentRequest.timeoutInterval() > 0 ? Seconds(m_currentRequest.timeoutInterval()) : LcmdJobQueue::singleton().defaultTimeout();
+    if (timeout)
+        m_timeoutTimer.startOneShot(timeout);
+
+    m_cancellable = adoptGRef(g_cancellable_new());
+    m_inputStream = g_subprocess_get_stdout_pipe(m_process.get());
+    readOutput();
+
+    RefPtr<NetworkDataTaskLcmd> protectedThis(this);
+    g_subprocess_wait_async(m_process.get(), nullptr,
+        reinterpret_cast<GAsyncReadyCallback>(waitCallback), protectedThis.leakRef());
+}
+
+void NetworkDataTaskLcmd::killCommand()
+{
+    if (!m_process)
+        return;
+
+    if (!m_exited)
+        g_subprocess_force_exit(m_process.get());
+    // The children of the command may keep the pipe open, even once it has
+    // exited, as a daemon does.
+    if (!m_outputFinished)
+        g_cancellable_cancel(m_cancellable.get());
+}
+
+void NetworkDataTaskLcmd::stopCommand()
+{
+    // As a shell pipeline ending with head does: the rest of the output is
+    // not read, and the command does not run for nothing.
+    g_input_stream_close(m_inputStream.get(), nullptr, nullptr);
+    killCommand();
+}
+
+void NetworkDataTaskLcmd::readOutput()
+{
+    RefPtr<NetworkDataTaskLcmd> protectedThis(this);
+    g_input_stream_read_async(m_inputStream.get(), m_output.writableData(), m_output.writableSize(), RunLoopSourcePriority::AsyncIONetwork, m_cancellable.get(),
+        reinterpret_cast<GAsyncReadyCallback>(readCallback), protectedThis.leakRef());
+}
+
+void NetworkDataTaskLcmd::readCallback(GInputStream* inputStream, GAsyncResult* result, NetworkDataTaskLcmd* task)
+{
+    RefPtr<NetworkDataTaskLcmd> protectedThis = adoptRef(task);
+    gssize bytesRead = g_input_stream_read_finish(inputStream, result, nullptr);
+    if (bytesRead > 0)
+        task->m_output.didWrite(bytesRead);
+    if (bytesRead > 0 && task->m_state != State::Canceling) {
+        task->filterOutput(false);
+        if (!task->m_filterPipeline->isSatisfied()) {
+            task->readOutput();
+            return;
+        }
+        task->stopCommand();
     }
+
+    task->didFinishOutput();
+}
+
+void NetworkDataTaskLcmd::waitCallback(GSubprocess* process, GAsyncResult* result, NetworkDataTaskLcmd* task)
+{
+    RefPtr<NetworkDataTaskLcmd> protectedThis = adoptRef(task);
+    g_subprocess_wait_finish(process, result, nullptr);
+    task->didExit();
+}
+
+void NetworkDataTaskLcmd::didFinishOutput()
+{
+    m_inputStream = nullptr;
+    m_outputFinished = true;
+    if (m_exited)
+        didFinishCommand();
+}
+
+void NetworkDataTaskLcmd::didExit()
+{
+    m_exited = true;
+    if (g_subprocess_get_if_exited(m_process.get()))
+        m_exitCode = g_subprocess_get_exit_status(m_process.get());
     else
-    {
+        m_exitCode = 128 + g_subprocess_get_term_sig(m_process.get());
+
+    if (m_outputFinished)
+        didFinishCommand();
+}
+
+void NetworkDataTaskLcmd::timeoutTimerFired()
+{
+    m_timedOut = true;
+    killCommand();
+}
+
+void NetworkDataTaskLcmd::didFinishCommand()
+{
+    m_timeoutTimer.stop();
+    m_process = nullptr;
+    m_cancellable = nullptr;
+    LcmdJobQueue::singleton().jobFinished();
+
+    if (m_state == State::Canceling || m_state == State::Completed)
+        return;
+
+    if (m_timedOut) {
+        m_statusCode = 408;
+        m_errorMsg = "Request Timeout";
+    } else if (m_exitCode == 127) {
+        m_statusCode = 404;
+        m_errorMsg = "Not Found";
+    } else
         m_statusCode = 200;
+
+    if (m_streamsNDJSON) {
+        finishNDJSON();
+        return;
     }
+
+    filterOutput(true);
+    buildResponse();
+    dispatchDidReceiveResponse();
 }
 
 void NetworkDataTaskLcmd::runCmdOuter()
 {
 }
 
-void NetworkDataTaskLcmd::buildResponse()
+void NetworkDataTaskLcmd::writeStatus(JSONStreamWriter& writer)
 {
-    m_responseBuffer.clear();
-    auto result = JSON::Object::create();
-    result->setInteger(KEY_STATUS_CODE, m_statusCode);
+    writer.writeKey(KEY_STATUS_CODE);
+    writer.writeInteger(m_statusCode);
+    writer.writeKey(KEY_ERROR_MSG);
     if (m_errorMsg.isEmpty())
-        result->setValue(KEY_ERROR_MSG, JSON::Value::null());
+        writer.writeNull();
     else
-        result->setString(KEY_ERROR_MSG, m_errorMsg);
+        writer.writeString(m_errorMsg);
+    writer.writeKey(KEY_EXIT_CODE);
     if (m_statusCode == 200 || m_statusCode == 404)
-        result->setInteger(KEY_EXIT_CODE, m_exitCode);
+        writer.writeInteger(m_exitCode);
     else
-        result->setValue(KEY_EXIT_CODE, JSON::Value::null());
+        writer.writeNull();
+}
 
-    if (m_readLines.size())
-    {
-        auto array = JSON::Array::create();
-        Vector<Ref<JSON::Value>>  lines = m_filterManager->doFilter(m_readLines);
-        int lineSize = lines.size();
-        for (int i = 0; i < lineSize; i++)
-        {
-            array->pushValue(WTFMove(lines[i]));
+void NetworkDataTaskLcmd::buildResponse()
+{
+    m_filterPipeline->finish();
+
+    JSONStreamWriter writer;
+    writer.beginObject();
+    writeStatus(writer);
+    writer.writeKey(KEY_LINES);
+    // the records are JSON already, their segments are moved in
+    writer.writeJSON(m_filterPipeline->takeRecords());
+    writer.endObject();
+    m_responseBuffer = writer.take();
+}
+
+void NetworkDataTaskLcmd::dispatchNDJSONResponse()
+{
+    m_networkLoadMetrics.responseStart = MonotonicTime::now() - m_startTime;
+    m_response.setURL(m_currentRequest.url());
+    const char* contentType = "application/x-ndjson";
+    m_response.setMimeType(extractMIMETypeFromMediaType(contentType));
+    m_response.setTextEncodingName(extractCharsetFromMediaType(contentType));
+    m_response.setHTTPHeaderField(HTTPHeaderName::AccessControlAllowOrigin, "*");
+    m_response.setHTTPHeaderField(HTTPHeaderName::Expires, "-1");
+    m_response.setHTTPHeaderField(HTTPHeaderName::CacheControl, "no-cache");
+    m_response.setHTTPHeaderField(HTTPHeaderName::Pragma, "no-cache");
+    // the status of the command comes in the last record
+    m_response.setHTTPStatusCode(200);
+
+    m_ndjsonResponseState = NDJSONResponseState::WaitingForPolicy;
+    didReceiveResponse(ResourceResponse(m_response), NegotiatedLegacyTLS::No, [this, protectedThis = makeRef(*this)](PolicyAction policyAction) {
+        if (m_state == State::Canceling || m_state == State::Completed)
+            return;
+
+        if (policyAction != PolicyAction::Use) {
+            m_ndjsonResponseState = NDJSONResponseState::Ignored;
+            m_pendingNDJSON = nullptr;
+            killCommand();
+            return;
         }
-        result->setArray(KEY_LINES, WTFMove(array));
+
+        m_ndjsonResponseState = NDJSONResponseState::Streaming;
+        if (m_pendingNDJSON)
+            m_client->didReceiveData(m_pendingNDJSON.releaseNonNull());
+        if (m_ndjsonCompletePending)
+            dispatchDidCompleteWithError({ });
+    });
+}
+
+void NetworkDataTaskLcmd::filterOutput(bool atEnd)
+{
+    if (atEnd)
+        m_output.finish();
+    if (m_output.lineCount()) {
+        m_filterPipeline->pushLines(m_output.lines());
+        // the records and the rows held back have their own copy
+        m_output.discardLines();
     }
-    else
-    {
-        auto array = JSON::Array::create();
-        result->setArray(KEY_LINES, WTFMove(array));
+    if (atEnd)
+        m_filterPipeline->finish();
+
+    if (m_streamsNDJSON)
+        sendNDJSON(m_filterPipeline->takeRecords());
+}
+
+void NetworkDataTaskLcmd::sendNDJSON(Ref<SharedBuffer>&& buffer)
+{
+    if (buffer->isEmpty())
+        return;
+
+    switch (m_ndjsonResponseState) {
+    case NDJSONResponseState::Streaming:
+        m_client->didReceiveData(WTFMove(buffer));
+        break;
+    case NDJSONResponseState::WaitingForPolicy:
+        if (m_pendingNDJSON)
+            m_pendingNDJSON->append(buffer.get());
+        else
+            m_pendingNDJSON = WTFMove(buffer);
+        break;
+    case NDJSONResponseState::NotStarted:
+    case NDJSONResponseState::Ignored:
+        break;
     }
+}
 
-    String json = result->toJSONString();
-    m_responseBuffer.append(json.characters8(), json.length());
+void NetworkDataTaskLcmd::finishNDJSON()
+{
+    filterOutput(true);
+
+    JSONStreamWriter writer;
+    writer.beginObject();
+    writeStatus(writer);
+    writer.endObject();
+    writer.endLine();
+    sendNDJSON(writer.take());
+
+    switch (m_ndjsonResponseState) {
+    case NDJSONResponseState::Streaming:
+        dispatchDidCompleteWithError({ });
+        break;
+    case NDJSONResponseState::WaitingForPolicy:
+        m_ndjsonCompletePending = true;
+        break;
+    case NDJSONResponseState::NotStarted:
+    case NDJSONResponseState::Ignored:
+        break;
+    }
 }
 
 void NetworkDataTaskLcmd::parseQueryString(String query)
@@ -389,32 +759,14 @@ void NetworkDataTaskLcmd::parseQueryString(String query)
         }
         else
         {
-            m_paramMap.set(name, value);
-        }
-    }
-}
+            // still usable as $format in the command line
+            if (equalIgnoringASCIICase(name, CMD_FORMAT) && equalIgnoringASCIICase(value, FORMAT_NDJSON))
+                m_streamsNDJSON = true;
+            else if (equalIgnoringASCIICase(name, CMD_SHELL))
+                m_usesShell = value == "1" || equalIgnoringASCIICase(value, "true");
 
-void NetworkDataTaskLcmd::parseCmdFilter(String cmdFilter)
-{
-    if (cmdFilter.isEmpty())
-        return;
-    Vector<String> params = cmdFilter.split(";");
-    int size = params.size();
-    for (int i = 0; i < size; i++)
-    {
-        size_t index = params[i].find("(");
-        if (index == notFound)
-            index = params[i].length();
-
-        String name = params[i].substring(0, index);
-        String value = params[i].substring(index + 1);
-        if (!value.isEmpty())
-        {
-            size_t idx = value.reverseFind(")");
-            if (idx != notFound)
-                value = value.substring(0, idx);
+            m_paramMap.set(name, value);
         }
-        m_filterManager->addFilter(name, value.stripLeadingAndTrailingCharacters(isSingleQuotes));
     }
 }
 
@@ -57,9 +57,16 @@
 #include <wtf/RunLoop.h>
 #include <wtf/glib/GRefPtr.h>
 #include "CmdFilterManager.h"
+#include "LcmdOutputBuffer.h"
 
 namespace PurCFetcher {
 
+class LcmdJobQueue;
+
+// Runs the command of an lcmd URL in a child process. The output is read
+// asynchronously on the main RunLoop, so a slow command does not hold up
+// the other loads; the number of commands running at once and their
+// timeout are limited by LcmdJobQueue.
 class NetworkDataTaskLcmd final : public NetworkDataTask {
 public:
     static Ref<NetworkDataTask> create(NetworkSession& session, NetworkDataTaskClient& client, const PurCFetcher::ResourceRequest& request, PurCFetcher::StoredCredentialsPolicy storedCredentialsPolicy, PurCFetcher::ContentSniffingPolicy shouldContentSniff, PurCFetcher::ContentEncodingSniffingPolicy shouldContentEncodingSniff, bool shouldClearReferrerOnHTTPSToHTTPRedirect, bool dataTaskIsForMainFrameNavigation)
@@ -89,9 +96,33 @@ private:
     void runCmdOuter();
     void buildResponse();
 
+    friend class LcmdJobQueue;
+    void startCommand();
+    void killCommand();
+    void stopCommand();
+    void readOutput();
+    static void readCallback(GInputStream*, GAsyncResult*, NetworkDataTaskLcmd*);
+    static void waitCallback(GSubprocess*, GAsyncResult*, NetworkDataTaskLcmd*);
+    void didFinishOutput();
+    void didExit();
+    void didFinishCommand();
+    void timeoutTimerFired();
+
+    // Pushes the lines read through the filters. The command is stopped
+    // once they want no more.
+    void filterOutput(bool atEnd);
+
+    // format=ndjson: one JSON record for each filtered line, sent as soon
+    // as the line is read, then a record with the status of the command.
+    void dispatchNDJSONResponse();
+    void sendNDJSON(Ref<SharedBuffer>&&);
+    void finishNDJSON();
+    // the members of the object with the status of the command
+    void writeStatus(JSONStreamWriter&);
+
     void parseQueryString(String query);
-    void parseCmdFilter(String cmdFilter);
     String parseCmdLine(String cmdLine);
+    Vector<String> tokenizeCmdLine(const String& cmdLine);
 private:
     State m_state { State::Suspended };
     PurCFetcher::ResourceRequest m_currentRequest;
@@ -99,20 +130,36 @@ private:
 
     MonotonicTime m_startTime;
     PurCFetcher::NetworkLoadMetrics m_networkLoadMetrics;
-    Vector<char> m_readBuffer;
-    Vector<char> m_responseBuffer;
-    Vector<String> m_readLines;
+    LcmdOutputBuffer m_output;
+    RefPtr<SharedBuffer> m_responseBuffer;
 
     String m_errorMsg;
     int m_statusCode;
     int m_exitCode;
 
-    RefPtr<CmdFilterManager> m_filterManager;
+    std::unique_ptr<CmdFilterPipeline> m_filterPipeline;
 
     HashMap<String, String> m_paramMap;
 
     String m_cmdFilter;
     String m_cmdLine;
+
+    // shell=1 runs the command line with /bin/sh -c, as popen() does
+    bool m_usesShell { false };
+    Vector<CString> m_argv;
+    GRefPtr<GSubprocess> m_process;
+    GRefPtr<GInputStream> m_inputStream;
+    GRefPtr<GCancellable> m_cancellable;
+    RunLoop::Timer<NetworkDataTaskLcmd> m_timeoutTimer;
+    bool m_outputFinished { false };
+    bool m_exited { false };
+    bool m_timedOut { false };
+
+    enum class NDJSONResponseState : uint8_t { NotStarted, WaitingForPolicy, Streaming, Ignored };
+    bool m_streamsNDJSON { false };
+    NDJSONResponseState m_ndjsonResponseState { NDJSONResponseState::NotStarted };
+    RefPtr<SharedBuffer> m_pendingNDJSON;
+    bool m_ndjsonCompletePending { false };
 };
 
 } // namespace PurCFetcher
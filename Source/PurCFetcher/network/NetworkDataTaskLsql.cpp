@@ -51,6 +51,8 @@
 #if ENABLE(LSQL)
 
 #include <stdio.h>
+#include <string.h>
+#include <cmath>
 #include "NetworkDataTaskLsql.h"
 #include "FilterBase.h"
 
@@ -58,6 +60,7 @@
 #include "AuthenticationManager.h"
 #include "DataReference.h"
 #include "Download.h"
+#include "FormData.h"
 #include "NetworkLoad.h"
 #include "NetworkProcess.h"
 #include "NetworkSession.h"
@@ -73,6 +76,7 @@
 #include <sys/types.h>
 #include <unistd.h>
 #include "SQLiteStatement.h"
+#include "SQLiteTransaction.h"
 
 
 namespace PurCFetcher {
@@ -87,9 +91,13 @@ extern const char* KEY_LINES;
 const char* KEY_RESULT = "result";
 const char* KEY_ROWSAFFECTED = "rowsAffected";
 const char* KEY_ROWS = "rows";
+const char* KEY_CURSOR = "cursor";
 
 const char* CMD_SQL_QUERY = "sqlquery";
 const char* CMD_SQL_ROWFORMAT = "sqlRowFormat";
+const char* CMD_SQL_TRANSACTION = "transaction";
+const char* CMD_SQL_PAGESIZE = "pageSize";
+const char* CMD_SQL_CURSOR = "cursor";
 
 const char* FORMAT_DICT = "dict";
 const char* FORMAT_ARRAY = "array";
@@ -99,6 +107,11 @@ const char* INSERT = "insert";
 const char* UPDATE = "update";
 const char* DELETE = "delete";
 
+// the rows read before a chunk is sent, and the steps done before the
+// run loop gets back, as the skipped rows write nothing
+static const size_t rowsChunkSize = JSONStreamWriter::defaultSegmentSize;
+static const unsigned maxRowStepsPerChunk = 10000;
+
 extern String decodeEscapeSequencesFromParsedURL(StringView input);
 
 NetworkDataTaskLsql::NetworkDataTaskLsql(NetworkSession& session, NetworkDataTaskClient& client, const ResourceRequest& requestWithCredentials, StoredCredentialsPolicy storedCredentialsPolicy, ContentSniffingPolicy shouldContentSniff, PurCFetcher::ContentEncodingSniffingPolicy, bool shouldClearReferrerOnHTTPSToHTTPRedirect, bool dataTaskIsForMainFrameNavigation)
@@ -116,6 +129,7 @@ NetworkDataTaskLsql::NetworkDataTaskLsql(NetworkSession& session, NetworkDataTas
 
 NetworkDataTaskLsql::~NetworkDataTaskLsql()
 {
+    releaseRows();
     m_session->unregisterNetworkDataTask(*this);
 }
 
@@ -139,6 +153,8 @@ void NetworkDataTaskLsql::cancel()
         return;
 
     m_state = State::Canceling;
+    // stops the statement running on the queue
+    m_isCanceled = true;
 }
 
 void NetworkDataTaskLsql::resume()
@@ -172,20 +188,18 @@ void NetworkDataTaskLsql::dispatchDidCompleteWithError(const ResourceError& erro
     m_networkLoadMetrics.markComplete();
 
     m_client->didCompleteWithError(error, m_networkLoadMetrics);
-    if (m_database.isOpen())
-        m_database.close();
 }
 
 void NetworkDataTaskLsql::dispatchDidReceiveResponse()
 {
-    if (m_database.isOpen())
-        m_database.close();
     m_networkLoadMetrics.responseStart = MonotonicTime::now() - m_startTime;
     m_response.setURL(m_currentRequest.url());
     const char* contentType = "application/json";
     m_response.setMimeType(extractMIMETypeFromMediaType(contentType));
     m_response.setTextEncodingName(extractCharsetFromMediaType(contentType));
-    m_response.setExpectedContentLength(m_responseBuffer.size());
+    // the rows read as they are sent have no length yet
+    if (m_responseBuffer)
+        m_response.setExpectedContentLength(m_responseBuffer->size());
     m_response.setHTTPHeaderField(HTTPHeaderName::AccessControlAllowOrigin, "*");
     m_response.setHTTPHeaderField(HTTPHeaderName::Expires, "-1");
     m_response.setHTTPHeaderField(HTTPHeaderName::CacheControl, "no-cache");
@@ -196,13 +210,19 @@ void NetworkDataTaskLsql::dispatchDidReceiveResponse()
 
     didReceiveResponse(ResourceResponse(m_response), NegotiatedLegacyTLS::No, [this, protectedThis = makeRef(*this)](PolicyAction policyAction) {
         if (m_state == State::Canceling || m_state == State::Completed) {
+            releaseRows();
             return;
         }
 
         switch (policyAction) {
         case PolicyAction::Use:
             {
-                m_client->didReceiveData(SharedBuffer::create(WTFMove(m_responseBuffer)));
+                if (m_rowsStatement)
+                {
+                    startRows();
+                    break;
+                }
+                m_client->didReceiveData(m_responseBuffer.releaseNonNull());
                 dispatchDidCompleteWithError({ });
             }
             break;
@@ -210,6 +230,7 @@ void NetworkDataTaskLsql::dispatchDidReceiveResponse()
         case PolicyAction::Ignore:
         case PolicyAction::Download:
         case PolicyAction::StopAllLoads:
+            releaseRows();
             break;
         }
     });
@@ -223,15 +244,8 @@ void NetworkDataTaskLsql::createRequest(PurCFetcher::ResourceRequest&& request)
 
 void NetworkDataTaskLsql::sendRequest()
 {
-    runCmdInner();
-    buildResponse();
-    dispatchDidReceiveResponse();
-}
-
-void NetworkDataTaskLsql::runCmdInner()
-{
-    String path = m_currentRequest.url().path().toString().stripWhiteSpace();
-
+    // what the queue needs of the request, which stays on the main thread
+    m_path = m_currentRequest.url().path().toString().stripWhiteSpace();
     if (m_currentRequest.url().hasQuery())
     {
         parseQueryString(m_currentRequest.url().query().toString());
@@ -246,6 +260,59 @@ void NetworkDataTaskLsql::runCmdInner()
         printf("......................Fragment=%s\n", m_currentRequest.url().fragmentIdentifier().utf8().data());
 #endif
 
+    // rows in the body: the statement runs once for each of them
+    FormData* body = m_currentRequest.httpBody();
+    if (body && !body->isEmpty() && m_sqlVec.size() == 1 && isWriteStatement(m_sqlVec[0]))
+        m_bodyRows = body->flatten();
+
+    // the statements and the JSON of the response are done on the queue,
+    // the response is sent from the main thread
+    m_queue = &LsqlWorkQueuePool::singleton().queue(m_path, writesDatabase());
+    m_queue->dispatch([this, protectedThis = makeRef(*this)] () mutable {
+        runCmdInner();
+        if (!m_rowsStatement)
+        {
+            giveBackDatabase();
+            buildResponse();
+        }
+
+        RunLoop::main().dispatch([this, protectedThis = WTFMove(protectedThis)] {
+            if (m_state == State::Canceling || m_state == State::Completed)
+            {
+                releaseRows();
+                return;
+            }
+            dispatchDidReceiveResponse();
+        });
+    });
+}
+
+bool NetworkDataTaskLsql::writesDatabase() const
+{
+    for (auto& sql : m_sqlVec)
+    {
+        if (!sql.isEmpty() && !sql.startsWithIgnoringASCIICase(SELECT))
+            return true;
+    }
+    return false;
+}
+
+void NetworkDataTaskLsql::giveBackDatabase()
+{
+    if (m_database)
+        LsqlDatabasePool::singleton().giveBack(m_database.releaseNonNull());
+}
+
+void NetworkDataTaskLsql::releaseRows()
+{
+    // the statement first, it uses the database
+    m_rowsStatement = nullptr;
+    giveBackDatabase();
+}
+
+void NetworkDataTaskLsql::runCmdInner()
+{
+    const String& path = m_path;
     if (!SQLiteFileSystem::ensureDatabaseFileExists(path, false))
     {
 #if 0
@@ -257,7 +324,9 @@ void NetworkDataTaskLsql::runCmdInner()
         return;
     }
 
-    if (!m_database.open(path)) {
+    // kept open between the requests
+    m_database = LsqlDatabasePool::singleton().take(path);
+    if (!m_database) {
 #if 0
         printf("Failed to open databasePath %s.", path.utf8().data());
 #endif
@@ -266,13 +335,47 @@ void NetworkDataTaskLsql::runCmdInner()
         m_errorMsg = "Failed to open database " + path + ".";
         return;
     }
-    m_database.disableThreadingChecks();
 
     m_statusCode = 200;
+    m_database->setInterruption(LsqlWorkQueuePool::singleton().queryDeadline(), &m_isCanceled);
+
+    if (!m_bodyRows.isEmpty())
+    {
+        runSqlRows(m_sqlVec[0], m_bodyRows);
+        return;
+    }
+
+    // a single SELECT: its rows are read as they are sent, a statement
+    // failing to prepare is reported as the others below
+    if (m_sqlVec.size() == 1 && m_sqlVec[0].startsWithIgnoringASCIICase(SELECT) && !m_usesTransaction)
+    {
+        auto statement = makeUnique<LsqlStatement>(*m_database, m_sqlVec[0]);
+        if (prepareStatement(*statement))
+        {
+            m_rowsStatement = WTFMove(statement);
+            return;
+        }
+    }
+
+    // transaction=1: all the statements, or none of them
+    SQLiteTransaction transaction(m_database->database());
+    if (m_usesTransaction)
+    {
+        transaction.begin();
+        if (!transaction.inProgress())
+        {
+            m_statusCode = 503;
+            m_errorMsg = "Failed to begin the transaction.";
+            return;
+        }
+    }
+
+    bool failed = false;
 #if 1
     int size = m_sqlVec.size();
-    for (int i = 0; i < size; i++)
+    for (int i = 0; i < size && !failed; i++)
     {
+        size_t resultCount = m_sqlResults.size();
         String& sql = m_sqlVec[i];
         if (sql.startsWithIgnoringASCIICase(SELECT))
         {
@@ -290,9 +393,100 @@ void NetworkDataTaskLsql::runCmdInner()
         {
             runSqlDelete(sql);
         }
+
+        if (m_usesTransaction && m_sqlResults.size() > resultCount)
+            failed = m_sqlResults.last().statusCode != 200;
     }
 #endif
 
+    if (!m_usesTransaction)
+        return;
+
+    if (!failed)
+    {
+        transaction.commit();
+        failed = transaction.inProgress();
+    }
+    if (failed)
+    {
+        transaction.rollback();
+        rollBackResults();
+    }
+}
+
+bool NetworkDataTaskLsql::isWriteStatement(const String& sql)
+{
+    return sql.startsWithIgnoringASCIICase(INSERT)
+        || sql.startsWithIgnoringASCIICase(UPDATE)
+        || sql.startsWithIgnoringASCIICase(DELETE);
+}
+
+void NetworkDataTaskLsql::rollBackResults()
+{
+    m_statusCode = 500;
+    m_errorMsg = "Rolled back";
+    for (auto& sqlResult : m_sqlResults)
+    {
+        if (sqlResult.statusCode != 200)
+            continue;
+        // the rows read are still what was read, nothing was written
+        sqlResult.errorMsg = m_errorMsg;
+        if (!sqlResult.rows)
+            sqlResult.rowsAffected = 0;
+    }
+}
+
+bool NetworkDataTaskLsql::wasInterrupted(int& statusCode, String& errorMsg)
+{
+    if (m_database->timedOut())
+    {
+        statusCode = 504;
+        errorMsg = "Timed out.";
+        return true;
+    }
+    if (m_isCanceled)
+    {
+        statusCode = 503;
+        errorMsg = "Canceling";
+        return true;
+    }
+    return false;
+}
+
+static String parameterKey(SQLiteStatement& statement, unsigned index)
+{
+    // ?NNN, :name, @name, $name: the name without the prefix; ?: the
+    // position of the parameter
+    String name = statement.bindParameterName(index);
+    return name.isNull() ? String::number(index) : name.substring(1);
+}
+
+bool NetworkDataTaskLsql::prepareStatement(LsqlStatement& statement)
+{
+    if (statement.prepare() != SQLITE_OK)
+        return false;
+
+    unsigned count = statement->bindParameterCount();
+    for (unsigned i = 1; i <= count; i++)
+    {
+        auto findResult = m_paramMap.find(parameterKey(*statement, i));
+        if (findResult == m_paramMap.end())
+        {
+            statement->bindNull(i);
+            continue;
+        }
+
+        // the integers written as SQLite would write them back, the rest as
+        // text, so that "007" stays as it is
+        const String& value = findResult->value;
+        bool isInteger = false;
+        int64_t integer = value.toInt64Strict(&isInteger);
+        if (isInteger && String::number(integer) == value)
+            statement->bindInt64(i, integer);
+        else
+            statement->bindText(i, value);
+    }
+    return true;
 }
 
 void NetworkDataTaskLsql::runSqlSelect(String sql)
@@ -301,8 +495,8 @@ void NetworkDataTaskLsql::runSqlSelect(String sql)
         return;
 
     SqlResult sr;
-    SQLiteStatement statement(m_database, sql);
-    if (statement.prepare() != SQLITE_OK) {
+    LsqlStatement statement(*m_database, sql);
+    if (!prepareStatement(statement)) {
         sr.statusCode = 500;
         sr.errorMsg = "Failed to prepare : " + sql;
 #if 0
@@ -313,42 +507,173 @@ void NetworkDataTaskLsql::runSqlSelect(String sql)
     }
 
     sr.statusCode = 200;
+    sr.rowsAffected = 0;
 
+    // the rows are written as they are read, their values are not kept
+    JSONStreamWriter rows;
+    rows.beginArray();
     int result;
-    while ((result = statement.step()) == SQLITE_ROW) {
-        int columnCount = statement.columnCount();
-        Vector<SQLValueH> columns;
-        for (int i = 0; i < columnCount; i++)
+    while ((result = statement->step()) == SQLITE_ROW) {
+        writeStatementRow(rows, *statement);
+        sr.rowsAffected++;
+
+        if (m_isCanceled)
+            break;
+    }
+    rows.endArray();
+    sr.rows = rows.take();
+
+    if (result != SQLITE_DONE && !wasInterrupted(sr.statusCode, sr.errorMsg))
+    {
+        sr.statusCode = 503;
+        sr.errorMsg = "Failed to read in all origins from the database.";
+#if 0
+        printf("Failed to read in all origins from the database.\n");
+#endif
+    }
+    m_sqlResults.append(sr);
+}
+
+void NetworkDataTaskLsql::startRows()
+{
+    m_rowsWriter.beginObject();
+    m_rowsWriter.writeKey(KEY_ROWS);
+    m_rowsWriter.beginArray();
+    m_rowsToSkip = m_cursor;
+    readRowsOnQueue();
+}
+
+void NetworkDataTaskLsql::readRowsOnQueue()
+{
+    m_queue->dispatch([this, protectedThis = makeRef(*this)] () mutable {
+        bool done = readRows();
+        RunLoop::main().dispatch([this, protectedThis = WTFMove(protectedThis), done] {
+            sendRows(done);
+        });
+    });
+}
+
+bool NetworkDataTaskLsql::readRows()
+{
+    // the timeout is the one of each chunk, the client may read slowly
+    m_database->setInterruption(LsqlWorkQueuePool::singleton().queryDeadline(), &m_isCanceled);
+
+    SQLiteStatement& statement = **m_rowsStatement;
+    bool done = false;
+    for (unsigned steps = 0; steps < maxRowStepsPerChunk && m_rowsWriter.size() < rowsChunkSize; steps++)
+    {
+        int result = statement.step();
+        if (result != SQLITE_ROW)
         {
-            if ((int)m_sqlResultColumnNames.size() <= i)
+            if (result != SQLITE_DONE && !wasInterrupted(m_rowsStatusCode, m_rowsErrorMsg))
             {
-                String key = statement.getColumnName(i);
-                m_sqlResultColumnNames.append(key);
+                m_rowsStatusCode = 503;
+                m_rowsErrorMsg = "Failed to read in all origins from the database.";
             }
+            done = true;
+            break;
+        }
 
-            columns.append(statement.getColumnValueH(i));
+        if (m_rowsToSkip)
+        {
+            // the rows of the pages before the cursor
+            m_rowsToSkip--;
+            continue;
         }
-        sr.rowsVec.append(columns);
 
-        if (m_state == State::Canceling)
+        if (m_pageSize && m_rowCount == m_pageSize)
         {
-            sr.statusCode = 503;
-            sr.errorMsg = "Canceling";
-            m_sqlResults.append(sr);
-            return;
+            // a row after the page: there is a next one
+            m_hasMoreRows = true;
+            done = true;
+            break;
         }
+
+        writeStatementRow(m_rowsWriter, statement);
+        m_rowCount++;
     }
-    sr.rowsAffected = sr.rowsVec.size();
 
-    if (result != SQLITE_DONE)
+    if (done)
+        finishRows();
+    return done;
+}
+
+void NetworkDataTaskLsql::sendRows(bool done)
+{
+    if (m_state == State::Canceling || m_state == State::Completed)
     {
-        sr.statusCode = 503;
-        sr.errorMsg = "Failed to read in all origins from the database.";
-#if 0
-        printf("Failed to read in all origins from the database.\n");
-#endif
+        releaseRows();
+        return;
     }
-    m_sqlResults.append(sr);
+
+    if (!m_rowsWriter.isEmpty())
+        m_client->didReceiveData(m_rowsWriter.take());
+    if (done)
+    {
+        dispatchDidCompleteWithError({ });
+        return;
+    }
+
+    // the chunk is out before more rows are read, unless the client
+    // canceled the task from didReceiveData
+    if (m_state == State::Canceling)
+    {
+        releaseRows();
+        return;
+    }
+    readRowsOnQueue();
+}
+
+void NetworkDataTaskLsql::finishRows()
+{
+    releaseRows();
+
+    m_rowsWriter.endArray();
+    m_rowsWriter.writeKey(KEY_STATUS_CODE);
+    m_rowsWriter.writeInteger(m_rowsStatusCode);
+    m_rowsWriter.writeKey(KEY_ERROR_MSG);
+    if (m_rowsErrorMsg.isEmpty())
+        m_rowsWriter.writeNull();
+    else
+        m_rowsWriter.writeString(m_rowsErrorMsg);
+    m_rowsWriter.writeKey(KEY_ROWSAFFECTED);
+    m_rowsWriter.writeInteger(m_rowCount);
+    if (m_pageSize)
+    {
+        // where the next page starts, null after the last one
+        m_rowsWriter.writeKey(KEY_CURSOR);
+        if (m_hasMoreRows)
+            m_rowsWriter.writeString(String::number(m_cursor + m_rowCount));
+        else
+            m_rowsWriter.writeNull();
+    }
+    m_rowsWriter.endObject();
+}
+
+void NetworkDataTaskLsql::writeStatementRow(JSONStreamWriter& writer, SQLiteStatement& statement)
+{
+    int columnCount = statement.columnCount();
+    if (m_formatArray)
+        writer.beginArray();
+    else
+        writer.beginObject();
+    for (int i = 0; i < columnCount; i++)
+    {
+        if (m_formatArray)
+        {
+            writeValue(writer, statement.getColumnValueView(i));
+            continue;
+        }
+
+        if ((int)m_sqlResultColumnNames.size() <= i)
+            m_sqlResultColumnNames.append(statement.getColumnName(i));
+        writer.writeKey(m_sqlResultColumnNames[i]);
+        writeValue(writer, statement.getColumnValueView(i));
+    }
+    if (m_formatArray)
+        writer.endArray();
+    else
+        writer.endObject();
 }
 
 void NetworkDataTaskLsql::runSqlInsert(String sql)
@@ -357,11 +682,13 @@ void NetworkDataTaskLsql::runSqlInsert(String sql)
         return;
 
     SqlResult sr;
-    SQLiteStatement statement(m_database, sql);
-    if (statement.prepare() != SQLITE_OK
-            || statement.step() != SQLITE_DONE) {
-        sr.statusCode = 500;
-        sr.errorMsg = "Failed to prepare : " + sql;
+    LsqlStatement statement(*m_database, sql);
+    if (!prepareStatement(statement)
+            || statement->step() != SQLITE_DONE) {
+        if (!wasInterrupted(sr.statusCode, sr.errorMsg)) {
+            sr.statusCode = 500;
+            sr.errorMsg = "Failed to prepare : " + sql;
+        }
 #if 0
         printf("Failed to prepare statement.\n");
 #endif
@@ -370,7 +697,7 @@ void NetworkDataTaskLsql::runSqlInsert(String sql)
     }
 
     sr.statusCode = 200;
-    sr.rowsAffected = m_database.lastChanges();
+    sr.rowsAffected = m_database->database().lastChanges();
     m_sqlResults.append(sr);
 }
 
@@ -380,11 +707,13 @@ void NetworkDataTaskLsql::runSqlUpdate(String sql)
         return;
 
     SqlResult sr;
-    SQLiteStatement statement(m_database, sql);
-    if (statement.prepare() != SQLITE_OK
-            || statement.step() != SQLITE_DONE) {
-        sr.statusCode = 500;
-        sr.errorMsg = "Failed to prepare : " + sql;
+    LsqlStatement statement(*m_database, sql);
+    if (!prepareStatement(statement)
+            || statement->step() != SQLITE_DONE) {
+        if (!wasInterrupted(sr.statusCode, sr.errorMsg)) {
+            sr.statusCode = 500;
+            sr.errorMsg = "Failed to prepare : " + sql;
+        }
 #if 0
         printf("Failed to prepare statement.\n");
 #endif
@@ -393,7 +722,7 @@ void NetworkDataTaskLsql::runSqlUpdate(String sql)
     }
 
     sr.statusCode = 200;
-    sr.rowsAffected = m_database.lastChanges();
+    sr.rowsAffected = m_database->database().lastChanges();
     m_sqlResults.append(sr);
 }
 
@@ -403,11 +732,13 @@ void NetworkDataTaskLsql::runSqlDelete(String sql)
         return;
 
     SqlResult sr;
-    SQLiteStatement statement(m_database, sql);
-    if (statement.prepare() != SQLITE_OK
-            || statement.step() != SQLITE_DONE) {
-        sr.statusCode = 500;
-        sr.errorMsg = "Failed to prepare : " + sql;
+    LsqlStatement statement(*m_database, sql);
+    if (!prepareStatement(statement)
+            || statement->step() != SQLITE_DONE) {
+        if (!wasInterrupted(sr.statusCode, sr.errorMsg)) {
+            sr.statusCode = 500;
+            sr.errorMsg = "Failed to prepare : " + sql;
+        }
 #if 0
         printf("Failed to prepare statement.\n");
 #endif
@@ -416,155 +747,270 @@ void NetworkDataTaskLsql::runSqlDelete(String sql)
     }
 
     sr.statusCode = 200;
-    sr.rowsAffected = m_database.lastChanges();
+    sr.rowsAffected = m_database->database().lastChanges();
     m_sqlResults.append(sr);
 }
 
-void NetworkDataTaskLsql::buildResponse()
+static void bindJSONValue(SQLiteStatement& statement, unsigned index, JSON::Value* value)
 {
-    auto result = JSON::Object::create();
+    if (!value)
+    {
+        statement.bindNull(index);
+        return;
+    }
 
-    int resultSize = m_sqlResults.size();
-    switch (resultSize)
+    switch (value->type())
     {
-    case 0:
+    case JSON::Value::Type::Boolean:
         {
-            result->setInteger(KEY_STATUS_CODE, m_statusCode);
-
-            if (m_errorMsg.isEmpty())
-                result->setValue(KEY_ERROR_MSG, JSON::Value::null());
-            else
-                result->setString(KEY_ERROR_MSG, m_errorMsg);
-
-            result->setInteger(KEY_ROWSAFFECTED, m_readLines.size());
-            auto array = JSON::Array::create();
-            result->setArray(KEY_ROWS, WTFMove(array));
+            bool boolean = false;
+            value->asBoolean(boolean);
+            statement.bindInt64(index, boolean);
         }
         break;
 
-    case 1:
+    case JSON::Value::Type::Double:
+    case JSON::Value::Type::Integer:
         {
-            SqlResult& sqlResult = m_sqlResults[0];
-            result->setInteger(KEY_STATUS_CODE, sqlResult.statusCode);
-            if (sqlResult.errorMsg.isEmpty())
-                result->setValue(KEY_ERROR_MSG, JSON::Value::null());
+            double number = 0;
+            value->asDouble(number);
+            // the JSON numbers are doubles, the integral ones go as integers
+            if (number == std::trunc(number) && std::abs(number) < 9007199254740992.0)
+                statement.bindInt64(index, static_cast<int64_t>(number));
             else
-                result->setString(KEY_ERROR_MSG, sqlResult.errorMsg);
-            result->setInteger(KEY_ROWSAFFECTED, sqlResult.rowsAffected);
-
-            int rowSize = sqlResult.rowsVec.size();
-            auto array = JSON::Array::create();
-            for (int i = 0; i < rowSize; i++)
-            {
-                if (m_formatArray)
-                {
-                    array->pushValue(formatAsArray(sqlResult.rowsVec[i]));
-                }
-                else
-                {
-                    array->pushValue(formatAsDict(sqlResult.rowsVec[i]));
-                }
-            }
-            result->setArray(KEY_ROWS, WTFMove(array));
+                statement.bindDouble(index, number);
         }
         break;
 
-    default:
+    case JSON::Value::Type::String:
         {
-            result->setInteger(KEY_STATUS_CODE, 200);
-            auto resultArray = JSON::Array::create();
-            for (int j = 0; j < resultSize; j++)
-            {
-                SqlResult& sqlResult = m_sqlResults[j];
-                auto res = JSON::Object::create();
-
-                if (sqlResult.errorMsg.isEmpty())
-                    res->setValue(KEY_ERROR_MSG, JSON::Value::null());
-                else
-                    res->setString(KEY_ERROR_MSG, sqlResult.errorMsg);
-                res->setInteger(KEY_ROWSAFFECTED, sqlResult.rowsAffected);
-
-                int rowSize = sqlResult.rowsVec.size();
-                auto array = JSON::Array::create();
-                for (int i = 0; i < rowSize; i++)
-                {
-                    if (m_formatArray)
-                    {
-                        array->pushValue(formatAsArray(sqlResult.rowsVec[i]));
-                    }
-                    else
-                    {
-                        array->pushValue(formatAsDict(sqlResult.rowsVec[i]));
-                    }
-                }
-                res->setArray(KEY_ROWS, WTFMove(array));
-                resultArray->pushObject(WTFMove(res));
-            }
-            result->setArray(KEY_RESULT, WTFMove(resultArray));
+            String string;
+            value->asString(string);
+            statement.bindText(index, string);
         }
         break;
+
+    case JSON::Value::Type::Object:
+    case JSON::Value::Type::Array:
+        statement.bindText(index, value->toJSONString());
+        break;
+
+    case JSON::Value::Type::Null:
+        statement.bindNull(index);
+        break;
     }
+}
 
-    String json = result->toJSONString();
+bool NetworkDataTaskLsql::bindRow(SQLiteStatement& statement, JSON::Value& row)
+{
+    RefPtr<JSON::Array> array;
+    RefPtr<JSON::Object> object;
+    if (!row.asArray(array) && !row.asObject(object))
+        return false;
 
-    m_responseBuffer.clear();
-    m_responseBuffer.append(json.characters8(), json.length());
+    unsigned count = statement.bindParameterCount();
+    for (unsigned i = 1; i <= count; i++)
+    {
+        RefPtr<JSON::Value> value;
+        if (array)
+        {
+            if (i <= array->length())
+                value = array->get(i - 1);
+        }
+        else
+            object->getValue(parameterKey(statement, i), value);
+        bindJSONValue(statement, i, value.get());
+    }
+    return true;
 }
 
-Ref<JSON::Value> NetworkDataTaskLsql::formatAsArray(Vector<SQLValueH>& lineColumns)
+void NetworkDataTaskLsql::runSqlRows(const String& sql, const Vector<char>& rows)
 {
-    auto array = JSON::Array::create();
-    if (lineColumns.size() == 0)
-        return array;
+    SqlResult sr;
+    sr.statusCode = 200;
+    sr.rowsAffected = 0;
 
-    int size = lineColumns.size();
-    for (int i = 0; i < size; i++)
+    LsqlStatement statement(*m_database, sql);
+    if (statement.prepare() != SQLITE_OK)
     {
-        SQLValueH value = lineColumns[i];
-        if (WTF::holds_alternative<String>(value))
+        sr.statusCode = 500;
+        sr.errorMsg = "Failed to prepare : " + sql;
+        m_sqlResults.append(sr);
+        return;
+    }
+
+    // one fsync for all the rows
+    SQLiteTransaction transaction(m_database->database());
+    transaction.begin();
+    if (!transaction.inProgress())
+    {
+        sr.statusCode = 503;
+        sr.errorMsg = "Failed to begin the transaction.";
+        m_sqlResults.append(sr);
+        return;
+    }
+
+    // one row in each line: the values of the parameters in their order
+    // in an array, or by their names in an object
+    const char* start = rows.data();
+    const char* end = rows.data() + rows.size();
+    size_t rowNumber = 0;
+    while (start < end && sr.statusCode == 200)
+    {
+        const char* lineFeed = static_cast<const char*>(memchr(start, '\n', end - start));
+        if (!lineFeed)
+            lineFeed = end;
+        String line = String::fromUTF8(start, lineFeed - start);
+        start = lineFeed + 1;
+        // a line which is not UTF-8 comes out null, it is a bad row
+        if (!line.isNull() && line.stripWhiteSpace().isEmpty())
+            continue;
+
+        rowNumber++;
+        RefPtr<JSON::Value> row;
+        if (line.isNull() || !JSON::Value::parseJSON(line, row)
+                || !bindRow(*statement, *row))
         {
-            array->pushString(WTF::get<String>(value));
+            sr.statusCode = 400;
+            sr.errorMsg = makeString("Bad row ", rowNumber, ".");
+            break;
         }
-        else if (WTF::holds_alternative<double>(value))
+
+        if (statement->step() != SQLITE_DONE)
         {
-            array->pushDouble(WTF::get<double>(value));
+            if (!wasInterrupted(sr.statusCode, sr.errorMsg))
+            {
+                sr.statusCode = 500;
+                sr.errorMsg = makeString("Failed to run row ", rowNumber, " : ", sql);
+            }
+            break;
         }
-        else if (WTF::holds_alternative<int>(value))
+        sr.rowsAffected += m_database->database().lastChanges();
+        statement->reset();
+
+        if (m_isCanceled)
         {
-            array->pushInteger(WTF::get<int>(value));
+            sr.statusCode = 503;
+            sr.errorMsg = "Canceling";
         }
-        else
-            array->pushValue(JSON::Value::null());
     }
-    return array;
+
+    if (sr.statusCode == 200)
+    {
+        transaction.commit();
+        if (transaction.inProgress())
+        {
+            sr.statusCode = 503;
+            sr.errorMsg = "Failed to commit the transaction.";
+        }
+    }
+    if (sr.statusCode != 200)
+    {
+        transaction.rollback();
+        sr.rowsAffected = 0;
+    }
+    m_sqlResults.append(sr);
 }
 
-Ref<JSON::Value> NetworkDataTaskLsql::formatAsDict(Vector<SQLValueH>& lineColumns)
+void NetworkDataTaskLsql::buildResponse()
 {
-    auto result = JSON::Object::create();
-    if (lineColumns.size() == 0)
-        return result;
+    JSONStreamWriter writer;
+    writer.beginObject();
 
-    int size = lineColumns.size();
-    for (int i = 0; i < size; i++)
+    int resultSize = m_sqlResults.size();
+    switch (resultSize)
     {
-        SQLValueH value = lineColumns[i];
-        if (WTF::holds_alternative<String>(value))
+    case 0:
         {
-            result->setString(m_sqlResultColumnNames[i], WTF::get<String>(value));
+            writer.writeKey(KEY_STATUS_CODE);
+            writer.writeInteger(m_statusCode);
+            writer.writeKey(KEY_ERROR_MSG);
+            if (m_errorMsg.isEmpty())
+                writer.writeNull();
+            else
+                writer.writeString(m_errorMsg);
+            writer.writeKey(KEY_ROWSAFFECTED);
+            writer.writeInteger(m_readLines.size());
+            writer.writeKey(KEY_ROWS);
+            writer.beginArray();
+            writer.endArray();
         }
-        else if (WTF::holds_alternative<double>(value))
+        break;
+
+    case 1:
         {
-            result->setDouble(m_sqlResultColumnNames[i], WTF::get<double>(value));
+            writer.writeKey(KEY_STATUS_CODE);
+            writer.writeInteger(m_sqlResults[0].statusCode);
+            writeResult(writer, m_sqlResults[0]);
         }
-        else if (WTF::holds_alternative<int>(value))
+        break;
+
+    default:
         {
-            result->setInteger(m_sqlResultColumnNames[i], WTF::get<int>(value));
+            writer.writeKey(KEY_STATUS_CODE);
+            writer.writeInteger(m_statusCode);
+            writer.writeKey(KEY_RESULT);
+            writer.beginArray();
+            for (auto& sqlResult : m_sqlResults)
+            {
+                writer.beginObject();
+                writeResult(writer, sqlResult);
+                writer.endObject();
+            }
+            writer.endArray();
         }
-        else
-            result->setValue(m_sqlResultColumnNames[i], JSON::Value::null());
+        break;
+    }
+
+    writer.endObject();
+    m_responseBuffer = writer.take();
+}
+
+void NetworkDataTaskLsql::writeResult(JSONStreamWriter& writer, SqlResult& sqlResult)
+{
+    writer.writeKey(KEY_ERROR_MSG);
+    if (sqlResult.errorMsg.isEmpty())
+        writer.writeNull();
+    else
+        writer.writeString(sqlResult.errorMsg);
+    writer.writeKey(KEY_ROWSAFFECTED);
+    writer.writeInteger(sqlResult.rowsAffected);
+
+    writer.writeKey(KEY_ROWS);
+    if (sqlResult.rows)
+    {
+        // JSON already: its segments are moved in, and are not kept
+        writer.writeJSON(sqlResult.rows.releaseNonNull());
+    }
+    else
+    {
+        writer.beginArray();
+        writer.endArray();
+    }
+}
+
+void NetworkDataTaskLsql::writeValue(JSONStreamWriter& writer, const SQLValueView& value)
+{
+    switch (value.type)
+    {
+    case SQLValueView::Type::Integer:
+        writer.writeInteger(value.integer);
+        break;
+
+    case SQLValueView::Type::Double:
+        writer.writeDouble(value.number);
+        break;
+
+    case SQLValueView::Type::Text:
+    case SQLValueView::Type::Blob:
+        // a blob as the text in it
+        writer.writeUTF8String(value.data, value.length);
+        break;
+
+    case SQLValueView::Type::Null:
+        writer.writeNull();
+        break;
     }
-    return result;
 }
 
 void NetworkDataTaskLsql::parseQueryString(String query)
@@ -592,6 +1038,19 @@ void NetworkDataTaskLsql::parseQueryString(String query)
         {
             m_formatArray = equalIgnoringASCIICase(value, FORMAT_ARRAY);
         }
+        else if (equalIgnoringASCIICase(name, CMD_SQL_TRANSACTION))
+        {
+            m_usesTransaction = value == "1" || equalIgnoringASCIICase(value, "true");
+        }
+        else if (equalIgnoringASCIICase(name, CMD_SQL_PAGESIZE))
+        {
+            // 0, or not a number: all the rows
+            m_pageSize = value.toUInt64Strict();
+        }
+        else if (equalIgnoringASCIICase(name, CMD_SQL_CURSOR))
+        {
+            m_cursor = value.toUInt64Strict();
+        }
         else
         {
             m_paramMap.set(name, value);
@@ -599,112 +1058,99 @@ void NetworkDataTaskLsql::parseQueryString(String query)
     }
 }
 
-void NetworkDataTaskLsql::parseSqlQuery(String sqlQuery)
+// A table name can not be a parameter: $name right after one of these
+// words is the only one replaced by its value in the SQL text.
+static bool isTableNamePosition(const StringBuilder& sql)
 {
-    if (sqlQuery.isEmpty())
-        return;
+    unsigned end = sql.length();
+    while (end && isASCIISpace(sql[end - 1]))
+        end--;
+
+    unsigned start = end;
+    while (start && isASCIIAlpha(sql[start - 1]))
+        start--;
+
+    StringBuilder wordSb;
+    for (unsigned i = start; i < end; i++)
+        wordSb.append(sql[i]);
+    String word = wordSb.toString();
+
+    return equalLettersIgnoringASCIICase(word, "from")
+        || equalLettersIgnoringASCIICase(word, "join")
+        || equalLettersIgnoringASCIICase(word, "into")
+        || equalLettersIgnoringASCIICase(word, "update")
+        || equalLettersIgnoringASCIICase(word, "table")
+        || equalLettersIgnoringASCIICase(word, "exists");
+}
 
-    Vector<String> params = sqlQuery.split(";");
-    int size = params.size();
-    for (int i = 0; i < size; i++)
+String NetworkDataTaskLsql::substituteSqlParameters(const String& sql, const HashMap<String, String>& params)
+{
+    StringBuilder sqlSb;
+    unsigned length = sql.length();
+    unsigned i = 0;
+    while (i < length)
     {
-        StringBuilder sqlSb;
-        String param = params[i].stripWhiteSpace();
-
-        size_t start = param.find('$');
+        size_t start = sql.find('$', i);
         if (start == notFound)
         {
-            m_sqlVec.append(param);
-            continue;
+            sqlSb.append(StringView(sql).substring(i));
+            break;
         }
 
-        size_t paramLength = param.length();
-        size_t end = start + 1;
-        sqlSb.append(param.substring(0, start - 0));
-        while ((start != notFound) && (end < paramLength))
+        sqlSb.append(StringView(sql).substring(i, start - i));
+        i = start + 1;
+        if (i < length && sql[i] == '$')
         {
-            if (param[end] == '$' )
-            {
-                sqlSb.append("$");
-
-                start = param.find('$', end + 1);
-                if (start != notFound)
-                {
-                    sqlSb.append(param.substring(end+1, start - end - 1));
-                }
-                else
-                {
-                    sqlSb.append(param.substring(end+1));
-                }
-
-                end = start + 1;
-                continue;
-            }
-
-            if (!((param[end] >= 'a' && param[end] <= 'z')
-                        || (param[end] >= 'A' && param[end] <= 'Z')
-                        ))
-            {
-                sqlSb.append(param.substring(start, 2));
-                start = param.find('$', end + 1);
-                if (start != notFound)
-                {
-                    sqlSb.append(param.substring(end + 1, start - end - 1));
-                }
-                else
-                {
-                    sqlSb.append(param.substring(end + 1));
-                }
-                end = start + 1;
-                continue;
-            }
+            // $$ is a $
+            sqlSb.append('$');
+            i++;
+            continue;
+        }
+        if (i == length || !isASCIIAlpha(sql[i]))
+        {
+            sqlSb.append('$');
+            continue;
+        }
 
-#if 0
-            if (param[end] >= '0' and param[end] <= '9')
-            {
-            }
-#endif
+        size_t end = i;
+        while (end < length && (isASCIIAlphanumeric(sql[end]) || sql[end] == '_'))
+            end++;
 
-            StringBuilder sb;
-            for (;end < paramLength; end++)
-            {
-                if ((param[end] >= '0' && param[end] <= '9')
-                    || (param[end] >= 'a' && param[end] <= 'z')
-                    || (param[end] >= 'A' && param[end] <= 'Z')
-                    || (param[end] == '_'))
-                {
-                    sb.append(param[end]);
-                }
-                else
-                {
-                    break;
-                }
-            }
+        auto findResult = params.find(sql.substring(i, end - i));
+        if (findResult != params.end() && isTableNamePosition(sqlSb))
+        {
+            sqlSb.append(findResult->value);
+        }
+        else
+        {
+            // left to prepareStatement(), which binds it: the value never
+            // goes into the SQL text
+            sqlSb.append(StringView(sql).substring(start, end - start));
+        }
+        i = end;
+    }
+    return sqlSb.toString();
+}
 
-            auto findResult = m_paramMap.find(sb.toString());
-            if(findResult != m_paramMap.end())
-            {
-                sqlSb.append(findResult->value);
-            }
+void NetworkDataTaskLsql::parseSqlQuery(String sqlQuery)
+{
+    if (sqlQuery.isEmpty())
+        return;
 
-            if (end < paramLength)
-            {
-                start = param.find('$', end);
-                if (start != notFound)
-                {
-                    sqlSb.append(param.substring(end, start - end));
-                }
-                else
-                {
-                    sqlSb.append(param.substring(end));
-                }
-                end = start + 1;
-            }
+    Vector<String> params = sqlQuery.split(";");
+    for (auto& param : params)
+    {
+        String sql = param.stripWhiteSpace();
+        if (sql.find('$') == notFound)
+        {
+            m_sqlVec.append(sql);
+            continue;
         }
 
-        if (!sqlSb.isEmpty())
+        sql = substituteSqlParameters(sql, m_paramMap);
+        if (!sql.isEmpty())
         {
-            m_sqlVec.append(sqlSb.toString());
+            m_sqlVec.append(sql);
         }
     }
 }
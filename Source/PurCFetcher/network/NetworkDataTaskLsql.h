@@ -54,22 +54,24 @@
 #include "NetworkLoadMetrics.h"
 #include "ProtectionSpace.h"
 #include "ResourceResponse.h"
-#include "SQLiteDatabase.h"
+#include "JSONStreamWriter.h"
+#include "LsqlDatabasePool.h"
 #include "SQLiteFileSystem.h"
 #include "SQLValue.h"
+#include <wtf/JSONValues.h>
 #include <wtf/RunLoop.h>
 #include <wtf/glib/GRefPtr.h>
 #include "CmdFilterManager.h"
 
 namespace PurCFetcher {
-using PurCFetcher::SQLValueH;
 
 class SqlResult {
 public:
     int statusCode;
     String errorMsg;
     int rowsAffected;
-    Vector<Vector<SQLValueH>> rowsVec;
+    // the JSON array of the rows read, null for a statement reading none
+    RefPtr<SharedBuffer> rows;
 };
 
 class NetworkDataTaskLsql final : public NetworkDataTask {
@@ -81,6 +83,11 @@ public:
 
     ~NetworkDataTaskLsql();
 
+    // Replaces $name by the value of the parameter name where a table name
+    // is expected, after FROM, JOIN, INTO, UPDATE, TABLE or EXISTS. Any
+    // other $name is left in the SQL, to be bound; $$ is a $.
+    static String substituteSqlParameters(const String& sql, const HashMap<String, String>& params);
+
 private:
     NetworkDataTaskLsql(NetworkSession&, NetworkDataTaskClient&, const PurCFetcher::ResourceRequest&, PurCFetcher::StoredCredentialsPolicy, PurCFetcher::ContentSniffingPolicy, PurCFetcher::ContentEncodingSniffingPolicy, bool shouldClearReferrerOnHTTPSToHTTPRedirect, bool dataTaskIsForMainFrameNavigation);
 
@@ -97,20 +104,59 @@ private:
     void createRequest(PurCFetcher::ResourceRequest&&);
     void sendRequest();
 
+    // The request is parsed on the main thread, then the statements run
+    // and the response is written on a queue of LsqlWorkQueuePool; the
+    // members are used by one or the other, never by both at once.
     void runCmdInner();
+    // any statement but a SELECT goes to the writer queue of the file
+    bool writesDatabase() const;
+    // the statement was stopped by the query timeout or by cancel()
+    bool wasInterrupted(int& statusCode, String& errorMsg);
+
+    // A single SELECT: once the response is accepted, its rows are read
+    // on the queue and sent from the main thread a chunk at a time, the
+    // statement staying open in between. The rows come first in the
+    // object, the status after them. With pageSize=N the response has at
+    // most N rows, and the cursor to pass back for the next ones; cursor=C
+    // starts from the row C.
+    void startRows();
+    void readRowsOnQueue();
+    // on the queue, true after the last row
+    bool readRows();
+    void sendRows(bool done);
+    void finishRows();
+    // the values of the current row, as SQLite has them
+    void writeStatementRow(JSONStreamWriter&, SQLiteStatement&);
+    void releaseRows();
+    // the statements are done: the next request on the file can have it
+    void giveBackDatabase();
+
+    // Prepares the statement, or takes it from the cache, and binds its
+    // parameters to the ones of the query string.
+    bool prepareStatement(LsqlStatement&);
 
     void runSqlSelect(String sql);
     void runSqlInsert(String sql);
     void runSqlUpdate(String sql);
     void runSqlDelete(String sql);
 
+    // A write statement run once for each row of the body, in one
+    // transaction.
+    void runSqlRows(const String& sql, const Vector<char>& rows);
+    bool bindRow(SQLiteStatement&, JSON::Value& row);
+
+    static bool isWriteStatement(const String& sql);
+    // transaction=1 and a statement failed: none of them was done
+    void rollBackResults();
+
     void buildResponse();
 
     void parseQueryString(String query);
     void parseSqlQuery(String sqlQuery);
 
-    Ref<JSON::Value> formatAsArray(Vector<SQLValueH>& lineColumns);
-    Ref<JSON::Value> formatAsDict(Vector<SQLValueH>& lineColumns);
+    // the error, the rows affected and the rows of one statement
+    void writeResult(JSONStreamWriter&, SqlResult&);
+    void writeValue(JSONStreamWriter&, const SQLValueView&);
 private:
     State m_state { State::Suspended };
     PurCFetcher::ResourceRequest m_currentRequest;
@@ -119,7 +165,7 @@ private:
     MonotonicTime m_startTime;
     PurCFetcher::NetworkLoadMetrics m_networkLoadMetrics;
     Vector<char> m_readBuffer;
-    Vector<char> m_responseBuffer;
+    RefPtr<SharedBuffer> m_responseBuffer;
     Vector<String> m_readLines;
 
     String m_errorMsg;
@@ -128,13 +174,32 @@ private:
 
     HashMap<String, String> m_paramMap;
 
-    PurCFetcher::SQLiteDatabase m_database;
+    String m_path;
+    // the rows of the body, for a single write statement
+    Vector<char> m_bodyRows;
+    RefPtr<LsqlWorkQueuePool::Queue> m_queue;
+    std::atomic<bool> m_isCanceled { false };
+
+    // from LsqlDatabasePool, while the statements run
+    RefPtr<LsqlDatabase> m_database;
     Vector<String> m_sqlVec;
     Vector<String> m_sqlResultColumnNames;
     Vector<SqlResult> m_sqlResults;
 
     bool m_formatArray;
+    bool m_usesTransaction { false };
     String m_sqlQuery;
+
+    // the SELECT whose rows are sent as they are read
+    std::unique_ptr<LsqlStatement> m_rowsStatement;
+    JSONStreamWriter m_rowsWriter;
+    int m_rowsStatusCode { 200 };
+    String m_rowsErrorMsg;
+    uint64_t m_rowCount { 0 };
+    uint64_t m_rowsToSkip { 0 };
+    uint64_t m_pageSize { 0 };
+    uint64_t m_cursor { 0 };
+    bool m_hasMoreRows { false };
 };
 
 } // namespace PurCFetcher
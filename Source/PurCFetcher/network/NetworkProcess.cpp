@@ -36,6 +36,7 @@
 #include "Download.h"
 #include "DownloadProxyMessages.h"
 #include "Logging.h"
+#include "MessageStatistics.h"
 #include "NetworkConnectionToWebProcess.h"
 #include "NetworkLoad.h"
 #include "NetworkProcessCreationParameters.h"
@@ -311,6 +312,7 @@ void NetworkProcess::initializeNetworkProcess(NetworkProcessCreationParameters&&
         memoryPressureHandler.install();
     }
 
+    m_cacheQuota = parameters.cacheQuota;
     setCacheModel(parameters.cacheModel);
 
 #if ENABLE(RESOURCE_LOAD_STATISTICS)
@@ -2030,6 +2032,43 @@ void NetworkProcess::setCacheModel(CacheModel cacheModel)
     });
 }
 
+void NetworkProcess::setCacheQuota(uint64_t cacheQuota)
+{
+    if (cacheQuota == m_cacheQuota)
+        return;
+
+    m_cacheQuota = cacheQuota;
+#if USE(SOUP)
+    SoupNetworkSession::setInitialCacheQuota(cacheQuota);
+#endif
+
+    forEachNetworkSession([cacheQuota](auto& session) {
+        if (auto* cache = session.cache())
+            cache->updateCapacity();
+#if USE(SOUP)
+        static_cast<NetworkSessionSoup&>(session).soupNetworkSession().setCacheQuota(cacheQuota);
+#endif
+    });
+}
+
+void NetworkProcess::setMaxConnections(uint64_t maxConnections)
+{
+#if USE(SOUP)
+    unsigned limit = std::min<uint64_t>(maxConnections, std::numeric_limits<unsigned>::max());
+    SoupNetworkSession::setInitialMaxConnections(limit);
+    forEachNetworkSession([limit](auto& session) {
+        static_cast<NetworkSessionSoup&>(session).soupNetworkSession().setMaxConnections(limit);
+    });
+#else
+    UNUSED_PARAM(maxConnections);
+#endif
+}
+
+void NetworkProcess::dumpMessageStatistics(CompletionHandler<void(String&&)>&& completionHandler)
+{
+    completionHandler(IPC::MessageStatistics::singleton().snapshot());
+}
+
 void NetworkProcess::setAllowsAnySSLCertificateForWebSocket(bool allows, CompletionHandler<void()>&& completionHandler)
 {
     DeprecatedGlobalSettings::setAllowsAnySSLCertificate(allows);
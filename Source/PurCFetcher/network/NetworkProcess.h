@@ -164,7 +164,11 @@ public:
     void processDidResume();
     void resume();
 
+    // Also called directly by the in-process fetcher, see NetworkProcessLocal.
+    void initializeNetworkProcess(NetworkProcessCreationParameters&&);
+
     CacheModel cacheModel() const { return m_cacheModel; }
+    uint64_t cacheQuota() const { return m_cacheQuota; }
 
     // Diagnostic messages logging.
     void logDiagnosticMessage(WebPageProxyIdentifier, const String& message, const String& description, PurCFetcher::ShouldSample);
@@ -357,7 +361,6 @@ private:
 
     // Message Handlers
     void didReceiveSyncNetworkProcessMessage(IPC::Connection&, IPC::Decoder&, std::unique_ptr<IPC::Encoder>&);
-    void initializeNetworkProcess(NetworkProcessCreationParameters&&);
     void createNetworkConnectionToWebProcess(PurCFetcher::ProcessIdentifier, PAL::SessionID, CompletionHandler<void(Optional<IPC::Attachment>&&, PurCFetcher::HTTPCookieAcceptPolicy)>&&);
 
     void fetchWebsiteData(PAL::SessionID, OptionSet<WebsiteDataType>, OptionSet<WebsiteDataFetchOption>, CallbackID);
@@ -382,6 +385,9 @@ private:
 
     void setCacheModel(CacheModel);
     void setCacheModelSynchronouslyForTesting(CacheModel, CompletionHandler<void()>&&);
+    void setCacheQuota(uint64_t);
+    void setMaxConnections(uint64_t);
+    void dumpMessageStatistics(CompletionHandler<void(String&&)>&&);
     void allowSpecificHTTPSCertificateForHost(const PurCFetcher::CertificateInfo&, const String& host);
     void setAllowsAnySSLCertificateForWebSocket(bool, CompletionHandler<void()>&&);
 
@@ -467,6 +473,7 @@ private:
 
     bool m_hasSetCacheModel { false };
     CacheModel m_cacheModel { CacheModel::DocumentViewer };
+    uint64_t m_cacheQuota { 0 };
     bool m_suppressMemoryPressureHandler { false };
     String m_uiProcessBundleIdentifier;
     DownloadManager m_downloadManager;
@@ -55,6 +55,8 @@ void NetworkProcessCreationParameters::encode(IPC::Encoder& encoder) const
     encoder << enableAdClickAttributionDebugMode;
     encoder << hstsStorageDirectory;
     encoder << hstsStorageDirectoryExtensionHandle;
+    encoder << maxConnections;
+    encoder << cacheQuota;
 }
 
 bool NetworkProcessCreationParameters::decode(IPC::Decoder& decoder, NetworkProcessCreationParameters& result)
@@ -104,6 +106,12 @@ bool NetworkProcessCreationParameters::decode(IPC::Decoder& decoder, NetworkProc
     if (!decoder.decode(result.hstsStorageDirectoryExtensionHandle))
         return false;
 
+    if (!decoder.decode(result.maxConnections))
+        return false;
+
+    if (!decoder.decode(result.cacheQuota))
+        return false;
+
     return true;
 }
 
@@ -75,6 +75,10 @@ struct NetworkProcessCreationParameters {
     bool enableAdClickAttributionDebugMode { false };
     String hstsStorageDirectory;
     SandboxExtension::Handle hstsStorageDirectoryExtensionHandle;
+
+    // 0 keeps the defaults of the network session
+    uint64_t maxConnections { 0 };
+    uint64_t cacheQuota { 0 };
 };
 
 } // namespace PurCFetcher
@@ -0,0 +1,312 @@
+/* 
+ * Copyright (C) 2020 Beijing FMSoft Technologies Co., Ltd.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ * 
+ * Or,
+ * 
+ * As this component is a program released under LGPLv3, which claims
+ * explicitly that the program could be modified by any end user
+ * even if the program is conveyed in non-source form on the system it runs.
+ * Generally, if you distribute this program in embedded devices,
+ * you might not satisfy this condition. Under this situation or you can
+ * not accept any condition of LGPLv3, you need to get a commercial license
+ * from FMSoft, along with a patent license for the patents owned by FMSoft.
+ * 
+ * If you have got a commercial/patent license of this program, please use it
+ * under the terms and conditions of the commercial license.
+ * 
+ * For more information about the commercial license and patent license,
+ * please refer to
+ * <https://hybridos.fmsoft.cn/blog/hybridos-licensing-policy/>.
+ * 
+ * Also note that the LGPLv3 license does not apply to any entity in the
+ * Exception List published by Beijing FMSoft Technologies Co., Ltd.
+ * 
+ * If you are or the entity you represent is listed in the Exception List,
+ * the above open source or free software license does not apply to you
+ * or the entity you represent. Regardless of the purpose, you should not
+ * use the software in any way whatsoever, including but not limited to
+ * downloading, viewing, copying, distributing, compiling, and running.
+ * If you have already downloaded it, you MUST destroy all of its copies.
+ * 
+ * The Exception List is published by FMSoft and may be updated
+ * from time to time. For more information, please see
+ * <https://www.fmsoft.cn/exception-list>.
+ */ 
+
+#include "config.h"
+#include "NetworkProcessLocal.h"
+
+#include "AuxiliaryProcessMain.h"
+#include "Connection.h"
+#include "FrameLoaderTypes.h"
+#include "NetworkLoad.h"
+#include "NetworkLoadParameters.h"
+#include "NetworkProcess.h"
+#include "NetworkSession.h"
+#include "ResourceError.h"
+#include "ResourceResponse.h"
+#include "SharedBuffer.h"
+#include <wtf/text/CString.h>
+#include <wtf/threads/BinarySemaphore.h>
+#include <unistd.h>
+
+namespace PurCFetcher {
+
+NetworkProcessLocal& NetworkProcessLocal::singleton()
+{
+    static NeverDestroyed<NetworkProcessLocal> networkProcessLocal;
+    return networkProcessLocal;
+}
+
+bool NetworkProcessLocal::start(NetworkProcessCreationParameters&& parameters)
+{
+    auto locker = holdLock(m_startLock);
+    if (m_stopped)
+        return false;
+
+    if (m_runLoop) {
+        auto* networkProcess = m_networkProcess;
+        m_runLoop->dispatch([networkProcess, maxConnections = parameters.maxConnections, cacheQuota = parameters.cacheQuota] {
+            networkProcess->setMaxConnections(maxConnections);
+            networkProcess->setCacheQuota(cacheQuota);
+        });
+        return true;
+    }
+
+    BinarySemaphore semaphore;
+    m_thread = Thread::create("PurCFetcher Local", [this, &semaphore, parameters = WTFMove(parameters)]() mutable {
+        run(WTFMove(parameters));
+        semaphore.signal();
+        RunLoop::run();
+    });
+    semaphore.wait();
+    return m_runLoop;
+}
+
+void NetworkProcessLocal::run(NetworkProcessCreationParameters&& parameters)
+{
+    // This thread plays the main thread of the network process.
+    InitializeFetcher();
+
+    auto socketPair = IPC::Connection::createPlatformConnection();
+    m_parentConnectionSocket = socketPair.client;
+
+    AuxiliaryProcessInitializationParameters auxiliaryParameters;
+    auxiliaryParameters.processIdentifier = ProcessIdentifier::generate();
+    auxiliaryParameters.connectionIdentifier = socketPair.server;
+    auxiliaryParameters.processType = AuxiliaryProcess::ProcessType::Network;
+
+    static NeverDestroyed<NetworkProcess> networkProcess(WTFMove(auxiliaryParameters));
+    m_networkProcess = &networkProcess.get();
+    m_networkProcess->initializeNetworkProcess(WTFMove(parameters));
+    m_runLoop = &RunLoop::current();
+}
+
+void NetworkProcessLocal::stop()
+{
+    RefPtr<Thread> thread;
+    {
+        auto locker = holdLock(m_startLock);
+        if (!m_runLoop)
+            return;
+
+        // The loads dispatched so far start before they are failed.
+        m_runLoop->dispatch([this] {
+            auto loads = WTFMove(m_loads);
+            for (auto* load : loads) {
+                load->cancel();
+                delete load;
+            }
+
+            // After the deletes the finished loads have queued.
+            RunLoop::current().dispatch([] {
+                RunLoop::current().stop();
+            });
+        });
+        m_runLoop = nullptr;
+        m_stopped = true;
+        thread = WTFMove(m_thread);
+    }
+
+    ASSERT(thread.get() != &Thread::current());
+    thread->waitForCompletion();
+}
+
+void NetworkProcessLocal::didFinishLoad(LocalNetworkLoad& load)
+{
+    m_loads.remove(&load);
+}
+
+uint64_t NetworkProcessLocal::load(const char* url, const char* method, uint32_t timeout, const purc_fetcher_local_client& client, void* ctxt)
+{
+    auto locker = holdLock(m_startLock);
+    if (!m_runLoop || !url)
+        return 0;
+
+    auto identifier = ++m_lastLoadIdentifier;
+    m_runLoop->dispatch([this, url = CString(url), method = CString(method ? method : "GET"), timeout, client, ctxt] {
+        auto* session = m_networkProcess->networkSession(PAL::SessionID::defaultSessionID());
+        if (!session) {
+            if (client.did_finish)
+                client.did_finish(ctxt, 500);
+            return;
+        }
+
+        ResourceRequest request;
+        request.setURL(URL(URL(), String::fromUTF8(url.data())));
+        request.setHTTPMethod(String(method.data()));
+        request.setTimeoutInterval(timeout);
+
+        NetworkLoadParameters parameters;
+        parameters.request = WTFMove(request);
+        parameters.webPageProxyID = WebPageProxyIdentifier::generate();
+        parameters.webPageID = PageIdentifier::generate();
+        parameters.webFrameID = FrameIdentifier::generate();
+        parameters.parentPID = getpid();
+
+        auto* load = new LocalNetworkLoad(client, ctxt);
+        m_loads.add(load);
+        load->start(WTFMove(parameters), *session);
+    });
+    return identifier;
+}
+
+void NetworkProcessLocal::setMaxConnections(uint64_t maxConnections)
+{
+    auto locker = holdLock(m_startLock);
+    if (!m_runLoop)
+        return;
+
+    m_runLoop->dispatch([this, maxConnections] {
+        m_networkProcess->setMaxConnections(maxConnections);
+    });
+}
+
+void NetworkProcessLocal::setCacheQuota(uint64_t cacheQuota)
+{
+    auto locker = holdLock(m_startLock);
+    if (!m_runLoop)
+        return;
+
+    m_runLoop->dispatch([this, cacheQuota] {
+        m_networkProcess->setCacheQuota(cacheQuota);
+    });
+}
+
+LocalNetworkLoad::LocalNetworkLoad(const purc_fetcher_local_client& client, void* ctxt)
+    : m_client(client)
+    , m_ctxt(ctxt)
+{
+}
+
+LocalNetworkLoad::~LocalNetworkLoad()
+{
+}
+
+void LocalNetworkLoad::start(NetworkLoadParameters&& parameters, NetworkSession& session)
+{
+    m_networkLoad = makeUnique<NetworkLoad>(*this, WTFMove(parameters), session);
+}
+
+void LocalNetworkLoad::willSendRedirectedRequest(ResourceRequest&&, ResourceRequest&& redirectRequest, ResourceResponse&&)
+{
+    m_networkLoad->continueWillSendRequest(WTFMove(redirectRequest));
+}
+
+void LocalNetworkLoad::didReceiveResponse(ResourceResponse&& response, ResponseCompletionHandler&& completionHandler)
+{
+    m_statusCode = response.httpStatusCode();
+    if (m_client.did_receive_response)
+        m_client.did_receive_response(m_ctxt, m_statusCode, response.mimeType().utf8().data(), response.expectedContentLength());
+    completionHandler(PolicyAction::Use);
+}
+
+void LocalNetworkLoad::didReceiveBuffer(Ref<SharedBuffer>&& buffer, int)
+{
+    if (!m_client.did_receive_data)
+        return;
+
+    for (auto& entry : buffer.get())
+        m_client.did_receive_data(m_ctxt, entry.segment->data(), entry.segment->size());
+}
+
+void LocalNetworkLoad::didFinishLoading(const NetworkLoadMetrics&)
+{
+    finish(m_statusCode);
+}
+
+void LocalNetworkLoad::didFailLoading(const ResourceError&)
+{
+    // Same code as the IPC backend reports for a failed load.
+    finish(408);
+}
+
+void LocalNetworkLoad::cancel()
+{
+    // Nothing comes from the network load once it is deleted.
+    m_networkLoad->cancel();
+    m_networkLoad = nullptr;
+    if (m_client.did_finish)
+        m_client.did_finish(m_ctxt, 500);
+}
+
+void LocalNetworkLoad::finish(int statusCode)
+{
+    NetworkProcessLocal::singleton().didFinishLoad(*this);
+    if (m_client.did_finish)
+        m_client.did_finish(m_ctxt, statusCode);
+
+    // The network load may still be on the stack.
+    RunLoop::current().dispatch([this] {
+        delete this;
+    });
+}
+
+} // namespace PurCFetcher
+
+using namespace PurCFetcher;
+
+bool purc_fetcher_local_start(size_t max_conns, size_t cache_quota)
+{
+    NetworkProcessCreationParameters parameters;
+    parameters.maxConnections = max_conns;
+    parameters.cacheQuota = cache_quota;
+    return NetworkProcessLocal::singleton().start(WTFMove(parameters));
+}
+
+void purc_fetcher_local_stop(void)
+{
+    NetworkProcessLocal::singleton().stop();
+}
+
+uint64_t purc_fetcher_local_load(const char* url, const char* method,
+        uint32_t timeout, const struct purc_fetcher_local_client* client,
+        void* ctxt)
+{
+    if (!client)
+        return 0;
+    return NetworkProcessLocal::singleton().load(url, method, timeout, *client, ctxt);
+}
+
+void purc_fetcher_local_set_max_conns(size_t max_conns)
+{
+    NetworkProcessLocal::singleton().setMaxConnections(max_conns);
+}
+
+void purc_fetcher_local_set_cache_quota(size_t cache_quota)
+{
+    NetworkProcessLocal::singleton().setCacheQuota(cache_quota);
+}
@@ -0,0 +1,138 @@
+/* 
+ * Copyright (C) 2020 Beijing FMSoft Technologies Co., Ltd.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ * 
+ * Or,
+ * 
+ * As this component is a program released under LGPLv3, which claims
+ * explicitly that the program could be modified by any end user
+ * even if the program is conveyed in non-source form on the system it runs.
+ * Generally, if you distribute this program in embedded devices,
+ * you might not satisfy this condition. Under this situation or you can
+ * not accept any condition of LGPLv3, you need to get a commercial license
+ * from FMSoft, along with a patent license for the patents owned by FMSoft.
+ * 
+ * If you have got a commercial/patent license of this program, please use it
+ * under the terms and conditions of the commercial license.
+ * 
+ * For more information about the commercial license and patent license,
+ * please refer to
+ * <https://hybridos.fmsoft.cn/blog/hybridos-licensing-policy/>.
+ * 
+ * Also note that the LGPLv3 license does not apply to any entity in the
+ * Exception List published by Beijing FMSoft Technologies Co., Ltd.
+ * 
+ * If you are or the entity you represent is listed in the Exception List,
+ * the above open source or free software license does not apply to you
+ * or the entity you represent. Regardless of the purpose, you should not
+ * use the software in any way whatsoever, including but not limited to
+ * downloading, viewing, copying, distributing, compiling, and running.
+ * If you have already downloaded it, you MUST destroy all of its copies.
+ * 
+ * The Exception List is published by FMSoft and may be updated
+ * from time to time. For more information, please see
+ * <https://www.fmsoft.cn/exception-list>.
+ */ 
+
+#pragma once
+
+#include "NetworkLoadClient.h"
+#include "NetworkProcessCreationParameters.h"
+#include "purc_fetcher_local.h"
+#include <wtf/HashSet.h>
+#include <wtf/Lock.h>
+#include <wtf/NeverDestroyed.h>
+#include <wtf/RunLoop.h>
+#include <wtf/Threading.h>
+
+namespace PurCFetcher {
+
+class LocalNetworkLoad;
+class NetworkLoad;
+class NetworkProcess;
+class NetworkSession;
+
+// Runs the network process on a thread of the client process. The loads
+// are handed to NetworkLoad directly, nothing goes through IPC.
+class NetworkProcessLocal {
+    WTF_MAKE_NONCOPYABLE(NetworkProcessLocal);
+public:
+    static NetworkProcessLocal& singleton();
+
+    bool start(NetworkProcessCreationParameters&&);
+    bool isStarted() const { return m_runLoop; }
+    // Fails the loads in flight and joins the thread. The network process
+    // belongs to that thread, it can not be started again.
+    void stop();
+
+    uint64_t load(const char* url, const char* method, uint32_t timeout, const purc_fetcher_local_client&, void* ctxt);
+    void didFinishLoad(LocalNetworkLoad&);
+
+    void setMaxConnections(uint64_t);
+    void setCacheQuota(uint64_t);
+
+private:
+    friend class NeverDestroyed<NetworkProcessLocal>;
+    NetworkProcessLocal() = default;
+
+    void run(NetworkProcessCreationParameters&&);
+
+    // Also held to dispatch to m_runLoop, so nothing is dispatched once
+    // stop() has queued the end of the thread.
+    Lock m_startLock;
+    RefPtr<Thread> m_thread;
+    RunLoop* m_runLoop { nullptr };
+    bool m_stopped { false };
+    NetworkProcess* m_networkProcess { nullptr };
+
+    // The loads in flight, only used on the fetcher thread.
+    HashSet<LocalNetworkLoad*> m_loads;
+
+    // The other end of the connection the network process expects from its
+    // parent. Nothing is sent over it for the loads.
+    int m_parentConnectionSocket { -1 };
+
+    std::atomic<uint64_t> m_lastLoadIdentifier { 0 };
+};
+
+class LocalNetworkLoad final : public NetworkLoadClient {
+    WTF_MAKE_FAST_ALLOCATED;
+public:
+    LocalNetworkLoad(const purc_fetcher_local_client&, void* ctxt);
+    ~LocalNetworkLoad();
+
+    void start(NetworkLoadParameters&&, NetworkSession&);
+    // Called by NetworkProcessLocal::stop(), which deletes the load.
+    void cancel();
+
+private:
+    bool isSynchronous() const final { return false; }
+    bool isAllowedToAskUserForCredentials() const final { return false; }
+    void didSendData(unsigned long long, unsigned long long) final { }
+    void willSendRedirectedRequest(PurCFetcher::ResourceRequest&&, PurCFetcher::ResourceRequest&& redirectRequest, PurCFetcher::ResourceResponse&&) final;
+    void didReceiveResponse(PurCFetcher::ResourceResponse&&, ResponseCompletionHandler&&) final;
+    void didReceiveBuffer(Ref<PurCFetcher::SharedBuffer>&&, int reportedEncodedDataLength) final;
+    void didFinishLoading(const PurCFetcher::NetworkLoadMetrics&) final;
+    void didFailLoading(const PurCFetcher::ResourceError&) final;
+
+    void finish(int statusCode);
+
+    purc_fetcher_local_client m_client;
+    void* m_ctxt;
+    int m_statusCode { 0 };
+    std::unique_ptr<NetworkLoad> m_networkLoad;
+};
+
+} // namespace PurCFetcher
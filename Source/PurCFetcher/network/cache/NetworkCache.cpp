@@ -58,8 +58,12 @@ static const AtomString& resourceType()
     return resource;
 }
 
-static size_t computeCapacity(CacheModel cacheModel, const String& cachePath)
+static size_t computeCapacity(CacheModel cacheModel, uint64_t cacheQuota, const String& cachePath)
 {
+    // An explicit quota takes precedence over the one derived from the cache model.
+    if (cacheQuota)
+        return std::min<uint64_t>(cacheQuota, std::numeric_limits<size_t>::max());
+
     unsigned urlCacheMemoryCapacity = 0;
     uint64_t urlCacheDiskCapacity = 0;
     uint64_t diskFreeSize = 0;
@@ -77,7 +81,7 @@ RefPtr<Cache> Cache::open(NetworkProcess& networkProcess, const String& cachePat
     if (!FileSystem::makeAllDirectories(cachePath))
         return nullptr;
 
-    auto capacity = computeCapacity(networkProcess.cacheModel(), cachePath);
+    auto capacity = computeCapacity(networkProcess.cacheModel(), networkProcess.cacheQuota(), cachePath);
     auto storage = Storage::open(cachePath, options.contains(CacheOption::TestingMode) ? Storage::Mode::AvoidRandomness : Storage::Mode::Normal, capacity);
 
     LOG(NetworkCache, "(NetworkProcess) opened cache storage, success %d", !!storage);
@@ -119,7 +123,7 @@ size_t Cache::capacity() const
 
 void Cache::updateCapacity()
 {
-    auto newCapacity = computeCapacity(m_networkProcess->cacheModel(), m_storage->basePathIsolatedCopy());
+    auto newCapacity = computeCapacity(m_networkProcess->cacheModel(), m_networkProcess->cacheQuota(), m_storage->basePathIsolatedCopy());
     m_storage->setCapacity(newCapacity);
 }
 
@@ -75,42 +75,138 @@
 #include "FormatKeys.h"
 #include "FormatArray.h"
 
+#include <wtf/Lock.h>
+#include <wtf/NeverDestroyed.h>
+#include <wtf/TinyLRUCache.h>
+
 namespace PurCFetcher {
 
+static constexpr size_t planCacheCapacity = 32;
+
+static HashMap<String, RefPtr<FilterBase>> createFilterMap()
+{
+    Vector<RefPtr<FilterBase>> filterVec;
+    filterVec.append(adoptRef(*new LineCharsFilter()));
+    filterVec.append(adoptRef(*new LineCutFilter()));
+    filterVec.append(adoptRef(*new LineHeadFilter()));
+    filterVec.append(adoptRef(*new LineIgnoreFilter()));
+    filterVec.append(adoptRef(*new LineLettersFilter()));
+    filterVec.append(adoptRef(*new LinePickFilter()));
+    filterVec.append(adoptRef(*new LineSentencesFilter()));
+    filterVec.append(adoptRef(*new LineSplitFilter()));
+    filterVec.append(adoptRef(*new LineTailFilter()));
+    filterVec.append(adoptRef(*new LineWordsFilter()));
+
+    filterVec.append(adoptRef(*new ColumnCharsFilter()));
+    filterVec.append(adoptRef(*new ColumnCutFilter()));
+    filterVec.append(adoptRef(*new ColumnDelimiterFilter()));
+    filterVec.append(adoptRef(*new ColumnHeadFilter()));
+    filterVec.append(adoptRef(*new ColumnIgnoreFilter()));
+    filterVec.append(adoptRef(*new ColumnLettersFilter()));
+    filterVec.append(adoptRef(*new ColumnPickFilter()));
+    filterVec.append(adoptRef(*new ColumnSentencesFilter()));
+    filterVec.append(adoptRef(*new ColumnTailFilter()));
+    filterVec.append(adoptRef(*new ColumnWordsFilter()));
+
+    filterVec.append(adoptRef(*new FormatArray()));
+    filterVec.append(adoptRef(*new FormatKeys()));
+
+    HashMap<String, RefPtr<FilterBase>> filterMap;
+    for (auto& filter : filterVec)
+        filterMap.set(filter->name().convertToASCIILowercase(), filter);
+    return filterMap;
+}
+
+// The filters keep no state, one of each serves all the plans.
+static FilterBase* filterNamed(const String& name)
+{
+    static NeverDestroyed<HashMap<String, RefPtr<FilterBase>>> filterMap(createFilterMap());
+    return filterMap.get().get(name);
+}
+
+struct CmdFilterPlanCachePolicy : TinyLRUCachePolicy<String, RefPtr<CmdFilterManager>> {
+    static RefPtr<CmdFilterManager> createValueForKey(const String& cmdFilter)
+    {
+        return CmdFilterManager::compile(cmdFilter);
+    }
+};
+
+static Lock planCacheLock;
+
+Ref<CmdFilterManager> CmdFilterManager::planFor(const String& cmdFilter)
+{
+    static NeverDestroyed<TinyLRUCache<String, RefPtr<CmdFilterManager>, planCacheCapacity, CmdFilterPlanCachePolicy>> planCache;
+
+    auto locker = holdLock(planCacheLock);
+    RefPtr<CmdFilterManager> plan = planCache.get().get(cmdFilter);
+    return plan.releaseNonNull();
+}
+
+Ref<CmdFilterManager> CmdFilterManager::compile(const String& cmdFilter)
+{
+    auto plan = adoptRef(*new CmdFilterManager());
+    plan->parseCmdFilter(cmdFilter);
+    if (!plan->m_format)
+        plan->addFilter("keys", String());
+    plan->fuseStages();
+    return plan;
+}
+
 CmdFilterManager::CmdFilterManager()
 {
-    initFilterVec();
-    initNameFilterMap();
 }
 
 CmdFilterManager::~CmdFilterManager()
 {
 }
 
-bool CmdFilterManager::addFilter(String name, String param)
+void CmdFilterManager::parseCmdFilter(const String& cmdFilter)
+{
+    if (cmdFilter.isEmpty())
+        return;
+    Vector<String> params = cmdFilter.split(";");
+    int size = params.size();
+    for (int i = 0; i < size; i++)
+    {
+        size_t index = params[i].find("(");
+        if (index == notFound)
+            index = params[i].length();
+
+        String name = params[i].substring(0, index);
+        String value = params[i].substring(index + 1);
+        if (!value.isEmpty())
+        {
+            size_t idx = value.reverseFind(")");
+            if (idx != notFound)
+                value = value.substring(0, idx);
+        }
+        addFilter(name, value.stripLeadingAndTrailingCharacters(isSingleQuotes));
+    }
+}
+
+bool CmdFilterManager::addFilter(const String& name, const String& param)
 {
     if (name.isEmpty())
         return false;
 
     String nameLowerCase = name.convertToASCIILowercase().stripWhiteSpace();
-    auto findResult = m_nameFilterMap.find(nameLowerCase);
-    if(findResult == m_nameFilterMap.end())
+    FilterBase* filter = filterNamed(nameLowerCase);
+    if (!filter)
         return false;
 
-    RefPtr<FilterBase> filter = findResult->value;
     switch(filter->type())
     {
         case FilterTypeLineSplit:
         case FilterTypeLineCut:
         case FilterTypeColumnSplit:
         case FilterTypeColumnCut:
-            m_filterNameVec.append(nameLowerCase);
-            m_filterParamVec.append(param);
+            m_stages.append({ filter, filter->parseParam(param) });
             break;
 
         case FilterTypeFormat:
-            m_formatFilter.append(nameLowerCase);
-            m_formatParamFilter.append(param);
+            // the last format given is the one used
+            m_format = static_cast<FormatBase*>(filter);
+            m_formatParam = filter->parseParam(param);
             break;
 
         default:
@@ -120,104 +216,201 @@ bool CmdFilterManager::addFilter(String name, String param)
     return true;
 }
 
-Vector<Ref<JSON::Value>> CmdFilterManager::doFilter(Vector<String> lines)
+static bool isHead(FilterBase& filter)
 {
-    Vector<Ref<JSON::Value>> result;
+    return filter.name() == "head";
+}
+
+static bool isColumnHead(FilterBase& filter)
+{
+    return filter.name() == "chead";
+}
 
-    int linesSize = lines.size();
-    Vector<Vector<String>> lineListVec;
-    for (int i = 0; i < linesSize; i++) 
+void CmdFilterManager::fuseStages()
+{
+    // A head goes before the column stages, which keep the number of rows,
+    // so that they only work on the rows it keeps.
+    for (size_t i = 1; i < m_stages.size(); i++)
     {
-        Vector<String> columnVec;
-        columnVec.append(lines[i]);
-        lineListVec.append(columnVec);
+        if (!isHead(*m_stages[i].filter) || !m_stages[i].param.isValid)
+            continue;
+        for (size_t j = i; j > 0; j--)
+        {
+            FilterType type = m_stages[j - 1].filter->type();
+            if (type != FilterTypeColumnSplit && type != FilterTypeColumnCut)
+                break;
+            std::swap(m_stages[j - 1], m_stages[j]);
+        }
     }
 
-    int size = m_filterNameVec.size();
-    for (int i = 0; i < size; i++)
+    // A head after a head, or after a split of the same kind, becomes the
+    // limit of the stage before it.
+    Vector<Stage> stages;
+    for (auto& stage : m_stages)
     {
-        lineListVec = doFilterInner(lineListVec, m_filterNameVec[i], m_filterParamVec[i]);
+        if (!stages.isEmpty() && stage.param.isValid)
+        {
+            Stage& previous = stages.last();
+            FilterType type = previous.filter->type();
+            size_t limit = stage.param.left;
+            if (isHead(*stage.filter))
+            {
+                if (previous.filter == stage.filter && previous.param.isValid)
+                {
+                    previous.param.left = std::min(previous.param.left, stage.param.left);
+                    continue;
+                }
+                if (type == FilterTypeLineSplit)
+                {
+                    previous.param.outputLimit = std::min(previous.param.outputLimit, limit);
+                    continue;
+                }
+            }
+            else if (isColumnHead(*stage.filter))
+            {
+                if (previous.filter == stage.filter && previous.param.isValid)
+                {
+                    previous.param.left = std::min(previous.param.left, stage.param.left);
+                    continue;
+                }
+                if (type == FilterTypeColumnSplit)
+                {
+                    previous.param.outputLimit = std::min(previous.param.outputLimit, limit);
+                    continue;
+                }
+            }
+        }
+        stages.append(WTFMove(stage));
     }
 
-    size = lineListVec.size();
-    for (int i = 0; i < size; i++)
+    // A head first only takes the lines it keeps.
+    if (!stages.isEmpty() && isHead(*stages.first().filter) && stages.first().param.isValid)
     {
-        Ref<JSON::Value> formatResult = doFormat(lineListVec[i]);
-        result.append(WTFMove(formatResult));
+        m_lineLimit = stages.first().param.left;
+        stages.remove(0);
     }
 
-    return result;
+    m_stages = WTFMove(stages);
 }
 
-Vector<Vector<String>> CmdFilterManager::doFilterInner(Vector<Vector<String>>& lineListVec, String filterName, String filterParam)
+Ref<SharedBuffer> CmdFilterManager::doFilter(const Vector<StringView>& lines) const
 {
-    printf(".....................................doFilterInner|name=%s|param=%s|\n", filterName.characters8(), filterParam.characters8());
-    auto findResult  = m_nameFilterMap.find(filterName);
-    if(findResult == m_nameFilterMap.end())
-        return lineListVec;
+    CmdFilterPipeline pipeline(*this);
+    pipeline.pushLines(lines);
+    pipeline.finish();
+    return pipeline.takeRecords();
+}
 
-    return findResult->value->doFilter(lineListVec, filterParam);
+void CmdFilterManager::doFormat(const Row& lineColumns, JSONStreamWriter& writer) const
+{
+    m_format->doFormat(lineColumns, m_formatParam, writer);
 }
 
-Ref<JSON::Value> CmdFilterManager::doFormat(Vector<String> lineColumns)
+CmdFilterPipeline::CmdFilterPipeline(const CmdFilterManager& plan, RecordLayout layout)
+    : m_plan(plan)
+    , m_linesLeft(plan.m_lineLimit)
+    , m_layout(layout)
 {
-    String name;
-    String param;
-    int formatSize =m_formatFilter.size(); 
-    if (formatSize)
+    if (m_layout == RecordLayout::Array)
+        m_records.beginArray();
+
+    size_t stageCount = plan.m_stages.size();
+    m_cursors.reserveInitialCapacity(stageCount);
+    m_rowsLeft.reserveInitialCapacity(stageCount);
+    for (auto& stage : plan.m_stages)
     {
-        name = m_formatFilter[formatSize - 1];
-        param = m_formatParamFilter[formatSize - 1];
+        m_cursors.uncheckedAppend(stage.filter->createCursor(stage.param));
+        size_t rowsLeft = std::numeric_limits<size_t>::max();
+        if (stage.filter->type() == FilterTypeLineSplit)
+            rowsLeft = stage.param.outputLimit;
+        m_rowsLeft.uncheckedAppend(rowsLeft);
     }
-    else
+}
+
+CmdFilterPipeline::~CmdFilterPipeline()
+{
+}
+
+void CmdFilterPipeline::pushLines(const Vector<StringView>& lines)
+{
+    ASSERT(!m_finished);
+    size_t lineCount = std::min(lines.size(), m_linesLeft);
+    if (!lineCount)
+        return;
+    m_linesLeft -= lineCount;
+
+    // the cells refer to the lines, the text is only copied into the JSON
+    // and into the rows held back
+    FilterRows rows;
+    rows.reserveInitialCapacity(lineCount);
+    for (size_t i = 0; i < lineCount; i++)
+        rows.appendLine(lines[i]);
+    pushRows(rows, 0);
+}
+
+void CmdFilterPipeline::pushRows(FilterRows& rows, size_t firstStage)
+{
+    auto& stages = m_plan->m_stages;
+    for (size_t i = firstStage; i < stages.size() && !rows.isEmpty(); i++)
     {
-        name = "keys";
-        param = "";
-    }
+        if (m_cursors[i])
+        {
+            m_cursors[i]->push(rows);
+            continue;
+        }
+
+        if (m_rowsLeft[i] == std::numeric_limits<size_t>::max())
+        {
+            stages[i].filter->doFilter(rows, stages[i].param);
+            continue;
+        }
 
-    auto findResult  = m_nameFilterMap.find(name);
-    if(findResult == m_nameFilterMap.end())
-        return JSON::Value::null();
+        // the fused head counts the rows made from all the lines
+        FilterParam param = stages[i].param;
+        param.outputLimit = m_rowsLeft[i];
+        stages[i].filter->doFilter(rows, param);
+        m_rowsLeft[i] -= rows.size();
+    }
 
-    FormatBase* format = (FormatBase*)findResult->value.get();
-    return format->doFormat(lineColumns, param);
+    for (auto& row : rows)
+    {
+        m_plan->doFormat(row, m_records);
+        if (m_layout == RecordLayout::Lines)
+            m_records.endLine();
+    }
+    m_recordCount += rows.size();
 }
 
-void CmdFilterManager::initFilterVec()
+void CmdFilterPipeline::finish()
 {
-    m_filterVec.append(adoptRef(*new LineCharsFilter()));
-    m_filterVec.append(adoptRef(*new LineCutFilter()));
-    m_filterVec.append(adoptRef(*new LineHeadFilter()));
-    m_filterVec.append(adoptRef(*new LineIgnoreFilter()));
-    m_filterVec.append(adoptRef(*new LineLettersFilter()));
-    m_filterVec.append(adoptRef(*new LinePickFilter()));
-    m_filterVec.append(adoptRef(*new LineSentencesFilter()));
-    m_filterVec.append(adoptRef(*new LineSplitFilter()));
-    m_filterVec.append(adoptRef(*new LineTailFilter()));
-    m_filterVec.append(adoptRef(*new LineWordsFilter()));
+    if (m_finished)
+        return;
+    m_finished = true;
 
-    m_filterVec.append(adoptRef(*new ColumnCharsFilter()));
-    m_filterVec.append(adoptRef(*new ColumnCutFilter()));
-    m_filterVec.append(adoptRef(*new ColumnDelimiterFilter()));
-    m_filterVec.append(adoptRef(*new ColumnHeadFilter()));
-    m_filterVec.append(adoptRef(*new ColumnIgnoreFilter()));
-    m_filterVec.append(adoptRef(*new ColumnLettersFilter()));
-    m_filterVec.append(adoptRef(*new ColumnPickFilter()));
-    m_filterVec.append(adoptRef(*new ColumnSentencesFilter()));
-    m_filterVec.append(adoptRef(*new ColumnTailFilter()));
-    m_filterVec.append(adoptRef(*new ColumnWordsFilter()));
+    for (size_t i = 0; i < m_cursors.size(); i++)
+    {
+        if (!m_cursors[i])
+            continue;
+        FilterRows rows;
+        m_cursors[i]->finish(rows);
+        pushRows(rows, i + 1);
+    }
 
-    m_filterVec.append(adoptRef(*new FormatArray()));
-    m_filterVec.append(adoptRef(*new FormatKeys()));
+    if (m_layout == RecordLayout::Array)
+        m_records.endArray();
 }
 
-void CmdFilterManager::initNameFilterMap()
+bool CmdFilterPipeline::isSatisfied() const
 {
-    int size = m_filterVec.size();
-    for (int i = 0; i < size; i++)
+    if (!m_linesLeft)
+        return true;
+
+    for (size_t i = 0; i < m_cursors.size(); i++)
     {
-        m_nameFilterMap.set(m_filterVec[i]->name().convertToASCIILowercase(), m_filterVec[i]);
+        if (m_cursors[i] ? m_cursors[i]->isDone() : !m_rowsLeft[i])
+            return true;
     }
+    return false;
 }
 
 } // namespace PurCFetcher
@@ -51,34 +51,96 @@
 #include "NetworkDataTask.h"
 #include "FilterBase.h"
 #include "FormatBase.h"
+#include <wtf/ThreadSafeRefCounted.h>
 
 namespace PurCFetcher {
 
-class CmdFilterManager : public RefCounted<CmdFilterManager> {
+// A cmdfilter expression, like "split(' ');head(10);keys('a,b')", compiled
+// once: the filters are resolved, their parameters parsed, and the stages
+// which can go together are fused. A plan does not change once compiled,
+// so the requests with the same expression share it.
+class CmdFilterManager : public ThreadSafeRefCounted<CmdFilterManager> {
 public:
-    CmdFilterManager();
+    // The plan of the expression, from the cache of the plans used last.
+    static Ref<CmdFilterManager> planFor(const String& cmdFilter);
+
+    // Compiles the expression, without the cache.
+    static Ref<CmdFilterManager> compile(const String& cmdFilter);
+
     ~CmdFilterManager();
 
-public:
-    bool addFilter(String name, String param);
-    Vector<Ref<JSON::Value>> doFilter(Vector<String> lines);
+    // Filters all the lines at once, into the JSON array of the records.
+    Ref<SharedBuffer> doFilter(const Vector<StringView>& lines) const;
 
 private:
-    void initFilterVec();
-    void initNameFilterMap();
+    friend class CmdFilterPipeline;
+
+    CmdFilterManager();
+
+    void parseCmdFilter(const String& cmdFilter);
+    bool addFilter(const String& name, const String& param);
+    void fuseStages();
+
+    void doFormat(const Row& lineColumns, JSONStreamWriter&) const;
+
+    struct Stage {
+        FilterBase* filter;
+        FilterParam param;
+    };
+
+    Vector<Stage> m_stages;
 
-    Vector<Vector<String>> doFilterInner(Vector<Vector<String>>& lineListVec, String filterName, String filterParam);
-    Ref<JSON::Value> doFormat(Vector<String> lineColumns);
+    FormatBase* m_format { nullptr };
+    FilterParam m_formatParam;
+
+    // a head fused into the reading of the lines
+    size_t m_lineLimit { std::numeric_limits<size_t>::max() };
+};
+
+// A plan running on the output of one command. The lines are pushed through
+// the stages as they are read, and come out as records, written as JSON as
+// soon as they are made; the filters which pick rows by their position keep
+// their own state, the tail holding only the rows it may keep.
+class CmdFilterPipeline {
+    WTF_MAKE_NONCOPYABLE(CmdFilterPipeline);
+    WTF_MAKE_FAST_ALLOCATED;
+public:
+    // The records go in one JSON array, or one in each line, as in NDJSON.
+    enum class RecordLayout : uint8_t { Array, Lines };
+
+    explicit CmdFilterPipeline(const CmdFilterManager&, RecordLayout = RecordLayout::Array);
+    ~CmdFilterPipeline();
+
+    // The lines may be gone once this returns: the rows held back by the
+    // stages have their own copy.
+    void pushLines(const Vector<StringView>& lines);
+
+    // The output is over: the rows held back go through the stages left.
+    void finish();
+
+    // No line read later can make a record: the command can be stopped.
+    bool isSatisfied() const;
+
+    // The JSON of the records made since the last call. The array is only
+    // complete once finished.
+    Ref<SharedBuffer> takeRecords() { return m_records.take(); }
+    size_t recordCount() const { return m_recordCount; }
 
 private:
-    HashMap<String, RefPtr<FilterBase>> m_nameFilterMap;
-    Vector<RefPtr<FilterBase>> m_filterVec;
+    void pushRows(FilterRows&, size_t firstStage);
+
+    Ref<const CmdFilterManager> m_plan;
 
-    Vector<String> m_formatFilter;
-    Vector<String> m_formatParamFilter;
+    // one for each stage, null if the filter keeps no state
+    Vector<std::unique_ptr<FilterCursor>> m_cursors;
+    // the rows a split may still make, with a head fused into it
+    Vector<size_t> m_rowsLeft;
+    size_t m_linesLeft;
 
-    Vector<String> m_filterNameVec;
-    Vector<String> m_filterParamVec;
+    RecordLayout m_layout;
+    JSONStreamWriter m_records;
+    size_t m_recordCount { 0 };
+    bool m_finished { false };
 };
 
 } // namespace PurCFetcher
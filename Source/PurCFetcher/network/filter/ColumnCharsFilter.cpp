@@ -61,50 +61,16 @@ ColumnCharsFilter::~ColumnCharsFilter()
 {
 }
 
-Vector<String> ColumnCharsFilter::filterInnter(Vector<String> lines, String param)
+void ColumnCharsFilter::doFilter(FilterRows& rows, const FilterParam& param)
 {
-    if (lines.size() == 0)
-        return lines;
-
-    Vector<String> result;
-    size_t size = lines.size();
-    for (size_t i = 0; i < size; i++)
-    {
-        result.appendVector(splitLine(lines[i], param));
-    }
-    return result;
-}
-
-Vector<String> ColumnCharsFilter::splitLine(String line, String)
-{
-    if (line.isEmpty())
-    {
-        Vector<String> result;
-        return result;
-    }
-
-    return splitUTF8((const char*)line.characters8(), (const char*)line.characters8() + line.length());
-}
-
-Vector<Row> ColumnCharsFilter::doFilter(Vector<Row> rowVec, String param)
-{
-    if (rowVec.size() == 0)
-        return rowVec;
-
-    Vector<Row> result;
-    size_t size = rowVec.size();
-    for (size_t i = 0; i < size; i++)
+    Row characters;
+    for (auto& row : rows)
     {
-        result.appendVector(splitRow(rowVec[i], param));
+        characters.shrink(0);
+        for (auto& cell : row)
+            splitUTF8(cell, characters, false, param.outputLimit);
+        row.swap(characters);
     }
-    return result;
-}
-
-Vector<Row> ColumnCharsFilter::splitRow(Row& row, String param)
-{
-    Vector<Row> result;
-    result.append(filterInnter(row, param));
-    return result;
 }
 
 } // namespace PurCFetcher
@@ -61,72 +61,13 @@ ColumnCutFilter::~ColumnCutFilter()
 {
 }
 
-Vector<String> ColumnCutFilter::doFilterInner(Vector<String> lines, String param)
+void ColumnCutFilter::doFilter(FilterRows& rows, const FilterParam& param)
 {
-    if (lines.size() == 0 || param.isEmpty())
-        return lines;
+    if (!param.isValid)
+        return;
 
-    Vector<String> paramVec = param.split(",");
-    if (paramVec.size() < 2)
-    {
-        return lines;
-    }
-
-    String sleft = paramVec[0].stripWhiteSpace();
-    String sright = paramVec[1].stripWhiteSpace();
-
-    bool success = false;
-    int left = sleft.toInt(&success);
-    if (!success)
-    {
-        return lines;
-    }
-
-    int right = sright.toInt(&success);
-    if (!success)
-    {
-        return lines;
-    }
-
-    int size = lines.size();
-    int i = 0;
-    int n = left * i + right;
-    Vector<int> indexVec;
-    while(n < size)
-    {
-        if (n >= 0)
-        {
-            indexVec.append(n);
-        }
-        i++;
-        n = left * i + right;
-    }
-    
-    Vector<String> result;
-    for(int i = 0; i < size; i++)
-    {
-        if (indexVec.contains(i))
-        {
-            continue;
-        }
-        result.append(lines[i]);
-    }
-
-    return result;
-}
-
-Vector<Row> ColumnCutFilter::doFilter(Vector<Row> rowVec, String param)
-{
-    if (rowVec.size() == 0)
-        return rowVec;
-
-    Vector<Row> result;
-    size_t size = rowVec.size();
-    for (size_t i = 0; i < size; i++)
-    {
-        result.append(doFilterInner(rowVec[i], param));
-    }
-    return result;
+    for (auto& row : rows)
+        keepPickedPositions(row, pickedPositions(param.left, param.right, row.size()), false);
 }
 
 } // namespace PurCFetcher
@@ -60,10 +60,8 @@ public:
     virtual ~ColumnCutFilter();
     virtual String name() { return "ccut"; }
     virtual FilterType type()  { return FilterTypeColumnCut; }
-    virtual Vector<Row> doFilter(Vector<Row> rowVec, String param);
-
-private:
-    Vector<String> doFilterInner(Vector<String> lines, String param);
+    virtual FilterParam parseParam(const String& param) { return parseStepParam(param); }
+    virtual void doFilter(FilterRows& rows, const FilterParam& param);
 };
 
 } // namespace PurCFetcher
@@ -61,52 +61,28 @@ ColumnDelimiterFilter::~ColumnDelimiterFilter()
 {
 }
 
-Vector<String> ColumnDelimiterFilter::filterInnter(Vector<String> lines, String param)
+void ColumnDelimiterFilter::doFilter(FilterRows& rows, const FilterParam& param)
 {
-    if (lines.size() == 0)
-        return lines;
-
-    Vector<String> result;
-    size_t size = lines.size();
-    for (size_t i = 0; i < size; i++)
-    {
-        result.appendVector(splitLine(lines[i], param));
-    }
-    return result;
-}
-
-Vector<String> ColumnDelimiterFilter::splitLine(String line, String param)
-{
-    if (param.length() > 1)
-    {
-        Vector<String> result = line.split(param[0]);
-        return filterInnter(result, param.substring(1, param.length() - 1));
-    }
-    else
+    if (param.text.isEmpty())
     {
-        return  line.split(param);
+        // nothing to split, only a fused chead to apply
+        for (auto& row : rows)
+        {
+            if (row.size() > param.outputLimit)
+                row.shrink(param.outputLimit);
+        }
+        return;
     }
-}
-
-Vector<Row> ColumnDelimiterFilter::doFilter(Vector<Row> rowVec, String param)
-{
-    if (param.isEmpty() || rowVec.size() == 0)
-        return rowVec;
 
-    Vector<Row> result;
-    size_t size = rowVec.size();
-    for (size_t i = 0; i < size; i++)
+    // each of the characters of the parameter splits the columns
+    Row columns;
+    for (auto& row : rows)
     {
-        result.appendVector(splitRow(rowVec[i], param));
+        columns.shrink(0);
+        for (auto& cell : row)
+            splitByCharacters(cell, param.delimiters, columns, param.outputLimit);
+        row.swap(columns);
     }
-    return result;
-}
-
-Vector<Row> ColumnDelimiterFilter::splitRow(Row& row, String param)
-{
-    Vector<Row> result;
-    result.append(filterInnter(row, param));
-    return result;
 }
 
 } // namespace PurCFetcher
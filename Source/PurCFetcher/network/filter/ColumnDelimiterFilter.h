@@ -60,13 +60,8 @@ public:
     virtual ~ColumnDelimiterFilter();
     virtual String name() { return "delimiter"; }
     virtual FilterType type()  { return FilterTypeColumnSplit; }
-    virtual Vector<Row> doFilter(Vector<Row> rowVec, String param);
-
-private:
-    Vector<String> filterInnter(Vector<String> lines, String param);
-    Vector<String> splitLine(String line, String param);
-
-    Vector<Row> splitRow(Row& row, String param);
+    virtual FilterParam parseParam(const String& param) { return parseDelimiterParam(param); }
+    virtual void doFilter(FilterRows& rows, const FilterParam& param);
 };
 
 } // namespace PurCFetcher
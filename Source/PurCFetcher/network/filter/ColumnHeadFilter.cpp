@@ -61,38 +61,16 @@ ColumnHeadFilter::~ColumnHeadFilter()
 {
 }
 
-Vector<String> ColumnHeadFilter::doFilterInner(Vector<String> lines, String param)
+void ColumnHeadFilter::doFilter(FilterRows& rows, const FilterParam& param)
 {
-    if (lines.size() == 0 || param.isEmpty())
-        return lines;
+    if (!param.isValid)
+        return;
 
-    bool success = false;
-    int limit = param.toInt(&success);
-    if (!success)
+    for (auto& row : rows)
     {
-        return lines;
+        if (row.size() > static_cast<size_t>(param.left))
+            row.shrink(param.left);
     }
-
-    int size = lines.size();
-    if (size > limit)
-    {
-        lines.shrink(limit);
-    }
-    return lines;
-}
-
-Vector<Row> ColumnHeadFilter::doFilter(Vector<Row> rowVec, String param)
-{
-    if (rowVec.size() == 0)
-        return rowVec;
-
-    Vector<Row> result;
-    size_t size = rowVec.size();
-    for (size_t i = 0; i < size; i++)
-    {
-        result.append(doFilterInner(rowVec[i], param));
-    }
-    return result;
 }
 
 } // namespace PurCFetcher
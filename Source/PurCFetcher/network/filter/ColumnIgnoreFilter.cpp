@@ -61,75 +61,18 @@ ColumnIgnoreFilter::~ColumnIgnoreFilter()
 {
 }
 
-Vector<String> ColumnIgnoreFilter::doFilterInner(Vector<String> lines, String param)
+void ColumnIgnoreFilter::doFilter(FilterRows& rows, const FilterParam& param)
 {
-    if (lines.size() == 0 || param.isEmpty())
-        return lines;
+    if (!param.isValid)
+        return;
 
-    Vector<String> paramVec = param.split(",");
-    if (paramVec.size() < 2)
+    // "$" is the last column of each row
+    for (auto& row : rows)
     {
-        return lines;
+        if (row.isEmpty())
+            continue;
+        removeIgnoredPositions(row, param.fromLast ? static_cast<int>(row.size()) - 1 : param.left, param.right);
     }
-
-    String begin = paramVec[0].stripWhiteSpace();
-    String size = paramVec[1].stripWhiteSpace();
-
-    bool success = false;
-    int limit = size.toInt(&success);
-    if (!success)
-    {
-        return lines;
-    }
-
-    size_t start = begin.toInt(&success);
-    if (!success)
-    {
-        if (equalIgnoringASCIICase(begin, "$"))
-        {
-            start = lines.size() - 1;
-        }
-        else
-        {
-            return lines;
-        }
-    }
-
-    Vector<String> result;
-    if (limit == 0)
-    {
-        return result;
-    }
-
-    int ignoreBegin = limit > 0 ? start : start + limit + 1;
-    int ignoreSize = abs(limit);
-
-    if (start > lines.size())
-    {
-        return lines;
-    }
-
-    result.append(lines.data(), ignoreBegin);
-    if ((ignoreBegin + ignoreSize) < (int)lines.size())
-    {
-        result.append(lines.data() + ignoreBegin + ignoreSize, lines.size() - ignoreBegin - ignoreSize);
-    }
-
-    return result;
-}
-
-Vector<Row> ColumnIgnoreFilter::doFilter(Vector<Row> rowVec, String param)
-{
-    if (rowVec.size() == 0)
-        return rowVec;
-
-    Vector<Row> result;
-    size_t size = rowVec.size();
-    for (size_t i = 0; i < size; i++)
-    {
-        result.append(doFilterInner(rowVec[i], param));
-    }
-    return result;
 }
 
 } // namespace PurCFetcher
@@ -60,9 +60,8 @@ public:
     virtual ~ColumnIgnoreFilter();
     virtual String name() { return "cignore"; }
     virtual FilterType type()  { return FilterTypeColumnCut; }
-    virtual Vector<Row> doFilter(Vector<Row> rowVec, String param);
-private:
-    Vector<String> doFilterInner(Vector<String> lines, String param);
+    virtual FilterParam parseParam(const String& param) { return parseIgnoreParam(param); }
+    virtual void doFilter(FilterRows& rows, const FilterParam& param);
 };
 
 } // namespace PurCFetcher
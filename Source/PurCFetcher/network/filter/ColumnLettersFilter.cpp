@@ -63,76 +63,16 @@ ColumnLettersFilter::~ColumnLettersFilter()
 {
 }
 
-Vector<String> ColumnLettersFilter::filterInnter(Vector<String> lines, String param)
+void ColumnLettersFilter::doFilter(FilterRows& rows, const FilterParam& param)
 {
-    if (lines.size() == 0)
-        return lines;
-
-    Vector<String> result;
-    size_t size = lines.size();
-    for (size_t i = 0; i < size; i++)
-    {
-        result.appendVector(splitLine(lines[i], param));
-    }
-
-    size = result.size();
-    if (!size)
-        return result;
-
-    Vector<String> res;
-    for (size_t i = 0; i < size; i++)
-    {
-        switch(g_unichar_type(g_utf8_get_char((const char*)result[i].characters8())))
-        {
-            case G_UNICODE_LOWERCASE_LETTER:
-            case G_UNICODE_MODIFIER_LETTER:
-            case G_UNICODE_OTHER_LETTER:
-            case G_UNICODE_TITLECASE_LETTER:
-            case G_UNICODE_UPPERCASE_LETTER:
-            case G_UNICODE_DECIMAL_NUMBER:
-            case G_UNICODE_LETTER_NUMBER:
-            case G_UNICODE_OTHER_NUMBER:
-                res.append(result[i]);
-                break;
-
-            default:
-                break;
-        }
-    }
-
-    return res;
-}
-
-Vector<String> ColumnLettersFilter::splitLine(String line, String)
-{
-    if (line.isEmpty())
+    Row characters;
+    for (auto& row : rows)
     {
-        Vector<String> result;
-        return result;
+        characters.shrink(0);
+        for (auto& cell : row)
+            splitUTF8(cell, characters, true, param.outputLimit);
+        row.swap(characters);
     }
-
-    return splitUTF8((const char*)line.characters8(), (const char*)line.characters8() + line.length());
-}
-
-Vector<Row> ColumnLettersFilter::doFilter(Vector<Row> rowVec, String param)
-{
-    if (rowVec.size() == 0)
-        return rowVec;
-
-    Vector<Row> result;
-    size_t size = rowVec.size();
-    for (size_t i = 0; i < size; i++)
-    {
-        result.appendVector(splitRow(rowVec[i], param));
-    }
-    return result;
-}
-
-Vector<Row> ColumnLettersFilter::splitRow(Row& row, String param)
-{
-    Vector<Row> result;
-    result.append(filterInnter(row, param));
-    return result;
 }
 
 } // namespace PurCFetcher
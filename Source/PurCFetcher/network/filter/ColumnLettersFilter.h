@@ -60,12 +60,7 @@ public:
     virtual ~ColumnLettersFilter();
     virtual String name() { return "cletters"; }
     virtual FilterType type()  { return FilterTypeColumnSplit; }
-    virtual Vector<Row> doFilter(Vector<Row> rowVec, String param);
-
-private:
-    Vector<String> filterInnter(Vector<String> lines, String param);
-    Vector<String> splitLine(String line, String param);
-    Vector<Row> splitRow(Row& row, String param);
+    virtual void doFilter(FilterRows& rows, const FilterParam& param);
 };
 
 } // namespace PurCFetcher
@@ -60,9 +60,8 @@ public:
     virtual ~ColumnPickFilter();
     virtual String name() { return "cpick"; }
     virtual FilterType type()  { return FilterTypeColumnCut; }
-    virtual Vector<Row> doFilter(Vector<Row> rowVec, String param);
-private:
-    virtual Vector<String> doFilterInner(Vector<String> lines, String param);
+    virtual FilterParam parseParam(const String& param) { return parseStepParam(param); }
+    virtual void doFilter(FilterRows& rows, const FilterParam& param);
 };
 
 } // namespace PurCFetcher
@@ -50,6 +50,8 @@
 #include <stdio.h>
 #include "ColumnSentencesFilter.h"
 
+#include "TextSegmenter.h"
+
 namespace PurCFetcher {
 using namespace PurCFetcher;
 
@@ -64,109 +66,23 @@ ColumnSentencesFilter::~ColumnSentencesFilter()
 {
 }
 
-Vector<String> ColumnSentencesFilter::filterInnter(Vector<String> lines)
+void ColumnSentencesFilter::doFilter(FilterRows& rows, const FilterParam& param)
 {
-    if (lines.size() == 0)
-        return lines;
-
-    Vector<String> result;
-    size_t size = lines.size();
-    for (size_t i = 0; i < size; i++)
+    TextSegmenter segmenter;
+    Row sentences;
+    for (auto& row : rows)
     {
-        result.appendVector(splitLine(lines[i]));
-    }
-    return result;
-}
-
-Vector<String> ColumnSentencesFilter::splitLine(String line)
-{
-    Vector<String> result;
-    if (line.isEmpty())
-    {
-        return result;
-    }
-
-    const char* source = (const char*)line.characters8();
-    UCharBreaker breaker(source);
-    const gunichar* gucharSource = breaker.getUChar();
-    int gucharSourceLen = breaker.getUCharLen();
-    const struct UCharBreakAttr* breakAttrs = breaker.getBreakAttrs();
-
-    const gunichar* p = gucharSource;
-    const gunichar* pEnd = gucharSource + gucharSourceLen; 
-    int i = 0;
-
-    StringBuilder sb;
-    while(p < pEnd)
-    {
-        char buf[6] = {0};
-        gunichar wc = *p;
-        g_unichar_to_utf8(wc, buf);
-        bool isLetterOrNumber = false;
-        switch(g_unichar_type(wc))
+        sentences.shrink(0);
+        for (auto& cell : row)
         {
-            case G_UNICODE_LOWERCASE_LETTER:
-            case G_UNICODE_MODIFIER_LETTER:
-            case G_UNICODE_OTHER_LETTER:
-            case G_UNICODE_TITLECASE_LETTER:
-            case G_UNICODE_UPPERCASE_LETTER:
-            case G_UNICODE_DECIMAL_NUMBER:
-            case G_UNICODE_LETTER_NUMBER:
-            case G_UNICODE_OTHER_NUMBER:
-                isLetterOrNumber = true;
-                break;
-
-            default:
+            if (sentences.size() >= param.outputLimit)
                 break;
+            segmenter.appendSentences(cell, rows, sentences);
         }
-
-        if (breakAttrs[i].is_sentence_boundary)
-        {
-            if (sb.length())
-            {
-                result.append(sb.toString());
-                sb.clear();
-            }
-            if (isLetterOrNumber)
-                sb.append(buf);
-        }
-        else
-        {
-            sb.append(buf);
-        }
-
-	    p++;
-        i++;
-    }
-
-    if (sb.length())
-    {
-        result.append(sb.toString());
-    }
-    return result;
-}
-
-Vector<Row> ColumnSentencesFilter::doFilter(Vector<Row> rowVec, String param)
-{
-    m_lang = param.isEmpty() ? "en" : param;
-
-    if (rowVec.size() == 0)
-        return rowVec;
-
-    Vector<Row> result;
-    size_t size = rowVec.size();
-    for (size_t i = 0; i < size; i++)
-    {
-        result.appendVector(splitRow(rowVec[i], param));
+        if (sentences.size() > param.outputLimit)
+            sentences.shrink(param.outputLimit);
+        row.swap(sentences);
     }
-    return result;
-}
-
-Vector<Row> ColumnSentencesFilter::splitRow(Row& row, String)
-{
-    Vector<Row> result;
-    result.append(filterInnter(row));
-    return result;
 }
 
 } // namespace PurCFetcher
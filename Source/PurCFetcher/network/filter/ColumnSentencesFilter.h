@@ -60,15 +60,7 @@ public:
     virtual ~ColumnSentencesFilter();
     virtual String name() { return "csentences"; }
     virtual FilterType type()  { return FilterTypeColumnSplit; }
-    virtual Vector<Row> doFilter(Vector<Row> rowVec, String param);
-
-private:
-    Vector<String> filterInnter(Vector<String> lines);
-    Vector<String> splitLine(String line);
-    Vector<Row> splitRow(Row& row, String param);
-
-private:
-    String m_lang;
+    virtual void doFilter(FilterRows& rows, const FilterParam& param);
 };
 
 } // namespace PurCFetcher
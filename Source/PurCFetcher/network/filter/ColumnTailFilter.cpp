@@ -61,40 +61,16 @@ ColumnTailFilter::~ColumnTailFilter()
 {
 }
 
-Vector<String> ColumnTailFilter::doFilterInner(Vector<String> lines, String param)
+void ColumnTailFilter::doFilter(FilterRows& rows, const FilterParam& param)
 {
-    if (lines.size() == 0 || param.isEmpty())
-        return lines;
+    if (!param.isValid)
+        return;
 
-    bool success = false;
-    int limit = param.toInt(&success);
-    if (!success)
+    for (auto& row : rows)
     {
-        return lines;
+        if (row.size() > static_cast<size_t>(param.left))
+            row.remove(0, row.size() - param.left);
     }
-
-    int size = lines.size();
-    if (size < limit)
-    {
-        return lines;
-    }
-    Vector<String> result;
-    result.append(lines.data() + size - limit, limit);
-    return result;
-}
-
-Vector<Row> ColumnTailFilter::doFilter(Vector<Row> rowVec, String param)
-{
-    if (rowVec.size() == 0)
-        return rowVec;
-
-    Vector<Row> result;
-    size_t size = rowVec.size();
-    for (size_t i = 0; i < size; i++)
-    {
-        result.append(doFilterInner(rowVec[i], param));
-    }
-    return result;
 }
 
 } // namespace PurCFetcher
@@ -60,9 +60,8 @@ public:
     virtual ~ColumnTailFilter();
     virtual String name() { return "ctail"; }
     virtual FilterType type()  { return FilterTypeColumnCut; }
-    virtual Vector<Row> doFilter(Vector<Row> rowVec, String param);
-private:
-    Vector<String> doFilterInner(Vector<String> lines, String param);
+    virtual FilterParam parseParam(const String& param) { return parseLimitParam(param); }
+    virtual void doFilter(FilterRows& rows, const FilterParam& param);
 };
 
 } // namespace PurCFetcher
@@ -50,6 +50,8 @@
 #include <stdio.h>
 #include "ColumnWordsFilter.h"
 
+#include "TextSegmenter.h"
+
 namespace PurCFetcher {
 using namespace PurCFetcher;
 
@@ -61,110 +63,23 @@ ColumnWordsFilter::~ColumnWordsFilter()
 {
 }
 
-Vector<String> ColumnWordsFilter::filterInnter(Vector<String> lines, String param)
-{
-    if (lines.size() == 0)
-        return lines;
-
-    Vector<String> result;
-    size_t size = lines.size();
-    for (size_t i = 0; i < size; i++)
-    {
-        result.appendVector(splitLine(lines[i], param));
-    }
-    return result;
-}
-
-Vector<String> ColumnWordsFilter::splitLine(String line, String)
+void ColumnWordsFilter::doFilter(FilterRows& rows, const FilterParam& param)
 {
-    Vector<String> result;
-    if (line.isEmpty())
-    {
-        return result;
-    }
-
-    const char* source = (const char*)line.characters8();
-    UCharBreaker breaker(source);
-    const gunichar* gucharSource = breaker.getUChar();
-    int gucharSourceLen = breaker.getUCharLen();
-    const struct UCharBreakAttr* breakAttrs = breaker.getBreakAttrs();
-
-    const gunichar* p = gucharSource;
-    const gunichar* pEnd = gucharSource + gucharSourceLen; 
-    int i = 0;
-
-    StringBuilder sb;
-    while(p < pEnd)
+    TextSegmenter segmenter;
+    Row words;
+    for (auto& row : rows)
     {
-        char buf[6] = {0};
-        gunichar wc = *p;
-        g_unichar_to_utf8(wc, buf);
-        bool save = false;
-        switch(g_unichar_type(wc))
+        words.shrink(0);
+        for (auto& cell : row)
         {
-            case G_UNICODE_LOWERCASE_LETTER:
-            case G_UNICODE_MODIFIER_LETTER:
-            case G_UNICODE_OTHER_LETTER:
-            case G_UNICODE_TITLECASE_LETTER:
-            case G_UNICODE_UPPERCASE_LETTER:
-            case G_UNICODE_DECIMAL_NUMBER:
-            case G_UNICODE_LETTER_NUMBER:
-            case G_UNICODE_OTHER_NUMBER:
-                save = true;
+            if (words.size() >= param.outputLimit)
                 break;
-
-            default:
-                if (!(breakAttrs[i].is_word_boundary))
-                    save = true;
-                break;
-        }
-
-        if (save)
-        {
-            if (breakAttrs[i].is_word_boundary)
-            {
-                if (sb.length())
-                {
-                    result.append(sb.toString());
-                    sb.clear();
-                }
-            }
-            sb.append(buf);
+            segmenter.appendWords(cell, rows, words);
         }
-
-	    p++;
-        i++;
-    }
-
-    if (sb.length())
-    {
-        result.append(sb.toString());
-    }
-
-    return result;
-}
-
-Vector<Row> ColumnWordsFilter::doFilter(Vector<Row> rowVec, String param)
-{
-    m_lang = param.isEmpty() ? "en" : param;
-
-    if (rowVec.size() == 0)
-        return rowVec;
-
-    Vector<Row> result;
-    size_t size = rowVec.size();
-    for (size_t i = 0; i < size; i++)
-    {
-        result.appendVector(splitRow(rowVec[i], param));
+        if (words.size() > param.outputLimit)
+            words.shrink(param.outputLimit);
+        row.swap(words);
     }
-    return result;
-}
-
-Vector<Row> ColumnWordsFilter::splitRow(Row& row, String param)
-{
-    Vector<Row> result;
-    result.append(filterInnter(row, param));
-    return result;
 }
 
 } // namespace PurCFetcher
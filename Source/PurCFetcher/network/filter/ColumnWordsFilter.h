@@ -60,15 +60,7 @@ public:
     virtual ~ColumnWordsFilter();
     virtual String name() { return "cwords"; }
     virtual FilterType type()  { return FilterTypeColumnSplit; }
-    virtual Vector<Row> doFilter(Vector<Row> rowVec, String param);
-
-private:
-    Vector<String> filterInnter(Vector<String> lines, String param);
-    Vector<String> splitLine(String line, String param);
-    Vector<Row> splitRow(Row& row, String param);
-
-private:
-    String m_lang;
+    virtual void doFilter(FilterRows& rows, const FilterParam& param);
 };
 
 } // namespace PurCFetcher
@@ -0,0 +1,161 @@
+/* 
+ * Copyright (C) 2020 Beijing FMSoft Technologies Co., Ltd.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ * 
+ * Or,
+ * 
+ * As this component is a program released under LGPLv3, which claims
+ * explicitly that the program could be modified by any end user
+ * even if the program is conveyed in non-source form on the system it runs.
+ * Generally, if you distribute this program in embedded devices,
+ * you might not satisfy this condition. Under this situation or you can
+ * not accept any condition of LGPLv3, you need to get a commercial license
+ * from FMSoft, along with a patent license for the patents owned by FMSoft.
+ * 
+ * If you have got a commercial/patent license of this program, please use it
+ * under the terms and conditions of the commercial license.
+ * 
+ * For more information about the commercial license and patent license,
+ * please refer to
+ * <https://hybridos.fmsoft.cn/blog/hybridos-licensing-policy/>.
+ * 
+ * Also note that the LGPLv3 license does not apply to any entity in the
+ * Exception List published by Beijing FMSoft Technologies Co., Ltd.
+ * 
+ * If you are or the entity you represent is listed in the Exception List,
+ * the above open source or free software license does not apply to you
+ * or the entity you represent. Regardless of the purpose, you should not
+ * use the software in any way whatsoever, including but not limited to
+ * downloading, viewing, copying, distributing, compiling, and running.
+ * If you have already downloaded it, you MUST destroy all of its copies.
+ * 
+ * The Exception List is published by FMSoft and may be updated
+ * from time to time. For more information, please see
+ * <https://www.fmsoft.cn/exception-list>.
+ */ 
+
+#include "config.h"
+#include "DelimiterSet.h"
+
+#include <wtf/MathExtras.h>
+
+#if CPU(X86_SSE2)
+#include <emmintrin.h>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+#elif (CPU(ARM64) || CPU(ARM_NEON)) && !CPU(BIG_ENDIAN)
+#include <arm_neon.h>
+#endif
+
+namespace PurCFetcher {
+
+DelimiterSet::DelimiterSet(const String& delimiters)
+    : m_delimiters(delimiters)
+{
+    for (unsigned i = 0; i < delimiters.length(); i++) {
+        // the others can only be in 16-bit text
+        UChar character = delimiters[i];
+        if (character > 0xFF)
+            continue;
+        if (m_isLatin1Delimiter[character])
+            continue;
+        m_isLatin1Delimiter[character] = true;
+        m_vectorDelimiters.append(character);
+    }
+
+    // too many to compare with, the table is faster
+    if (m_vectorDelimiters.size() > maximumVectorDelimiters)
+        m_vectorDelimiters.clear();
+}
+
+size_t DelimiterSet::find(StringView text, size_t start) const
+{
+    if (text.is8Bit())
+        return find(text.characters8(), start, text.length());
+    return find(text.characters16(), start, text.length());
+}
+
+size_t DelimiterSet::find(const LChar* characters, size_t start, size_t length) const
+{
+    size_t i = start;
+    size_t count = m_vectorDelimiters.size();
+
+#if CPU(X86_SSE2)
+    if (count) {
+#if defined(__AVX2__)
+        __m256i wideNeedles[maximumVectorDelimiters];
+        for (size_t d = 0; d < count; d++)
+            wideNeedles[d] = _mm256_set1_epi8(m_vectorDelimiters[d]);
+        for (; i + 32 <= length; i += 32) {
+            __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(characters + i));
+            __m256i matches = _mm256_cmpeq_epi8(chunk, wideNeedles[0]);
+            for (size_t d = 1; d < count; d++)
+                matches = _mm256_or_si256(matches, _mm256_cmpeq_epi8(chunk, wideNeedles[d]));
+            uint32_t mask = _mm256_movemask_epi8(matches);
+            if (mask)
+                return i + ctz(mask);
+        }
+#endif
+        __m128i needles[maximumVectorDelimiters];
+        for (size_t d = 0; d < count; d++)
+            needles[d] = _mm_set1_epi8(m_vectorDelimiters[d]);
+        for (; i + 16 <= length; i += 16) {
+            __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(characters + i));
+            __m128i matches = _mm_cmpeq_epi8(chunk, needles[0]);
+            for (size_t d = 1; d < count; d++)
+                matches = _mm_or_si128(matches, _mm_cmpeq_epi8(chunk, needles[d]));
+            uint32_t mask = _mm_movemask_epi8(matches);
+            if (mask)
+                return i + ctz(mask);
+        }
+    }
+#elif (CPU(ARM64) || CPU(ARM_NEON)) && !CPU(BIG_ENDIAN)
+    if (count) {
+        uint8x16_t needles[maximumVectorDelimiters];
+        for (size_t d = 0; d < count; d++)
+            needles[d] = vdupq_n_u8(m_vectorDelimiters[d]);
+        for (; i + 16 <= length; i += 16) {
+            uint8x16_t chunk = vld1q_u8(characters + i);
+            uint8x16_t matches = vceqq_u8(chunk, needles[0]);
+            for (size_t d = 1; d < count; d++)
+                matches = vorrq_u8(matches, vceqq_u8(chunk, needles[d]));
+            // four bits for each byte, as there is no movemask
+            uint8x8_t narrowed = vshrn_n_u16(vreinterpretq_u16_u8(matches), 4);
+            uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(narrowed), 0);
+            if (mask)
+                return i + ctz(mask) / 4;
+        }
+    }
+#endif
+
+    for (; i < length; i++) {
+        if (m_isLatin1Delimiter[characters[i]])
+            return i;
+    }
+    return length;
+}
+
+size_t DelimiterSet::find(const UChar* characters, size_t start, size_t length) const
+{
+    for (size_t i = start; i < length; i++) {
+        UChar character = characters[i];
+        if (character <= 0xFF ? m_isLatin1Delimiter[character] : m_delimiters.find(character) != notFound)
+            return i;
+    }
+    return length;
+}
+
+} // namespace PurCFetcher
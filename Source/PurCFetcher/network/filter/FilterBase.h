@@ -49,14 +49,17 @@
 #pragma once
 
 #include "NetworkDataTask.h"
+#include "DelimiterSet.h"
+#include <wtf/Deque.h>
+#include <wtf/text/StringBuilder.h>
+#include <wtf/text/StringView.h>
+#include <limits>
+#include <memory>
 #if 0
 #include <minigui/common.h>
 #include <minigui/gdi.h>
 #endif
 
-#define UCHAR_BREAK_WORD_BOUNDARY        0x0001
-#define UCHAR_BREAK_SENTENCE_BOUNDARY    0x0002
-
 namespace PurCFetcher {
 
 inline bool isSingleQuotes(UChar character)
@@ -73,72 +76,235 @@ typedef enum {
     FilterTypeFormat       = 5
 } FilterType;
 
-typedef Vector<String> Row;
+// A cell refers to the output of the command, or to a string kept by the
+// FilterRows holding the row, so the filters do not copy the text.
+typedef Vector<StringView, 4> Row;
 
-class FilterBase : public RefCounted<FilterBase> {
+// The rows going through the filters, changed in place by each of them.
+class FilterRows {
+    WTF_MAKE_NONCOPYABLE(FilterRows);
 public:
-    virtual ~FilterBase() {}
-    virtual String name() = 0;
-    virtual FilterType type() = 0;
-    virtual Vector<Row> doFilter(Vector<Row> rowVec, String param) = 0;
+    FilterRows() = default;
 
-public:
-    Vector<String> splitUTF8(const char* source, const char* sourceEnd);
+    size_t size() const { return m_rows.size(); }
+    bool isEmpty() const { return m_rows.isEmpty(); }
+
+    Row& operator[](size_t index) { return m_rows[index]; }
+    const Row& operator[](size_t index) const { return m_rows[index]; }
+
+    Vector<Row>::iterator begin() { return m_rows.begin(); }
+    Vector<Row>::iterator end() { return m_rows.end(); }
+
+    Vector<Row>& rows() { return m_rows; }
+    void setRows(Vector<Row>&& rows) { m_rows = WTFMove(rows); }
+
+    void reserveInitialCapacity(size_t capacity) { m_rows.reserveInitialCapacity(capacity); }
+    void appendLine(StringView line);
+
+    // Keeps a cell made up by a filter alive as long as the rows.
+    StringView keep(String&&);
+
+private:
+    Vector<Row> m_rows;
+    Vector<String> m_strings;
 };
 
-struct UCharBreakAttr
-{
-  guint is_line_break : 1;      /* Can break line in front of character */
-  guint is_mandatory_break : 1; /* Must break line in front of character */
-  guint is_char_break : 1;      /* Can break here when doing char wrap */
-  guint is_white : 1;           /* Whitespace character */
-  /* Cursor can appear in front of character (i.e. this is a grapheme
-   * boundary, or the first character in the text).
-   */
-  guint is_cursor_position : 1;
-  guint is_word_start : 1;      /* first character in a word */
-  guint is_word_end   : 1;      /* is first non-word char after a word */
-  /* There are two ways to divide sentences. The first assigns all
-   * intersentence whitespace/control/format chars to some sentence,
-   * so all chars are in some sentence; is_sentence_boundary denotes
-   * the boundaries there. The second way doesn't assign
-   * between-sentence spaces, etc. to any sentence, so
-   * is_sentence_start/is_sentence_end mark the boundaries of those
-   * sentences.
-   */
-  guint is_sentence_boundary : 1;
-  guint is_sentence_start : 1;  /* first character in a sentence */
-  guint is_sentence_end : 1;    /* first non-sentence char after a sentence */
-  guint backspace_deletes_character : 1;
-  guint is_expandable_space : 1;
-  guint is_word_boundary : 1;  /* is NOT in the middle of a word */
+// Collects the characters of a cell. The cell stays a view of the source
+// as long as the characters are contiguous in it.
+class CellBuilder {
+public:
+    explicit CellBuilder(StringView source)
+        : m_source(source)
+    {
+    }
+
+    void append(unsigned begin, unsigned end);
+    bool isEmpty() const { return m_begin == m_end && m_builder.isEmpty(); }
+    StringView take(FilterRows&);
+
+private:
+    StringView m_source;
+    unsigned m_begin { 0 };
+    unsigned m_end { 0 };
+    StringBuilder m_builder;
 };
 
+// The parameter of a filter, parsed once when a cmdfilter plan is compiled.
+struct FilterParam {
+    // the parameter as given
+    String text;
+    bool isValid { true };
+
+    // the numbers of the parameter: the limit of head and tail, the step
+    // and the first position of pick and cut, the start and the size of
+    // ignore
+    int left { 0 };
+    int right { 0 };
+    // "$" was given as the start of ignore
+    bool fromLast { false };
+
+    // the keys of the keys format, the separator of the array format
+    Vector<String> keys;
+    String separator;
+
+    // the characters of the parameter of split and delimiter
+    DelimiterSet delimiters;
 
+    // Set when a head is fused into the stage: the rows, or the columns
+    // of the column filters, after this many are not used.
+    size_t outputLimit { std::numeric_limits<size_t>::max() };
+};
 
-class UCharBreaker {
+// Rows held back by a cursor. They have their own copy of the text, as
+// the output they come from is gone by the time they are let through.
+class HeldRows {
+    WTF_MAKE_NONCOPYABLE(HeldRows);
 public:
-    UCharBreaker(const char* text);
-    ~UCharBreaker();
+    HeldRows() = default;
 
-    const char* getText() { return m_text; }
-    const gunichar* getUChar() { return m_uchar; }
-    int getUCharLen() { return m_ucharLen; }
+    size_t size() const { return m_rows.size(); }
+    bool isEmpty() const { return m_rows.isEmpty(); }
 
-    const struct UCharBreakAttr* getBreakAttrs() { return m_breakAttrs; }
-    int getBreakAttrsCount() { return m_breakAttrsCount; }
+    void append(const Row&);
+    void removeFirst() { m_rows.removeFirst(); }
+    void clear() { m_rows.clear(); }
 
-private:
-    void doUStrGetBreaks();
-    void genBreaks(const char* text, int length, struct UCharBreakAttr* attrs);
+    // Moves the rows held to the end of the rows given.
+    void moveTo(FilterRows&);
 
 private:
-    const char* m_text;
-    gunichar* m_uchar;
-    glong m_ucharLen;
+    Deque<Vector<String>> m_rows;
+};
+
+// A filter picking rows by their position (FilterTypeLineCut) running on
+// the output of one command, as its rows come.
+class FilterCursor {
+    WTF_MAKE_NONCOPYABLE(FilterCursor);
+    WTF_MAKE_FAST_ALLOCATED;
+public:
+    FilterCursor() = default;
+    virtual ~FilterCursor() = default;
+
+    // Filters the next rows of the output, in place.
+    virtual void push(FilterRows& rows) = 0;
+
+    // The output is over: appends the rows held back, if any.
+    virtual void finish(FilterRows&) { }
 
-    struct UCharBreakAttr* m_breakAttrs;
-    int m_breakAttrsCount;
+    // No row coming later can get through.
+    virtual bool isDone() const { return false; }
+
+protected:
+    // the position in the output of the next row pushed
+    size_t m_position { 0 };
 };
 
+class FilterBase : public RefCounted<FilterBase> {
+public:
+    virtual ~FilterBase() {}
+    virtual String name() = 0;
+    virtual FilterType type() = 0;
+    virtual FilterParam parseParam(const String& param);
+
+    // Filters all the rows at once. The filters picking rows by their
+    // position run their cursor over them.
+    virtual void doFilter(FilterRows& rows, const FilterParam& param);
+
+    // The filters picking rows by their position: their state for the
+    // output of one command, null if the parameter is not valid.
+    virtual std::unique_ptr<FilterCursor> createCursor(const FilterParam&) { return nullptr; }
+
+public:
+    // a number: head, tail
+    static FilterParam parseLimitParam(const String& param);
+    // "left,right": pick, cut
+    static FilterParam parseStepParam(const String& param);
+    // "start,size", the start may be "$": ignore
+    static FilterParam parseIgnoreParam(const String& param);
+    // each of the characters splits: split, delimiter
+    static FilterParam parseDelimiterParam(const String& param);
+
+    // Appends a cell for every UTF-8 character of the source, or for the
+    // letters and numbers only, until there are limit cells.
+    static void splitUTF8(StringView source, Row& cells, bool lettersOnly = false, size_t limit = std::numeric_limits<size_t>::max());
+
+    // Appends the pieces of the source between any of the delimiters,
+    // without the empty ones, as String::split() does, until there are
+    // limit cells.
+    static void splitByCharacters(StringView source, const DelimiterSet& delimiters, Row& cells, size_t limit = std::numeric_limits<size_t>::max());
+
+    static bool isLetterOrNumber(UChar32 character);
+
+    // Splits the cells of a row into pieces, each piece making a row, but
+    // the last piece of a cell that was split, which goes with the first
+    // piece of the next cell.
+    template<typename SplitFunction>
+    static void splitRowIntoRows(const Row& row, Vector<Row>& result, const SplitFunction& splitCell)
+    {
+        Row carried;
+        Row pieces;
+        for (auto& cell : row) {
+            pieces.shrink(0);
+            splitCell(cell, pieces);
+            if (pieces.isEmpty())
+                continue;
+
+            carried.append(pieces.first());
+            result.append(WTFMove(carried));
+            carried = Row();
+            if (pieces.size() == 1)
+                continue;
+
+            for (size_t i = 1; i < pieces.size() - 1; i++) {
+                Row piece;
+                piece.append(pieces[i]);
+                result.append(WTFMove(piece));
+            }
+            carried.append(pieces.last());
+        }
+        if (!carried.isEmpty())
+            result.append(WTFMove(carried));
+    }
+};
+
+// The positions left * i + right (i = 0, 1, ...) below size, as taken by
+// the pick and cut filters.
+Vector<bool> pickedPositions(int left, int right, size_t size);
+bool isPickedPosition(int left, int right, size_t position);
+
+// Keeps the items whose position is, or is not, picked. In place.
+template<typename VectorType>
+void keepPickedPositions(VectorType& items, const Vector<bool>& picked, bool keepPicked)
+{
+    size_t kept = 0;
+    for (size_t i = 0; i < items.size(); i++) {
+        if (picked[i] != keepPicked)
+            continue;
+        if (kept != i)
+            items[kept] = WTFMove(items[i]);
+        kept++;
+    }
+    items.shrink(kept);
+}
+
+// Removes the abs(limit) items from start on, or up to start if the limit
+// is negative, as the ignore filters do. In place.
+template<typename VectorType>
+void removeIgnoredPositions(VectorType& items, int start, int limit)
+{
+    if (!limit) {
+        items.clear();
+        return;
+    }
+
+    int size = items.size();
+    if (start < 0 || start > size)
+        return;
+
+    int ignoreBegin = std::max(limit > 0 ? start : start + limit + 1, 0);
+    int ignoreEnd = std::min(limit > 0 ? start + limit : start + 1, size);
+    if (ignoreEnd > ignoreBegin)
+        items.remove(ignoreBegin, ignoreEnd - ignoreBegin);
+}
+
 } // namespace PurCFetcher
@@ -60,38 +60,43 @@ FormatArray::~FormatArray()
 {
 }
 
-Ref<JSON::Value> FormatArray::doFormat(Vector<String> lineColumns, String param)
+FilterParam FormatArray::parseParam(const String& param)
 {
-    auto array = JSON::Array::create();
-
-    if (lineColumns.size() == 0)
-        return array;
-
-    int left = 0;
-    String split = ":";
+    FilterParam result;
+    result.text = param;
+    result.separator = ":";
     if (!param.isEmpty())
     {
         Vector<String> paramVec = param.split(",");
         if (paramVec.size() >= 2)
         {
-            left = paramVec[0].toInt();
-            split  = paramVec[1].stripLeadingAndTrailingCharacters(isSingleQuotes);
+            result.left = paramVec[0].toInt();
+            result.separator = paramVec[1].stripLeadingAndTrailingCharacters(isSingleQuotes);
         }
     }
+    return result;
+}
+
+void FormatArray::doFormat(const Row& lineColumns, const FilterParam& param, JSONStreamWriter& writer)
+{
+    writer.beginArray();
+
+    int left = std::max(param.left, 0);
+    const String& split = param.separator;
 
     int size = lineColumns.size();
     if (left == 0)
     {
         for (int i = 0; i < size; i++)
         {
-            array->pushString(lineColumns[i]);
+            writer.writeString(lineColumns[i]);
         }
     }
     else
     {
         for (int i = 0; i < left && i < size; i++)
         {
-            array->pushString(lineColumns[i]);
+            writer.writeString(lineColumns[i]);
         }
 
         StringBuilder sb;
@@ -103,11 +108,11 @@ Ref<JSON::Value> FormatArray::doFormat(Vector<String> lineColumns, String param)
         if (sb.length())
         {
             sb.resize(sb.length() - split.length());
-            array->pushString(sb.toString());
+            writer.writeString(sb.toString());
         }
     }
 
-    return array;
+    writer.endArray();
 }
 
 } // namespace PurCFetcher
@@ -50,14 +50,15 @@
 
 #include "NetworkDataTask.h"
 #include "FilterBase.h"
-#include <wtf/JSONValues.h>
+#include "JSONStreamWriter.h"
 
 namespace PurCFetcher {
 
 class FormatBase : public FilterBase {
 public:
-    virtual Vector<Row> doFilter(Vector<Row> rowVec, String)  { return rowVec; }
-    virtual Ref<JSON::Value> doFormat(Vector<String> lineColumns, String param) = 0;
+    virtual void doFilter(FilterRows&, const FilterParam&) { }
+    // Writes the row as one JSON value.
+    virtual void doFormat(const Row& lineColumns, const FilterParam& param, JSONStreamWriter&) = 0;
 };
 
 } // namespace PurCFetcher
@@ -60,9 +60,10 @@ FormatKeys::~FormatKeys()
 {
 }
 
-Ref<JSON::Value> FormatKeys::doFormat(Vector<String> lineColumns, String param)
+FilterParam FormatKeys::parseParam(const String& param)
 {
-    Vector<String> keyVec;
+    FilterParam result;
+    result.text = param;
     if (!param.isEmpty())
     {
         Vector<String> keys = param.split(",");
@@ -73,25 +74,32 @@ Ref<JSON::Value> FormatKeys::doFormat(Vector<String> lineColumns, String param)
             keys[i] = keys[i].stripLeadingAndTrailingCharacters(isSingleQuotes);
             if (keys[i].length())
             {
-                keyVec.append(keys[i]);
+                result.keys.append(keys[i]);
             }
         }
     }
+    return result;
+}
+
+void FormatKeys::doFormat(const Row& lineColumns, const FilterParam& param, JSONStreamWriter& writer)
+{
+    const Vector<String>& keyVec = param.keys;
 
-    auto result = JSON::Object::create();
+    writer.beginObject();
     int size = lineColumns.size();
     int keySize = keyVec.size();
     for (int i = 0; i < keySize && i < size; i++)
     {
-        result->setString(keyVec[i], lineColumns[i]);
+        writer.writeKey(keyVec[i]);
+        writer.writeString(lineColumns[i]);
     }
 
     for (int i = keySize; i < size; i++)
     {
-        result->setString("C" + String::number(i), lineColumns[i]);
+        writer.writeKey(makeString("C", i));
+        writer.writeString(lineColumns[i]);
     }
-
-    return result;
+    writer.endObject();
 }
 
 } // namespace PurCFetcher
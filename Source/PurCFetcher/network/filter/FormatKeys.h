@@ -59,7 +59,8 @@ public:
     ~FormatKeys();
     virtual String name() { return "keys"; }
     virtual FilterType type() { return FilterTypeFormat; }
-    virtual Ref<JSON::Value> doFormat(Vector<String> lineColumns, String param);
+    virtual FilterParam parseParam(const String& param);
+    virtual void doFormat(const Row& lineColumns, const FilterParam& param, JSONStreamWriter&);
 };
 
 } // namespace PurCFetcher
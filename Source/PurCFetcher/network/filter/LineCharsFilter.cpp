@@ -61,57 +61,31 @@ LineCharsFilter::~LineCharsFilter()
 {
 }
 
-Vector<String> LineCharsFilter::doFilterInner(Vector<String> lines, String param)
+void LineCharsFilter::doFilter(FilterRows& rows, const FilterParam& param)
 {
-    if (lines.size() == 0)
-        return lines;
-
-    Vector<String> result;
-    size_t size = lines.size();
-    for (size_t i = 0; i < size; i++)
-    {
-        result.appendVector(splitLine(lines[i], param));
-    }
-    return result;
-}
-
-Vector<String> LineCharsFilter::splitLine(String line, String)
-{
-    if (line.isEmpty())
-    {
-        Vector<String> result;
-        return result;
-    }
-
-    return splitUTF8((const char*)line.characters8(), (const char*)line.characters8() + line.length());
-}
-
-Vector<Row> LineCharsFilter::doFilter(Vector<Row> rowVec, String param)
-{
-    if (rowVec.size() == 0)
-        return rowVec;
+    if (rows.isEmpty())
+        return;
 
     Vector<Row> result;
-    size_t size = rowVec.size();
-    for (size_t i = 0; i < size; i++)
+    Row characters;
+    for (auto& row : rows)
     {
-        result.appendVector(splitRow(rowVec[i], param));
-    }
-    return result;
-}
+        if (result.size() >= param.outputLimit)
+            break;
 
-Vector<Row> LineCharsFilter::splitRow(Row& row, String param)
-{
-    Vector<Row> result;
-    Vector<String> lineVec = doFilterInner(row, param);
-    int size = lineVec.size();
-    for (int i = 0; i < size; i++)
-    {
-        Row r;
-        r.append(lineVec[i]);
-        result.append(r);
+        characters.shrink(0);
+        for (auto& cell : row)
+            splitUTF8(cell, characters, false, param.outputLimit - result.size());
+
+        // every character makes a row
+        for (auto& character : characters)
+        {
+            Row r;
+            r.append(character);
+            result.append(WTFMove(r));
+        }
     }
-    return result;
+    rows.setRows(WTFMove(result));
 }
 
 } // namespace PurCFetcher
@@ -49,6 +49,7 @@
 #include "config.h"
 #include <stdio.h>
 #include "LineCutFilter.h"
+#include "LinePickFilter.h"
 
 namespace PurCFetcher {
 using namespace PurCFetcher;
@@ -61,58 +62,12 @@ LineCutFilter::~LineCutFilter()
 {
 }
 
-Vector<Row> LineCutFilter::doFilter(Vector<Row> lines, String param)
+std::unique_ptr<FilterCursor> LineCutFilter::createCursor(const FilterParam& param)
 {
-    if (lines.size() == 0 || param.isEmpty())
-        return lines;
+    if (!param.isValid)
+        return nullptr;
 
-    Vector<String> paramVec = param.split(",");
-    if (paramVec.size() < 2)
-    {
-        return lines;
-    }
-
-    String sleft = paramVec[0].stripWhiteSpace();
-    String sright = paramVec[1].stripWhiteSpace();
-
-    bool success = false;
-    int left = sleft.toInt(&success);
-    if (!success)
-    {
-        return lines;
-    }
-
-    int right = sright.toInt(&success);
-    if (!success)
-    {
-        return lines;
-    }
-
-    int size = lines.size();
-    int i = 0;
-    int n = left * i + right;
-    Vector<int> indexVec;
-    while(n < size)
-    {
-        if (n >= 0)
-        {
-            indexVec.append(n);
-        }
-        i++;
-        n = left * i + right;
-    }
-    
-    Vector<Row> result;
-    for(int i = 0; i < size; i++)
-    {
-        if (indexVec.contains(i))
-        {
-            continue;
-        }
-        result.append(lines[i]);
-    }
-
-    return result;
+    return makeUnique<LinePickCursor>(param, false);
 }
 
 } // namespace PurCFetcher
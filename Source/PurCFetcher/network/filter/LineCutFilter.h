@@ -60,7 +60,8 @@ public:
     virtual ~LineCutFilter();
     virtual String name() { return "cut"; }
     virtual FilterType type()  { return FilterTypeLineCut; }
-    virtual Vector<Row> doFilter(Vector<Row> lines, String param);
+    virtual FilterParam parseParam(const String& param) { return parseStepParam(param); }
+    virtual std::unique_ptr<FilterCursor> createCursor(const FilterParam& param);
 };
 
 } // namespace PurCFetcher
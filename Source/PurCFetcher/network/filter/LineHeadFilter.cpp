@@ -61,24 +61,33 @@ LineHeadFilter::~LineHeadFilter()
 {
 }
 
-Vector<Row>  LineHeadFilter::doFilter(Vector<Row> lines, String param)
-{
-    if (lines.size() == 0 || param.isEmpty())
-        return lines;
-
-    bool success = false;
-    int limit = param.toInt(&success);
-    if (!success)
+// Lets the first rows through, then is done.
+class LineHeadCursor final : public FilterCursor {
+public:
+    explicit LineHeadCursor(size_t limit)
+        : m_limit(limit)
     {
-        return lines;
     }
 
-    int size = lines.size();
-    if (size > limit)
+    void push(FilterRows& rows) final
     {
-        lines.shrink(limit);
+        size_t kept = std::min(rows.size(), m_limit - m_position);
+        rows.rows().shrink(kept);
+        m_position += kept;
     }
-    return lines;
+
+    bool isDone() const final { return m_position >= m_limit; }
+
+private:
+    size_t m_limit;
+};
+
+std::unique_ptr<FilterCursor> LineHeadFilter::createCursor(const FilterParam& param)
+{
+    if (!param.isValid)
+        return nullptr;
+
+    return makeUnique<LineHeadCursor>(param.left);
 }
 
 } // namespace PurCFetcher
@@ -60,7 +60,8 @@ public:
     virtual ~LineHeadFilter();
     virtual String name() { return "head"; }
     virtual FilterType type()  { return FilterTypeLineCut; }
-    virtual Vector<Row> doFilter(Vector<Row> rowVec, String param);
+    virtual FilterParam parseParam(const String& param) { return parseLimitParam(param); }
+    virtual std::unique_ptr<FilterCursor> createCursor(const FilterParam& param);
 };
 
 } // namespace PurCFetcher
@@ -61,61 +61,89 @@ LineIgnoreFilter::~LineIgnoreFilter()
 {
 }
 
-Vector<Row> LineIgnoreFilter::doFilter(Vector<Row> lines, String param)
-{
-    if (lines.size() == 0 || param.isEmpty())
-        return lines;
-
-    Vector<String> paramVec = param.split(",");
-    if (paramVec.size() < 2)
+// Drops the rows in the range given. Going back from the start, the rows
+// are only dropped once the start is known to be in the output, and "$"
+// needs all the rows to know where the last one is.
+class LineIgnoreCursor final : public FilterCursor {
+public:
+    explicit LineIgnoreCursor(const FilterParam& param)
+        : m_fromLast(param.fromLast)
+        , m_start(param.left)
+        , m_limit(param.right)
     {
-        return lines;
     }
 
-    String begin = paramVec[0].stripWhiteSpace();
-    String size = paramVec[1].stripWhiteSpace();
-
-    bool success = false;
-    int limit = size.toInt(&success);
-    if (!success)
+    void push(FilterRows& rows) final
     {
-        return lines;
-    }
+        if (!m_limit)
+        {
+            rows.rows().clear();
+            return;
+        }
 
-    int start = begin.toInt(&success);
-    if (!success)
-    {
-        if (equalIgnoringASCIICase(begin, "$"))
+        if (m_fromLast)
         {
-            start = lines.size() - 1;
+            for (auto& row : rows)
+                m_held.append(row);
+            rows.rows().clear();
+            return;
         }
-        else
+
+        if (m_start < 0)
+            return;
+
+        int64_t ignoreBegin = std::max<int64_t>(m_limit > 0 ? m_start : static_cast<int64_t>(m_start) + m_limit + 1, 0);
+        int64_t ignoreEnd = m_limit > 0 ? static_cast<int64_t>(m_start) + m_limit : m_start + 1;
+        Vector<Row>& items = rows.rows();
+        size_t kept = 0;
+        for (size_t i = 0; i < items.size(); i++, m_position++)
         {
-            return lines;
+            int64_t position = m_position;
+            if (position >= ignoreBegin && position < ignoreEnd)
+            {
+                if (m_limit > 0 || position + 1 >= m_start)
+                    m_held.clear();
+                else
+                    m_held.append(items[i]);
+                continue;
+            }
+            if (kept != i)
+                items[kept] = WTFMove(items[i]);
+            kept++;
         }
+        items.shrink(kept);
     }
 
-    Vector<Row> result;
-    if (limit == 0)
+    void finish(FilterRows& rows) final
     {
-        return result;
+        size_t first = rows.size();
+        m_held.moveTo(rows);
+        if (!m_fromLast || rows.size() == first)
+            return;
+
+        int count = rows.size() - first;
+        int start = count - 1;
+        int ignoreBegin = std::max(m_limit > 0 ? start : start + m_limit + 1, 0);
+        int ignoreEnd = std::min(m_limit > 0 ? start + m_limit : start + 1, count);
+        if (ignoreEnd > ignoreBegin)
+            rows.rows().remove(first + ignoreBegin, ignoreEnd - ignoreBegin);
     }
 
-    int ignoreBegin = limit > 0 ? start : start + limit + 1;
-    int ignoreSize = abs(limit);
+    bool isDone() const final { return !m_limit; }
 
-    if (start > (int)lines.size())
-    {
-        return lines;
-    }
+private:
+    bool m_fromLast;
+    int m_start;
+    int m_limit;
+    HeldRows m_held;
+};
 
-    result.append(lines.data(), ignoreBegin);
-    if (ignoreBegin + ignoreSize < (int)lines.size())
-    {
-        result.append(lines.data() + ignoreBegin + ignoreSize, lines.size() - ignoreBegin - ignoreSize);
-    }
+std::unique_ptr<FilterCursor> LineIgnoreFilter::createCursor(const FilterParam& param)
+{
+    if (!param.isValid)
+        return nullptr;
 
-    return result;
+    return makeUnique<LineIgnoreCursor>(param);
 }
 
 } // namespace PurCFetcher
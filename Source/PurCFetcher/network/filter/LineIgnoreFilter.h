@@ -60,7 +60,8 @@ public:
     virtual ~LineIgnoreFilter();
     virtual String name() { return "ignore"; }
     virtual FilterType type()  { return FilterTypeLineCut; }
-    virtual Vector<Row> doFilter(Vector<Row> lines, String param);
+    virtual FilterParam parseParam(const String& param) { return parseIgnoreParam(param); }
+    virtual std::unique_ptr<FilterCursor> createCursor(const FilterParam& param);
 };
 
 } // namespace PurCFetcher
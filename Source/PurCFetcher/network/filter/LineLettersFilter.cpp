@@ -64,85 +64,32 @@ LineLettersFilter::~LineLettersFilter()
 {
 }
 
-Vector<String> LineLettersFilter::doFilterInner(Vector<String> lines, String param)
+void LineLettersFilter::doFilter(FilterRows& rows, const FilterParam& param)
 {
-    if (lines.size() == 0)
-        return lines;
+    if (rows.isEmpty())
+        return;
 
-    Vector<String> result;
-    size_t size = lines.size();
-    for (size_t i = 0; i < size; i++)
+    Vector<Row> result;
+    Row characters;
+    for (auto& row : rows)
     {
-        result.appendVector(splitLine(lines[i], param));
-    }
+        if (result.size() >= param.outputLimit)
+            break;
 
-    size = result.size();
-    if (!size)
-        return result;
+        characters.shrink(0);
+        for (auto& cell : row)
+            splitUTF8(cell, characters, true, param.outputLimit - result.size());
 
-    Vector<String> res;
-    for (size_t i = 0; i < size; i++)
-    {
-        switch(g_unichar_type(g_utf8_get_char((const char*)result[i].characters8())))
+        // every character makes a row
+        for (auto& character : characters)
         {
-            case G_UNICODE_LOWERCASE_LETTER:
-            case G_UNICODE_MODIFIER_LETTER:
-            case G_UNICODE_OTHER_LETTER:
-            case G_UNICODE_TITLECASE_LETTER:
-            case G_UNICODE_UPPERCASE_LETTER:
-            case G_UNICODE_DECIMAL_NUMBER:
-            case G_UNICODE_LETTER_NUMBER:
-            case G_UNICODE_OTHER_NUMBER:
-                res.append(result[i]);
-                break;
-
-            default:
-                break;
+            Row r;
+            r.append(character);
+            result.append(WTFMove(r));
         }
     }
-
-    return res;
+    rows.setRows(WTFMove(result));
 }
 
-Vector<String> LineLettersFilter::splitLine(String line, String)
-{
-    if (line.isEmpty())
-    {
-        Vector<String> result;
-        return result;
-    }
-
-    return splitUTF8((const char*)line.characters8(), (const char*)line.characters8() + line.length());
-}
-
-Vector<Row> LineLettersFilter::doFilter(Vector<Row> rowVec, String param)
-{
-    if (rowVec.size() == 0)
-        return rowVec;
-
-    Vector<Row> result;
-    size_t size = rowVec.size();
-    for (size_t i = 0; i < size; i++)
-    {
-        result.appendVector(splitRow(rowVec[i], param));
-    }
-    return result;
-}
-
-Vector<Row> LineLettersFilter::splitRow(Row& row, String param)
-{
-    Vector<Row> result;
-    Vector<String> lineVec = doFilterInner(row, param);
-    int size = lineVec.size();
-    for (int i = 0; i < size; i++)
-    {
-        Row r;
-        r.append(lineVec[i]);
-        result.append(r);
-    }
-    return result;
-}
-
-
 } // namespace PurCFetcher
 
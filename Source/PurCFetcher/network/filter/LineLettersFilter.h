@@ -60,12 +60,7 @@ public:
     virtual ~LineLettersFilter();
     virtual String name() { return "letters"; }
     virtual FilterType type()  { return FilterTypeLineSplit; }
-    virtual Vector<Row> doFilter(Vector<Row> rowVec, String param);
-
-private:
-    Vector<String> doFilterInner(Vector<String> lines, String param);
-    Vector<String> splitLine(String line, String param);
-    Vector<Row> splitRow(Row& row, String param);
+    virtual void doFilter(FilterRows& rows, const FilterParam& param);
 };
 
 } // namespace PurCFetcher
@@ -61,48 +61,40 @@ LinePickFilter::~LinePickFilter()
 {
 }
 
-Vector<Row> LinePickFilter::doFilter(Vector<Row> lines, String param)
+LinePickCursor::LinePickCursor(const FilterParam& param, bool keepPicked)
+    : m_left(param.left)
+    , m_right(param.right)
+    , m_keepPicked(keepPicked)
 {
-    if (lines.size() == 0 || param.isEmpty())
-        return lines;
-
-    Vector<String> paramVec = param.split(",");
-    if (paramVec.size() < 2)
-    {
-        return lines;
-    }
-
-    String sleft = paramVec[0].stripWhiteSpace();
-    String sright = paramVec[1].stripWhiteSpace();
+}
 
-    bool success = false;
-    int left = sleft.toInt(&success);
-    if (!success)
+void LinePickCursor::push(FilterRows& rows)
+{
+    Vector<Row>& items = rows.rows();
+    size_t kept = 0;
+    for (size_t i = 0; i < items.size(); i++, m_position++)
     {
-        return lines;
+        if (isPickedPosition(m_left, m_right, m_position) != m_keepPicked)
+            continue;
+        if (kept != i)
+            items[kept] = WTFMove(items[i]);
+        kept++;
     }
+    items.shrink(kept);
+}
 
-    int right = sright.toInt(&success);
-    if (!success)
-    {
-        return lines;
-    }
+bool LinePickCursor::isDone() const
+{
+    // without a positive step, no position after the first one is picked
+    return m_keepPicked && m_left <= 0 && static_cast<int64_t>(m_position) > m_right;
+}
 
-    int size = lines.size();
-    int i = 0;
-    int n = left * i + right;
-    Vector<Row> result;
-    while(n < size)
-    {
-        if (n >= 0)
-        {
-            result.append(lines[n]);
-        }
-        i++;
-        n = left * i + right;
-    }
+std::unique_ptr<FilterCursor> LinePickFilter::createCursor(const FilterParam& param)
+{
+    if (!param.isValid)
+        return nullptr;
 
-    return result;
+    return makeUnique<LinePickCursor>(param, true);
 }
 
 } // namespace PurCFetcher
@@ -54,13 +54,29 @@
 
 namespace PurCFetcher {
 
+// Lets the rows at the picked positions through, or the other ones, for
+// the cut filter.
+class LinePickCursor final : public FilterCursor {
+public:
+    LinePickCursor(const FilterParam&, bool keepPicked);
+
+    void push(FilterRows& rows) final;
+    bool isDone() const final;
+
+private:
+    int m_left;
+    int m_right;
+    bool m_keepPicked;
+};
+
 class LinePickFilter : public FilterBase {
 public:
     LinePickFilter();
     virtual ~LinePickFilter();
     virtual String name() { return "pick"; }
     virtual FilterType type()  { return FilterTypeLineCut; }
-    virtual Vector<Row> doFilter(Vector<Row> lines, String param);
+    virtual FilterParam parseParam(const String& param) { return parseStepParam(param); }
+    virtual std::unique_ptr<FilterCursor> createCursor(const FilterParam& param);
 };
 
 } // namespace PurCFetcher
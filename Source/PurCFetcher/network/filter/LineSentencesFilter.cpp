@@ -50,6 +50,8 @@
 #include <stdio.h>
 #include "LineSentencesFilter.h"
 
+#include "TextSegmenter.h"
+
 namespace PurCFetcher {
 using namespace PurCFetcher;
 
@@ -64,120 +66,26 @@ LineSentencesFilter::~LineSentencesFilter()
 {
 }
 
-Vector<String> LineSentencesFilter::splitLine(String line)
+void LineSentencesFilter::doFilter(FilterRows& rows, const FilterParam& param)
 {
-    Vector<String> result;
-    if (line.isEmpty())
-    {
-        return result;
-    }
-
-    const char* source = (const char*)line.characters8();
-    UCharBreaker breaker(source);
-    const gunichar* gucharSource = breaker.getUChar();
-    int gucharSourceLen = breaker.getUCharLen();
-    const struct UCharBreakAttr* breakAttrs = breaker.getBreakAttrs();
-
-    const gunichar* p = gucharSource;
-    const gunichar* pEnd = gucharSource + gucharSourceLen; 
-    int i = 0;
-
-    StringBuilder sb;
-    while(p < pEnd)
-    {
-        char buf[6] = {0};
-        gunichar wc = *p;
-        g_unichar_to_utf8(wc, buf);
-        bool isLetterOrNumber = false;
-        switch(g_unichar_type(wc))
-        {
-            case G_UNICODE_LOWERCASE_LETTER:
-            case G_UNICODE_MODIFIER_LETTER:
-            case G_UNICODE_OTHER_LETTER:
-            case G_UNICODE_TITLECASE_LETTER:
-            case G_UNICODE_UPPERCASE_LETTER:
-            case G_UNICODE_DECIMAL_NUMBER:
-            case G_UNICODE_LETTER_NUMBER:
-            case G_UNICODE_OTHER_NUMBER:
-                isLetterOrNumber = true;
-                break;
-
-            default:
-                break;
-        }
-
-        if (breakAttrs[i].is_sentence_boundary)
-        {
-            if (sb.length())
-            {
-                result.append(sb.toString());
-                sb.clear();
-            }
-            if (isLetterOrNumber)
-                sb.append(buf);
-        }
-        else
-        {
-            sb.append(buf);
-        }
-
-	    p++;
-        i++;
-    }
-
-    if (sb.length())
-    {
-        result.append(sb.toString());
-    }
-    return result;
-}
-
-Vector<Row> LineSentencesFilter::doFilter(Vector<Row> rowVec, String param)
-{
-    if (m_lang.isEmpty())
-    {
-        m_lang = param.isEmpty() ? "en" : param;
-    }
-
-    if (rowVec.size() == 0)
-        return rowVec;
+    if (rows.isEmpty())
+        return;
 
+    TextSegmenter segmenter;
     Vector<Row> result;
-    size_t size = rowVec.size();
-    for (size_t i = 0; i < size; i++)
+    result.reserveInitialCapacity(std::min(rows.size(), param.outputLimit));
+    for (auto& row : rows)
     {
-        result.appendVector(splitRow(rowVec[i], param));
-    }
-    return result;
-}
-
-Vector<Row> LineSentencesFilter::splitRow(Row& row, String)
-{
-    Vector<Row> rowVec;
-    int rowColumnSize = row.size();
-    Row lastRow;
-    for (int i = 0; i < rowColumnSize; i++)
-    {
-        Vector<String> splitRet = splitLine(row[i]);
-        lastRow.append(splitRet[0]);
-        rowVec.append(lastRow);
-        lastRow.clear();
-
-        int size = splitRet.size();
-        if (size == 1)
-            continue;
-
-        int last = size - 1;
-        for (int j = 1; j < last; j++)
-        {
-            Row r;
-            r.append(splitRet[j]);
-            rowVec.append(r);
-        }
+        if (result.size() >= param.outputLimit)
+            break;
 
-        lastRow.append(splitRet[last]);
+        splitRowIntoRows(row, result, [&segmenter, &rows](StringView cell, Row& pieces) {
+            segmenter.appendSentences(cell, rows, pieces);
+        });
     }
-    return rowVec;
+    if (result.size() > param.outputLimit)
+        result.shrink(param.outputLimit);
+    rows.setRows(WTFMove(result));
 }
 
 } // namespace PurCFetcher
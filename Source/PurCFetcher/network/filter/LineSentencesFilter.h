@@ -60,14 +60,7 @@ public:
     virtual ~LineSentencesFilter();
     virtual String name() { return "sentences"; }
     virtual FilterType type()  { return FilterTypeLineSplit; }
-    virtual Vector<Row> doFilter(Vector<Row> rowVec, String param);
-
-private:
-    Vector<String> splitLine(String line);
-    Vector<Row> splitRow(Row& row, String param);
-
-private:
-    String m_lang;
+    virtual void doFilter(FilterRows& rows, const FilterParam& param);
 };
 
 } // namespace PurCFetcher
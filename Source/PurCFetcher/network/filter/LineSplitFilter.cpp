@@ -61,63 +61,34 @@ LineSplitFilter::~LineSplitFilter()
 {
 }
 
-Vector<Row> LineSplitFilter::doFilter(Vector<Row> rowVec, String param)
+void LineSplitFilter::doFilter(FilterRows& rows, const FilterParam& param)
 {
-    if (param.isEmpty() || rowVec.size() == 0)
-        return rowVec;
+    if (rows.isEmpty())
+        return;
 
-    Vector<Row> result;
-    size_t size = rowVec.size();
-    for (size_t i = 0; i < size; i++)
+    if (param.text.isEmpty())
     {
-        result.appendVector(splitRow(rowVec[i], param));
+        // nothing to split, only a fused head to apply
+        if (rows.size() > param.outputLimit)
+            rows.rows().shrink(param.outputLimit);
+        return;
     }
-    return result;
-}
 
-Vector<Row> LineSplitFilter::splitRow(Row& row, String param)
-{
-    if (param.length() > 1)
-    {
-        Vector<Row> result = splitRowByUChar(row, param[0]);
-        return doFilter(result, param.substring(1, param.length() - 1));
-    }
-    else
-    {
-        return splitRowByUChar(row, param[0]);
-    }
-}
-
-Vector<Row> LineSplitFilter::splitRowByUChar(Row& row, UChar uc)
-{
-    Vector<Row> rowVec;
-    int rowColumnSize = row.size();
-    Row lastRow;
-    for (int i = 0; i < rowColumnSize; i++)
+    // each of the characters of the parameter splits the lines
+    Vector<Row> result;
+    result.reserveInitialCapacity(std::min(rows.size(), param.outputLimit));
+    for (auto& row : rows)
     {
-        Vector<String> splitRet = row[i].split(uc);
-        printf(".................................i=%d|splitRet[0]=%s\n", i, splitRet[0].characters8());
-        lastRow.append(splitRet[0]);
-        rowVec.append(lastRow);
-        lastRow.clear();
-
-        int size = splitRet.size();
-        if (size == 1)
-            continue;
-
-        int last = size - 1;
-        for (int j = 1; j < last; j++)
-        {
-            Row r;
-            r.append(splitRet[j]);
-            printf(".................................splitRet[%d]=%s\n", j, splitRet[j].characters8());
-            rowVec.append(r);
-        }
+        if (result.size() >= param.outputLimit)
+            break;
 
-        printf(".................................splitRet[%d]=%s\n", last, splitRet[last].characters8());
-        lastRow.append(splitRet[last]);
+        splitRowIntoRows(row, result, [&param](StringView cell, Row& pieces) {
+            splitByCharacters(cell, param.delimiters, pieces);
+        });
     }
-    return rowVec;
+    if (result.size() > param.outputLimit)
+        result.shrink(param.outputLimit);
+    rows.setRows(WTFMove(result));
 }
 
 } // namespace PurCFetcher
@@ -60,11 +60,8 @@ public:
     virtual ~LineSplitFilter();
     virtual String name() { return "split"; }
     virtual FilterType type()  { return FilterTypeLineSplit; }
-    virtual Vector<Row> doFilter(Vector<Row> rowVec, String param);
-
-private:
-    Vector<Row> splitRow(Row& row, String param);
-    Vector<Row> splitRowByUChar(Row& row, UChar uc);
+    virtual FilterParam parseParam(const String& param) { return parseDelimiterParam(param); }
+    virtual void doFilter(FilterRows& rows, const FilterParam& param);
 };
 
 } // namespace PurCFetcher
@@ -61,26 +61,45 @@ LineTailFilter::~LineTailFilter()
 {
 }
 
-Vector<Row> LineTailFilter::doFilter(Vector<Row> lines, String param)
-{
-    if (lines.size() == 0 || param.isEmpty())
-        return lines;
+// Holds the last rows in a ring, lets them through at the end.
+class LineTailCursor final : public FilterCursor {
+public:
+    explicit LineTailCursor(size_t limit)
+        : m_limit(limit)
+    {
+    }
 
-    bool success = false;
-    int limit = param.toInt(&success);
-    if (!success)
+    void push(FilterRows& rows) final
     {
-        return lines;
+        // only the last rows pushed can be among the last ones of the output
+        size_t first = rows.size() > m_limit ? rows.size() - m_limit : 0;
+        for (size_t i = first; i < rows.size(); i++)
+        {
+            if (m_held.size() == m_limit)
+                m_held.removeFirst();
+            m_held.append(rows[i]);
+        }
+        rows.rows().clear();
     }
 
-    int size = lines.size();
-    if (size < limit)
+    void finish(FilterRows& rows) final
     {
-        return lines;
+        m_held.moveTo(rows);
     }
-    Vector<Row> result;
-    result.append(lines.data() + size - limit, limit);
-    return result;
+
+    bool isDone() const final { return !m_limit; }
+
+private:
+    size_t m_limit;
+    HeldRows m_held;
+};
+
+std::unique_ptr<FilterCursor> LineTailFilter::createCursor(const FilterParam& param)
+{
+    if (!param.isValid)
+        return nullptr;
+
+    return makeUnique<LineTailCursor>(param.left);
 }
 
 } // namespace PurCFetcher
@@ -60,7 +60,8 @@ public:
     virtual ~LineTailFilter();
     virtual String name() { return "tail"; }
     virtual FilterType type()  { return FilterTypeLineCut; }
-    virtual Vector<Row> doFilter(Vector<Row> lines, String param);
+    virtual FilterParam parseParam(const String& param) { return parseLimitParam(param); }
+    virtual std::unique_ptr<FilterCursor> createCursor(const FilterParam& param);
 };
 
 } // namespace PurCFetcher
@@ -60,14 +60,7 @@ public:
     virtual ~LineWordsFilter();
     virtual String name() { return "words"; }
     virtual FilterType type()  { return FilterTypeLineSplit; }
-    virtual Vector<Row> doFilter(Vector<Row> rowVec, String param);
-
-private:
-    Vector<String> splitLine(String line, String param);
-    Vector<Row> splitRow(Row& row, String param);
-
-private:
-    String m_lang;
+    virtual void doFilter(FilterRows& rows, const FilterParam& param);
 };
 
 } // namespace PurCFetcher
@@ -0,0 +1,566 @@
+/* 
+ * Copyright (C) 2020 Beijing FMSoft Technologies Co., Ltd.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ * 
+ * Or,
+ * 
+ * As this component is a program released under LGPLv3, which claims
+ * explicitly that the program could be modified by any end user
+ * even if the program is conveyed in non-source form on the system it runs.
+ * Generally, if you distribute this program in embedded devices,
+ * you might not satisfy this condition. Under this situation or you can
+ * not accept any condition of LGPLv3, you need to get a commercial license
+ * from FMSoft, along with a patent license for the patents owned by FMSoft.
+ * 
+ * If you have got a commercial/patent license of this program, please use it
+ * under the terms and conditions of the commercial license.
+ * 
+ * For more information about the commercial license and patent license,
+ * please refer to
+ * <https://hybridos.fmsoft.cn/blog/hybridos-licensing-policy/>.
+ * 
+ * Also note that the LGPLv3 license does not apply to any entity in the
+ * Exception List published by Beijing FMSoft Technologies Co., Ltd.
+ * 
+ * If you are or the entity you represent is listed in the Exception List,
+ * the above open source or free software license does not apply to you
+ * or the entity you represent. Regardless of the purpose, you should not
+ * use the software in any way whatsoever, including but not limited to
+ * downloading, viewing, copying, distributing, compiling, and running.
+ * If you have already downloaded it, you MUST destroy all of its copies.
+ * 
+ * The Exception List is published by FMSoft and may be updated
+ * from time to time. For more information, please see
+ * <https://www.fmsoft.cn/exception-list>.
+ */ 
+
+#include "config.h"
+#include "TextSegmenter.h"
+
+#include <atomic>
+#include <glib.h>
+#include <wtf/Lock.h>
+#include <wtf/text/ASCIIFastPath.h>
+#include <wtf/unicode/CharacterNames.h>
+
+namespace PurCFetcher {
+
+// See the Grapheme_Cluster_Break property values of UAX#29: the spacing
+// marks do not break a cluster either, and the Hangul syllables are left
+// to the word rules, which join their letters anyway.
+enum GraphemeBreak : uint8_t {
+    GraphemeBreakOther,
+    GraphemeBreakControl,
+    GraphemeBreakExtend,
+};
+
+// See the Word_Break property values of UAX#29.
+enum WordBreak : uint8_t {
+    WordBreakOther,
+    WordBreakNewline,
+    WordBreakExtendFormat,
+    WordBreakKatakana,
+    WordBreakALetter,
+    WordBreakMidNumLet,
+    WordBreakMidLetter,
+    WordBreakMidNum,
+    WordBreakNumeric,
+    WordBreakExtendNumLet,
+};
+
+enum class SentenceState : uint8_t {
+    Outside,
+    Body,
+    Term,
+    PostTermClose,
+    PostTermSpace,
+    PostTermSep,
+    Dot,
+    PostDotClose,
+    PostDotSpace,
+    PostDotOpen,
+};
+
+static constexpr UChar32 paragraphSeparator = 0x2029;
+
+static GraphemeBreak graphemeBreakOf(UChar32 wc, GUnicodeType type)
+{
+    switch (type) {
+    case G_UNICODE_FORMAT:
+        // U+200C and U+200D are Other_Grapheme_Extend
+        if (wc == 0x200C || wc == 0x200D)
+            return GraphemeBreakExtend;
+        return GraphemeBreakControl;
+    case G_UNICODE_CONTROL:
+    case G_UNICODE_LINE_SEPARATOR:
+    case G_UNICODE_PARAGRAPH_SEPARATOR:
+    case G_UNICODE_SURROGATE:
+        return GraphemeBreakControl;
+    case G_UNICODE_UNASSIGNED:
+        // unassigned default ignorables
+        if ((wc >= 0xFFF0 && wc <= 0xFFF8) || (wc >= 0xE0000 && wc <= 0xE0FFF))
+            return GraphemeBreakControl;
+        return GraphemeBreakOther;
+    case G_UNICODE_MODIFIER_LETTER:
+        if (wc >= 0xFF9E && wc <= 0xFF9F)
+            return GraphemeBreakExtend;
+        return GraphemeBreakOther;
+    case G_UNICODE_SPACING_MARK:
+    case G_UNICODE_ENCLOSING_MARK:
+    case G_UNICODE_NON_SPACING_MARK:
+        return GraphemeBreakExtend;
+    default:
+        return GraphemeBreakOther;
+    }
+}
+
+static bool isIdeographic(UChar32 wc)
+{
+    return wc == 0x3006 || wc == 0x3007
+        || (wc >= 0x3021 && wc <= 0x3029)
+        || (wc >= 0x3038 && wc <= 0x303A)
+        || (wc >= 0x3400 && wc <= 0x4DB5)
+        || (wc >= 0x4E00 && wc <= 0x9FC3)
+        || (wc >= 0xF900 && wc <= 0xFA2D)
+        || (wc >= 0xFA30 && wc <= 0xFA6A)
+        || (wc >= 0xFA70 && wc <= 0xFAD9)
+        || (wc >= 0x20000 && wc <= 0x2A6D6)
+        || (wc >= 0x2F800 && wc <= 0x2FA1D);
+}
+
+static WordBreak wordBreakOf(UChar32 wc, GUnicodeType type)
+{
+    GUnicodeScript script = g_unichar_get_script(wc);
+    if (script == G_UNICODE_SCRIPT_KATAKANA)
+        return WordBreakKatakana;
+
+    switch (wc >> 8) {
+    case 0x30:
+        if ((wc >= 0x3031 && wc <= 0x3035) || wc == 0x309B || wc == 0x309C || wc == 0x30A0 || wc == 0x30FC)
+            return WordBreakKatakana; // Katakana exceptions
+        break;
+    case 0xFF:
+        if (wc == 0xFF70)
+            return WordBreakKatakana; // Katakana exceptions
+        if (wc >= 0xFF9E && wc <= 0xFF9F)
+            return WordBreakExtendFormat; // Other_Grapheme_Extend
+        break;
+    case 0x05:
+        if (wc == 0x05F3)
+            return WordBreakALetter; // ALetter exceptions
+        break;
+    }
+
+    GUnicodeBreakType breakType = g_unichar_break_type(wc);
+    if (breakType == G_UNICODE_BREAK_NUMERIC && wc != 0x066C)
+        return WordBreakNumeric;
+    if (breakType == G_UNICODE_BREAK_INFIX_SEPARATOR && wc != 0x003A && wc != 0xFE13 && wc != 0x002E)
+        return WordBreakMidNum;
+
+    bool isAlphabetic = false;
+    switch (type) {
+    case G_UNICODE_CONTROL:
+        if (wc == 0x000D || wc == 0x000A || wc == 0x000B || wc == 0x000C || wc == 0x0085)
+            return WordBreakNewline;
+        return WordBreakOther;
+    case G_UNICODE_LINE_SEPARATOR:
+    case G_UNICODE_PARAGRAPH_SEPARATOR:
+        return WordBreakNewline;
+    case G_UNICODE_FORMAT:
+    case G_UNICODE_SPACING_MARK:
+    case G_UNICODE_ENCLOSING_MARK:
+    case G_UNICODE_NON_SPACING_MARK:
+        return WordBreakExtendFormat;
+    case G_UNICODE_CONNECT_PUNCTUATION:
+        return WordBreakExtendNumLet;
+    case G_UNICODE_INITIAL_PUNCTUATION:
+    case G_UNICODE_FINAL_PUNCTUATION:
+        if (wc == 0x2018 || wc == 0x2019)
+            return WordBreakMidNumLet;
+        return WordBreakOther;
+    case G_UNICODE_OTHER_PUNCTUATION:
+        if (wc == 0x0027 || wc == 0x002E || wc == 0x2024 || wc == 0xFE52 || wc == 0xFF07 || wc == 0xFF0E)
+            return WordBreakMidNumLet;
+        if (wc == 0x00B7 || wc == 0x05F4 || wc == 0x2027 || wc == 0x003A || wc == 0x0387 || wc == 0xFE13 || wc == 0xFE55 || wc == 0xFF1A)
+            return WordBreakMidLetter;
+        if (wc == 0x066C || wc == 0xFE50 || wc == 0xFE54 || wc == 0xFF0C || wc == 0xFF1B)
+            return WordBreakMidNum;
+        return WordBreakOther;
+    case G_UNICODE_OTHER_SYMBOL:
+        // Other_Alphabetic
+        isAlphabetic = wc >= 0x24B6 && wc <= 0x24E9;
+        break;
+    case G_UNICODE_OTHER_LETTER:
+    case G_UNICODE_LETTER_NUMBER:
+        isAlphabetic = !isIdeographic(wc);
+        break;
+    case G_UNICODE_LOWERCASE_LETTER:
+    case G_UNICODE_MODIFIER_LETTER:
+    case G_UNICODE_TITLECASE_LETTER:
+    case G_UNICODE_UPPERCASE_LETTER:
+        isAlphabetic = true;
+        break;
+    default:
+        break;
+    }
+
+    if (isAlphabetic && breakType != G_UNICODE_BREAK_COMPLEX_CONTEXT && script != G_UNICODE_SCRIPT_HIRAGANA)
+        return WordBreakALetter;
+    return WordBreakOther;
+}
+
+static TextSegmenter::CharacterClass computeCharacterClass(UChar32 wc)
+{
+    GUnicodeType type = g_unichar_type(wc);
+    return { static_cast<uint8_t>(type), wordBreakOf(wc, type), graphemeBreakOf(wc, type) };
+}
+
+// The BMP in blocks of 256 characters, each filled once.
+static constexpr unsigned characterBlockSize = 256;
+static std::atomic<const TextSegmenter::CharacterClass*> characterBlocks[0x10000 / characterBlockSize];
+static Lock characterBlocksLock;
+
+static const TextSegmenter::CharacterClass* characterBlock(unsigned index)
+{
+    const TextSegmenter::CharacterClass* block = characterBlocks[index].load(std::memory_order_acquire);
+    if (block)
+        return block;
+
+    auto locker = holdLock(characterBlocksLock);
+    block = characterBlocks[index].load(std::memory_order_relaxed);
+    if (block)
+        return block;
+
+    // kept for the life of the process
+    auto* classes = static_cast<TextSegmenter::CharacterClass*>(fastMalloc(sizeof(TextSegmenter::CharacterClass) * characterBlockSize));
+    for (unsigned i = 0; i < characterBlockSize; i++)
+        classes[i] = computeCharacterClass(index * characterBlockSize + i);
+    characterBlocks[index].store(classes, std::memory_order_release);
+    return classes;
+}
+
+TextSegmenter::CharacterClass TextSegmenter::characterClass(UChar32 character)
+{
+    if (character < 0 || character > 0xFFFF)
+        return computeCharacterClass(character);
+    return characterBlock(character / characterBlockSize)[character % characterBlockSize];
+}
+
+static bool isLetterOrNumberType(uint8_t type)
+{
+    switch (type) {
+    case G_UNICODE_LOWERCASE_LETTER:
+    case G_UNICODE_MODIFIER_LETTER:
+    case G_UNICODE_OTHER_LETTER:
+    case G_UNICODE_TITLECASE_LETTER:
+    case G_UNICODE_UPPERCASE_LETTER:
+    case G_UNICODE_DECIMAL_NUMBER:
+    case G_UNICODE_LETTER_NUMBER:
+    case G_UNICODE_OTHER_NUMBER:
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool TextSegmenter::isLetterOrNumber(UChar32 character)
+{
+    if (isASCII(character))
+        return isASCIIAlphanumeric(character);
+    return isLetterOrNumberType(characterClass(character).type);
+}
+
+// line and paragraph separators, controls and formats end a sentence
+static bool isSeparatorType(uint8_t type)
+{
+    return type == G_UNICODE_LINE_SEPARATOR || type == G_UNICODE_PARAGRAPH_SEPARATOR
+        || type == G_UNICODE_CONTROL || type == G_UNICODE_FORMAT;
+}
+
+static bool isBlankType(uint8_t type)
+{
+    return isSeparatorType(type) || type == G_UNICODE_SPACE_SEPARATOR;
+}
+
+void TextSegmenter::decode(StringView text)
+{
+    // the cells hold the bytes of UTF-8 text as Latin-1 characters
+    ASSERT(text.is8Bit());
+    const LChar* data = text.characters8();
+    unsigned length = text.length();
+    m_characters.shrink(0);
+
+    if (charactersAreAllASCII(data, length)) {
+        const CharacterClass* classes = characterBlock(0);
+        m_characters.reserveCapacity(length + 1);
+        for (unsigned i = 0; i < length; i++)
+            m_characters.uncheckedAppend(Character { i, i + 1, data[i], classes[data[i]], false });
+        return;
+    }
+
+    for (unsigned offset = 0; offset < length; ) {
+        unsigned begin = offset;
+        UChar32 character;
+        U8_NEXT(data, offset, length, character);
+        if (character < 0)
+            character = replacementCharacter;
+        m_characters.append(Character { begin, offset, character, characterClass(character), false });
+    }
+}
+
+void TextSegmenter::findWordBoundaries()
+{
+    WordBreak previousPrevious = WordBreakOther;
+    WordBreak previous = WordBreakOther;
+    size_t previousIndex = notFound;
+    uint8_t previousGraphemeBreak = GraphemeBreakOther;
+    UChar32 previousValue = 0;
+
+    for (size_t i = 0; i < m_characters.size(); i++) {
+        Character& character = m_characters[i];
+        uint8_t graphemeBreak = character.characterClass.graphemeBreak;
+
+        // rules GB3 to GB10
+        bool isGraphemeBoundary;
+        if (character.value == '\n' && previousValue == '\r')
+            isGraphemeBoundary = false;
+        else if (previousGraphemeBreak == GraphemeBreakControl || graphemeBreak == GraphemeBreakControl)
+            isGraphemeBoundary = true;
+        else
+            isGraphemeBoundary = graphemeBreak != GraphemeBreakExtend;
+        previousGraphemeBreak = graphemeBreak;
+        previousValue = character.value;
+
+        // rules WB3 and WB4: no boundary inside a grapheme cluster
+        character.isBoundary = false;
+        if (!isGraphemeBoundary)
+            continue;
+
+        auto wordBreak = static_cast<WordBreak>(character.characterClass.wordBreak);
+        auto isWordLike = [](WordBreak type) {
+            return type == WordBreakALetter || type == WordBreakNumeric || type == WordBreakExtendNumLet;
+        };
+        auto isKatakanaLike = [](WordBreak type) {
+            return type == WordBreakKatakana || type == WordBreakExtendNumLet;
+        };
+
+        if (previous == WordBreakNewline && previousIndex + 1 == i)
+            character.isBoundary = true; // rule WB3a
+        else if (wordBreak == WordBreakNewline)
+            character.isBoundary = true; // rule WB3b
+        else if (wordBreak == WordBreakExtendFormat)
+            character.isBoundary = false; // rule WB4
+        else if (isWordLike(previous) && isWordLike(wordBreak))
+            character.isBoundary = false; // rules WB5, WB8 to WB10, WB13a, WB13b
+        else if (isKatakanaLike(previous) && isKatakanaLike(wordBreak))
+            character.isBoundary = false; // rules WB13, WB13a, WB13b
+        else if (previousPrevious == WordBreakALetter && wordBreak == WordBreakALetter
+            && (previous == WordBreakMidLetter || previous == WordBreakMidNumLet))
+            m_characters[previousIndex].isBoundary = false; // rules WB6, WB7
+        else if (previousPrevious == WordBreakNumeric && wordBreak == WordBreakNumeric
+            && (previous == WordBreakMidNum || previous == WordBreakMidNumLet))
+            m_characters[previousIndex].isBoundary = false; // rules WB11, WB12
+        else
+            character.isBoundary = true; // rule WB14
+
+        if (wordBreak != WordBreakExtendFormat) {
+            previousPrevious = previous;
+            previous = wordBreak;
+            previousIndex = i;
+        }
+    }
+
+    // rule WB1
+    if (!m_characters.isEmpty())
+        m_characters[0].isBoundary = true;
+}
+
+void TextSegmenter::findSentenceBoundaries()
+{
+    // as the breaker did, the text ends with a paragraph separator
+    unsigned length = m_characters.isEmpty() ? 0 : m_characters.last().end;
+    m_characters.append(Character { length, length, paragraphSeparator, characterClass(paragraphSeparator), false });
+
+    SentenceState state = SentenceState::Outside;
+    size_t possibleBoundary = notFound;
+    uint8_t previousType = G_UNICODE_PARAGRAPH_SEPARATOR;
+    UChar32 previousValue = 0;
+
+    for (size_t i = 0; i < m_characters.size(); i++) {
+        Character& character = m_characters[i];
+        uint8_t type = character.characterClass.type;
+        UChar32 value = character.value;
+        UChar32 nextValue = i + 1 < m_characters.size() ? m_characters[i + 1].value : 0;
+
+        auto maybeStartNewSentence = [&] {
+            state = isBlankType(type) ? SentenceState::Outside : SentenceState::Body;
+        };
+        auto isClosing = [&] {
+            return type == G_UNICODE_CLOSE_PUNCTUATION || value == '.' || value == ',' || value == '?' || value == '!';
+        };
+
+        // break after a separator, and before one, but inside CR LF
+        character.isBoundary = (isSeparatorType(previousType) && (value != '\r' || nextValue != '\n'))
+            || (isSeparatorType(type) && (value != '\n' || previousValue != '\r'));
+
+        switch (state) {
+        case SentenceState::Outside:
+            if (!isBlankType(type))
+                state = SentenceState::Body;
+            break;
+
+        case SentenceState::Body:
+            if (character.isBoundary)
+                maybeStartNewSentence();
+            else if (value == '.')
+                state = SentenceState::Dot;
+            else if (value == '?' || value == '!')
+                state = SentenceState::Term;
+            break;
+
+        case SentenceState::Term:
+        case SentenceState::PostTermClose:
+            switch (type) {
+            case G_UNICODE_OTHER_PUNCTUATION:
+            case G_UNICODE_CLOSE_PUNCTUATION:
+                if (isClosing())
+                    state = SentenceState::PostTermClose;
+                else {
+                    character.isBoundary = true;
+                    maybeStartNewSentence();
+                }
+                break;
+            case G_UNICODE_SPACE_SEPARATOR:
+                state = SentenceState::PostTermSpace;
+                break;
+            case G_UNICODE_LINE_SEPARATOR:
+            case G_UNICODE_PARAGRAPH_SEPARATOR:
+                // one separator goes with the sentence
+                if (state == SentenceState::PostTermClose)
+                    character.isBoundary = false;
+                state = SentenceState::PostTermSep;
+                break;
+            default:
+                character.isBoundary = true;
+                maybeStartNewSentence();
+                break;
+            }
+            break;
+
+        case SentenceState::PostTermSpace:
+            switch (type) {
+            case G_UNICODE_SPACE_SEPARATOR:
+                break;
+            case G_UNICODE_LINE_SEPARATOR:
+            case G_UNICODE_PARAGRAPH_SEPARATOR:
+                character.isBoundary = false;
+                state = SentenceState::PostTermSep;
+                break;
+            default:
+                character.isBoundary = true;
+                maybeStartNewSentence();
+                break;
+            }
+            break;
+
+        case SentenceState::PostTermSep:
+            if (!(previousValue == '\r' && value == '\n'))
+                character.isBoundary = true;
+            maybeStartNewSentence();
+            break;
+
+        case SentenceState::Dot:
+        case SentenceState::PostDotClose:
+            if (type == G_UNICODE_CLOSE_PUNCTUATION && state == SentenceState::Dot)
+                state = SentenceState::PostDotClose;
+            else if (type == G_UNICODE_SPACE_SEPARATOR)
+                state = SentenceState::PostDotSpace;
+            else if (character.isBoundary)
+                maybeStartNewSentence();
+            else
+                state = SentenceState::Body;
+            break;
+
+        case SentenceState::PostDotSpace:
+        case SentenceState::PostDotOpen:
+            if (state == SentenceState::PostDotSpace)
+                possibleBoundary = i;
+            if (type == G_UNICODE_SPACE_SEPARATOR && state == SentenceState::PostDotSpace)
+                break;
+            if (type == G_UNICODE_OPEN_PUNCTUATION)
+                state = SentenceState::PostDotOpen;
+            else if (type == G_UNICODE_LOWERCASE_LETTER)
+                // the period did not end the sentence
+                state = SentenceState::Body;
+            else {
+                m_characters[possibleBoundary].isBoundary = true;
+                possibleBoundary = notFound;
+                maybeStartNewSentence();
+            }
+            break;
+        }
+
+        previousType = type;
+        previousValue = value;
+    }
+
+    m_characters.removeLast();
+}
+
+void TextSegmenter::appendWords(StringView text, FilterRows& rows, Row& words)
+{
+    if (text.isEmpty())
+        return;
+
+    decode(text);
+    findWordBoundaries();
+
+    CellBuilder word(text);
+    for (auto& character : m_characters) {
+        if (character.isBoundary && !isLetterOrNumberType(character.characterClass.type))
+            continue;
+        if (character.isBoundary && !word.isEmpty())
+            words.append(word.take(rows));
+        word.append(character.begin, character.end);
+    }
+
+    if (!word.isEmpty())
+        words.append(word.take(rows));
+}
+
+void TextSegmenter::appendSentences(StringView text, FilterRows& rows, Row& sentences)
+{
+    if (text.isEmpty())
+        return;
+
+    decode(text);
+    findSentenceBoundaries();
+
+    CellBuilder sentence(text);
+    for (auto& character : m_characters) {
+        if (character.isBoundary) {
+            if (!sentence.isEmpty())
+                sentences.append(sentence.take(rows));
+            if (!isLetterOrNumberType(character.characterClass.type))
+                continue;
+        }
+        sentence.append(character.begin, character.end);
+    }
+
+    if (!sentence.isEmpty())
+        sentences.append(sentence.take(rows));
+}
+
+} // namespace PurCFetcher
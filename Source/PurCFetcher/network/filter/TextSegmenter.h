@@ -0,0 +1,102 @@
+/* 
+ * Copyright (C) 2020 Beijing FMSoft Technologies Co., Ltd.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ * 
+ * Or,
+ * 
+ * As this component is a program released under LGPLv3, which claims
+ * explicitly that the program could be modified by any end user
+ * even if the program is conveyed in non-source form on the system it runs.
+ * Generally, if you distribute this program in embedded devices,
+ * you might not satisfy this condition. Under this situation or you can
+ * not accept any condition of LGPLv3, you need to get a commercial license
+ * from FMSoft, along with a patent license for the patents owned by FMSoft.
+ * 
+ * If you have got a commercial/patent license of this program, please use it
+ * under the terms and conditions of the commercial license.
+ * 
+ * For more information about the commercial license and patent license,
+ * please refer to
+ * <https://hybridos.fmsoft.cn/blog/hybridos-licensing-policy/>.
+ * 
+ * Also note that the LGPLv3 license does not apply to any entity in the
+ * Exception List published by Beijing FMSoft Technologies Co., Ltd.
+ * 
+ * If you are or the entity you represent is listed in the Exception List,
+ * the above open source or free software license does not apply to you
+ * or the entity you represent. Regardless of the purpose, you should not
+ * use the software in any way whatsoever, including but not limited to
+ * downloading, viewing, copying, distributing, compiling, and running.
+ * If you have already downloaded it, you MUST destroy all of its copies.
+ * 
+ * The Exception List is published by FMSoft and may be updated
+ * from time to time. For more information, please see
+ * <https://www.fmsoft.cn/exception-list>.
+ */ 
+
+#pragma once
+
+#include "FilterBase.h"
+
+namespace PurCFetcher {
+
+// Splits UTF-8 text into words and sentences straight on its bytes, with
+// the UAX#29 rules of the breaker ported from Pango it replaces. The
+// properties of the characters come from tables: the one of ASCII, whose
+// text is not decoded at all, and the blocks of the rest of the BMP,
+// filled from GLib the first time one of their characters is seen.
+//
+// The characters of a cell are kept in a buffer reused for the next one,
+// so a segmenter goes with one doFilter() call, not with the filter.
+class TextSegmenter {
+    WTF_MAKE_NONCOPYABLE(TextSegmenter);
+public:
+    TextSegmenter() = default;
+
+    // Appends the words: the letters and numbers, with what the rules
+    // keep between them, as in "can't" or "3.14".
+    void appendWords(StringView text, FilterRows&, Row& words);
+
+    // Appends the sentences. Where a sentence begins, only a letter or a
+    // number is kept.
+    void appendSentences(StringView text, FilterRows&, Row& sentences);
+
+    // The properties of a character the rules use.
+    struct CharacterClass {
+        uint8_t type; // GUnicodeType
+        uint8_t wordBreak;
+        uint8_t graphemeBreak;
+    };
+    static CharacterClass characterClass(UChar32);
+
+    static bool isLetterOrNumber(UChar32);
+
+private:
+    struct Character {
+        unsigned begin;
+        unsigned end;
+        UChar32 value;
+        CharacterClass characterClass;
+        bool isBoundary;
+    };
+
+    void decode(StringView text);
+    void findWordBoundaries();
+    void findSentenceBoundaries();
+
+    Vector<Character, 256> m_characters;
+};
+
+} // namespace PurCFetcher
@@ -136,6 +136,9 @@ void NetworkProcess::platformInitializeNetworkProcess(const NetworkProcessCreati
         userPreferredLanguagesChanged(parameters.languages);
 
     setIgnoreTLSErrors(parameters.ignoreTLSErrors);
+    SoupNetworkSession::setInitialCacheQuota(parameters.cacheQuota);
+    if (parameters.maxConnections)
+        setMaxConnections(parameters.maxConnections);
 
     if (!parameters.hstsStorageDirectory.isEmpty())
         SoupNetworkSession::setHSTSPersistentStorage(parameters.hstsStorageDirectory.utf8());
@@ -64,6 +64,16 @@ static CString& hstsStorageDirectory()
     return directory.get();
 }
 
+// Values taken from http://www.browserscope.org/ following
+// the rule "Do What Every Other Modern Browser Is Doing". They seem
+// to significantly improve page loading time compared to soup's
+// default values.
+static const unsigned defaultMaxConnections = 17;
+static const unsigned defaultMaxConnectionsPerHost = 6;
+
+static unsigned gMaxConnections = defaultMaxConnections;
+static uint64_t gCacheQuota;
+
 #if !LOG_DISABLED || !RELEASE_LOG_DISABLED
 inline static void soupLogPrinter(SoupLogger*, SoupLoggerLogLevel, char direction, const char* data, gpointer)
 {
@@ -121,16 +131,9 @@ SoupNetworkSession::SoupNetworkSession(PAL::SessionID sessionID)
     : m_soupSession(adoptGRef(soup_session_new()))
     , m_sessionID(sessionID)
 {
-    // Values taken from http://www.browserscope.org/ following
-    // the rule "Do What Every Other Modern Browser Is Doing". They seem
-    // to significantly improve page loading time compared to soup's
-    // default values.
-    static const int maxConnections = 17;
-    static const int maxConnectionsPerHost = 6;
-
     g_object_set(m_soupSession.get(),
-        SOUP_SESSION_MAX_CONNS, maxConnections,
-        SOUP_SESSION_MAX_CONNS_PER_HOST, maxConnectionsPerHost,
+        SOUP_SESSION_MAX_CONNS, gMaxConnections,
+        SOUP_SESSION_MAX_CONNS_PER_HOST, std::min(gMaxConnections, defaultMaxConnectionsPerHost),
         SOUP_SESSION_TIMEOUT, 0,
         SOUP_SESSION_IDLE_TIMEOUT, 0,
         SOUP_SESSION_ADD_FEATURE_BY_TYPE, SOUP_TYPE_CONTENT_SNIFFER,
@@ -152,7 +155,7 @@ SoupNetworkSession::SoupNetworkSession(PAL::SessionID sessionID)
         setupProxy();
     setupLogger();
     setupHSTSEnforcer();
-    setupCache("/tmp/fetcher/cache");
+    setupCache(CACHE_STORAGE_DIR);
 }
 
 SoupNetworkSession::~SoupNetworkSession()
@@ -328,6 +331,32 @@ void SoupNetworkSession::setAcceptLanguages(const CString& languages)
     g_object_set(m_soupSession.get(), "accept-language", languages.data(), nullptr);
 }
 
+void SoupNetworkSession::setInitialMaxConnections(unsigned maxConnections)
+{
+    gMaxConnections = maxConnections ? maxConnections : defaultMaxConnections;
+}
+
+void SoupNetworkSession::setMaxConnections(unsigned maxConnections)
+{
+    setInitialMaxConnections(maxConnections);
+    g_object_set(m_soupSession.get(),
+        SOUP_SESSION_MAX_CONNS, gMaxConnections,
+        SOUP_SESSION_MAX_CONNS_PER_HOST, std::min(gMaxConnections, defaultMaxConnectionsPerHost),
+        nullptr);
+}
+
+void SoupNetworkSession::setInitialCacheQuota(uint64_t cacheQuota)
+{
+    gCacheQuota = cacheQuota;
+}
+
+void SoupNetworkSession::setCacheQuota(uint64_t cacheQuota)
+{
+    setInitialCacheQuota(cacheQuota);
+    if (m_soupCache)
+        soup_cache_set_max_size(m_soupCache.get(), cacheMaxSize());
+}
+
 void SoupNetworkSession::setShouldIgnoreTLSErrors(bool ignoreTLSErrors)
 {
     gIgnoreTLSErrors = ignoreTLSErrors;
@@ -359,11 +388,19 @@ void SoupNetworkSession::setupCache(const char* path)
         return;
     }
     m_soupCache = adoptGRef(soup_cache_new(path, SOUP_CACHE_SINGLE_USER));
-    soup_cache_set_max_size(m_soupCache.get(), G_MAXUINT);
+    soup_cache_set_max_size(m_soupCache.get(), cacheMaxSize());
     soup_session_add_feature(m_soupSession.get(), SOUP_SESSION_FEATURE(m_soupCache.get()));
     soup_cache_load(m_soupCache.get());
 }
 
+guint SoupNetworkSession::cacheMaxSize()
+{
+    // soup_cache takes the size as a guint, 0 means no quota.
+    if (!gCacheQuota || gCacheQuota > G_MAXUINT)
+        return G_MAXUINT;
+    return static_cast<guint>(gCacheQuota);
+}
+
 
 } // namespace PurCFetcher
 
@@ -66,6 +66,14 @@ public:
     static void setInitialAcceptLanguages(const CString&);
     void setAcceptLanguages(const CString&);
 
+    // 0 keeps the default limits
+    static void setInitialMaxConnections(unsigned);
+    void setMaxConnections(unsigned);
+
+    // 0 means no quota
+    static void setInitialCacheQuota(uint64_t);
+    void setCacheQuota(uint64_t);
+
     PURCFETCHER_EXPORT static void setShouldIgnoreTLSErrors(bool);
     static Optional<ResourceError> checkTLSErrors(const URL&, GTlsCertificate*, GTlsCertificateFlags);
     static void allowSpecificHTTPSCertificateForHost(const CertificateInfo&, const String& host);
@@ -78,6 +86,7 @@ public:
 private:
     void setupLogger();
     void setupCache(const char* path);
+    static guint cacheMaxSize();
 
     GRefPtr<SoupSession> m_soupSession;
     GRefPtr<SoupCache> m_soupCache;
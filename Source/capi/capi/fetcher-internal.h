@@ -41,6 +41,12 @@ typedef int (*pcfetcher_term_fn)(struct pcfetcher* fetcher);
 typedef const char* (*pcfetcher_set_base_url_fn)(struct pcfetcher* fetcher,
         const char* base_url);
 
+typedef int (*pcfetcher_set_max_conns_fn)(struct pcfetcher* fetcher,
+        size_t max_conns);
+
+typedef int (*pcfetcher_set_cache_quota_fn)(struct pcfetcher* fetcher,
+        size_t cache_quota);
+
 typedef void (*pcfetcher_cookie_set_fn)(struct pcfetcher* fetcher,
         const char* domain, const char* path, const char* name,
         const char* content, time_t expire_time, bool secure);
@@ -69,9 +75,36 @@ typedef purc_rwstream_t (*pcfetcher_request_sync_fn)(
         uint32_t timeout,
         struct pcfetcher_resp_header *resp_header);
 
+typedef purc_variant_t (*pcfetcher_request_stream_fn)(
+        struct pcfetcher* fetcher,
+        const char* url,
+        enum pcfetcher_request_method method,
+        purc_variant_t params,
+        uint32_t timeout,
+        const struct pcfetcher_stream_handlers *handlers,
+        void* ctxt);
+
+typedef purc_variant_t (*pcfetcher_request_batch_fn)(
+        struct pcfetcher* fetcher,
+        const struct pcfetcher_batch_item *items,
+        size_t nr_items,
+        uint32_t timeout,
+        pcfetcher_batch_handler handler,
+        void* ctxt);
+
+typedef int (*pcfetcher_pause_stream_fn)(struct pcfetcher* fetcher,
+        purc_variant_t request_id);
+
+typedef int (*pcfetcher_resume_stream_fn)(struct pcfetcher* fetcher,
+        purc_variant_t request_id);
+
+typedef int (*pcfetcher_get_fd_fn)(struct pcfetcher* fetcher);
+
 typedef int (*pcfetcher_check_response_fn)(struct pcfetcher* fetcher,
         uint32_t timeout_ms);
 
+typedef char* (*pcfetcher_dump_ipc_stats_fn)(struct pcfetcher* fetcher);
+
 struct pcfetcher {
     size_t max_conns;
     size_t cache_quota;
@@ -79,12 +112,20 @@ struct pcfetcher {
     pcfetcher_init_fn init;
     pcfetcher_term_fn term;
     pcfetcher_set_base_url_fn set_base_url;
+    pcfetcher_set_max_conns_fn set_max_conns;
+    pcfetcher_set_cache_quota_fn set_cache_quota;
     pcfetcher_cookie_set_fn cookie_set;
     pcfetcher_cookie_get_fn cookie_get;
     pcfetcher_cookie_remove_fn cookie_remove;
     pcfetcher_request_async_fn request_async;
     pcfetcher_request_sync_fn request_sync;
+    pcfetcher_request_stream_fn request_stream;
+    pcfetcher_pause_stream_fn pause_stream;
+    pcfetcher_resume_stream_fn resume_stream;
+    pcfetcher_request_batch_fn request_batch;
+    pcfetcher_get_fd_fn get_fd;
     pcfetcher_check_response_fn check_response;
+    pcfetcher_dump_ipc_stats_fn dump_ipc_stats;
 };
 
 struct pcfetcher* pcfetcher_local_init(size_t max_conns, size_t cache_quota);
@@ -94,6 +135,11 @@ int pcfetcher_local_term(struct pcfetcher* fetcher);
 const char* pcfetcher_local_set_base_url(struct pcfetcher* fetcher,
         const char* base_url);
 
+int pcfetcher_local_set_max_conns(struct pcfetcher* fetcher, size_t max_conns);
+
+int pcfetcher_local_set_cache_quota(struct pcfetcher* fetcher,
+        size_t cache_quota);
+
 void pcfetcher_cookie_local_set(struct pcfetcher* fetcher,
         const char* domain, const char* path, const char* name,
         const char* content, time_t expire_time, bool secure);
@@ -122,9 +168,36 @@ purc_rwstream_t pcfetcher_local_request_sync(
         uint32_t timeout,
         struct pcfetcher_resp_header *resp_header);
 
+purc_variant_t pcfetcher_local_request_stream(
+        struct pcfetcher* fetcher,
+        const char* url,
+        enum pcfetcher_request_method method,
+        purc_variant_t params,
+        uint32_t timeout,
+        const struct pcfetcher_stream_handlers *handlers,
+        void* ctxt);
+
+int pcfetcher_local_pause_stream(struct pcfetcher* fetcher,
+        purc_variant_t request_id);
+
+int pcfetcher_local_resume_stream(struct pcfetcher* fetcher,
+        purc_variant_t request_id);
+
+purc_variant_t pcfetcher_local_request_batch(
+        struct pcfetcher* fetcher,
+        const struct pcfetcher_batch_item *items,
+        size_t nr_items,
+        uint32_t timeout,
+        pcfetcher_batch_handler handler,
+        void* ctxt);
+
+int pcfetcher_local_get_fd(struct pcfetcher* fetcher);
+
 int pcfetcher_local_check_response(struct pcfetcher* fetcher,
         uint32_t timeout_ms);
 
+char* pcfetcher_local_dump_ipc_stats(struct pcfetcher* fetcher);
+
 #if ENABLE(LINK_PURC_FETCHER)
 
 struct pcfetcher* pcfetcher_remote_init(size_t max_conns, size_t cache_quota);
@@ -134,6 +207,11 @@ int pcfetcher_remote_term(struct pcfetcher* fetcher);
 const char* pcfetcher_remote_set_base_url(struct pcfetcher* fetcher,
         const char* base_url);
 
+int pcfetcher_remote_set_max_conns(struct pcfetcher* fetcher, size_t max_conns);
+
+int pcfetcher_remote_set_cache_quota(struct pcfetcher* fetcher,
+        size_t cache_quota);
+
 void pcfetcher_cookie_remote_set(struct pcfetcher* fetcher,
         const char* domain, const char* path, const char* name,
         const char* content, time_t expire_time, bool secure);
@@ -163,9 +241,36 @@ purc_rwstream_t pcfetcher_remote_request_sync(
         uint32_t timeout,
         struct pcfetcher_resp_header *resp_header);
 
+purc_variant_t pcfetcher_remote_request_stream(
+        struct pcfetcher* fetcher,
+        const char* url,
+        enum pcfetcher_request_method method,
+        purc_variant_t params,
+        uint32_t timeout,
+        const struct pcfetcher_stream_handlers *handlers,
+        void* ctxt);
+
+int pcfetcher_remote_pause_stream(struct pcfetcher* fetcher,
+        purc_variant_t request_id);
+
+int pcfetcher_remote_resume_stream(struct pcfetcher* fetcher,
+        purc_variant_t request_id);
+
+purc_variant_t pcfetcher_remote_request_batch(
+        struct pcfetcher* fetcher,
+        const struct pcfetcher_batch_item *items,
+        size_t nr_items,
+        uint32_t timeout,
+        pcfetcher_batch_handler handler,
+        void* ctxt);
+
+int pcfetcher_remote_get_fd(struct pcfetcher* fetcher);
+
 int pcfetcher_remote_check_response(struct pcfetcher* fetcher,
         uint32_t timeout_ms);
 
+char* pcfetcher_remote_dump_ipc_stats(struct pcfetcher* fetcher);
+
 #endif // ENABLE(LINK_PURC_FETCHER)
 
 #ifdef __cplusplus
@@ -31,32 +31,512 @@
 
 #if !ENABLE(LINK_PURC_FETCHER)
 
+#include "include/purc_fetcher_local.h"
+
+#include <wtf/Deque.h>
+#include <wtf/Lock.h>
+#include <wtf/ThreadSafeRefCounted.h>
+#include <wtf/Vector.h>
+#include <wtf/threads/BinarySemaphore.h>
+
+#include <errno.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#define DEF_RWS_SIZE 1024
+
+// The network process runs on a thread of this process (see
+// NetworkProcessLocal in PurCFetcher), the loads go straight to NetworkLoad
+// without any IPC. The callbacks of the loads come on the fetcher thread.
+
+class PcFetcherLocal;
+class PcFetcherLocalBatch;
+
+static std::atomic<uint64_t> s_lastRequestId { 0 };
+
+static const char* transMethod(enum pcfetcher_request_method method)
+{
+    switch (method)
+    {
+        case PCFETCHER_REQUEST_METHOD_GET:
+            return "GET";
+
+        case PCFETCHER_REQUEST_METHOD_POST:
+            return "POST";
+
+        case PCFETCHER_REQUEST_METHOD_DELETE:
+            return "DELETE";
+
+        default:
+            return "GET";
+    }
+}
+
+class PcFetcherLocalRequest : public ThreadSafeRefCounted<PcFetcherLocalRequest> {
+    WTF_MAKE_NONCOPYABLE(PcFetcherLocalRequest);
+
+public:
+    enum class Type : uint8_t { Async, Sync, Stream };
+
+    static Ref<PcFetcherLocalRequest> create(PcFetcherLocal& fetcher,
+            Type type, void* ctxt)
+    {
+        return adoptRef(*new PcFetcherLocalRequest(fetcher, type, ctxt));
+    }
+
+    ~PcFetcherLocalRequest();
+
+    purc_variant_t requestId() const { return m_req_vid; }
+
+    const struct pcfetcher_resp_header& responseHeader() const
+    {
+        return m_resp_header;
+    }
+    purc_rwstream_t takeResponseStream(void);
+
+    void setResponseHandler(response_handler handler)
+    {
+        m_req_handler = handler;
+    }
+    void setStreamHandlers(const struct pcfetcher_stream_handlers* handlers)
+    {
+        m_stream_handlers = *handlers;
+    }
+    void setBatch(PcFetcherLocalBatch& batch);
+
+    // hands the request to the fetcher thread
+    bool start(const char* url, enum pcfetcher_request_method method,
+            uint32_t timeout);
+    // finishes a request which could not be started
+    void fail(int statusCode) { finish(statusCode); }
+
+    bool wait(uint32_t timeout)
+    {
+        return m_semaphore.waitFor(Seconds(timeout));
+    }
+
+    void deliverResponse(void);
+    void rewindResponse(void);
+
+private:
+    PcFetcherLocalRequest(PcFetcherLocal& fetcher, Type type, void* ctxt);
+
+    static void didReceiveResponse(void* ctxt, int statusCode,
+            const char* mimeType, int64_t expectedLength);
+    static void didReceiveData(void* ctxt, const char* data, size_t size);
+    static void didFinish(void* ctxt, int statusCode);
+
+    void finish(int statusCode);
+
+    static const struct purc_fetcher_local_client s_client;
+
+    RefPtr<PcFetcherLocal> m_fetcher;
+    Type m_type;
+    void* m_req_ctxt;
+    purc_variant_t m_req_vid;
+
+    struct pcfetcher_resp_header m_resp_header;
+    purc_rwstream_t m_resp_rwstream { NULL };
+
+    response_handler m_req_handler { NULL };
+    struct pcfetcher_stream_handlers m_stream_handlers { };
+
+    BinarySemaphore m_semaphore;
+    RefPtr<PcFetcherLocalBatch> m_batch;
+};
+
+class PcFetcherLocalBatch : public ThreadSafeRefCounted<PcFetcherLocalBatch> {
+    WTF_MAKE_NONCOPYABLE(PcFetcherLocalBatch);
+
+public:
+    static Ref<PcFetcherLocalBatch> create(pcfetcher_batch_handler handler,
+            void* ctxt)
+    {
+        return adoptRef(*new PcFetcherLocalBatch(handler, ctxt));
+    }
+
+    purc_variant_t batchId() const { return m_batch_vid; }
+
+    void addRequest(PcFetcherLocalRequest& req)
+    {
+        req.setBatch(*this);
+        m_requests.append(&req);
+        m_nr_pending++;
+    }
+
+    // returns true if it was the last request of the batch
+    bool requestFinished(void) { return --m_nr_pending == 0; }
+
+    // the batch did not start: drops its requests, which refer to it, and
+    // its id, never handed out
+    void abandon(void)
+    {
+        m_requests.clear();
+        purc_variant_unref(m_batch_vid);
+        m_batch_vid = PURC_VARIANT_INVALID;
+    }
+
+    void deliverResponse(void);
+
+private:
+    PcFetcherLocalBatch(pcfetcher_batch_handler handler, void* ctxt)
+        : m_batch_vid(purc_variant_make_ulongint(++s_lastRequestId))
+        , m_handler(handler)
+        , m_ctxt(ctxt)
+    {
+    }
+
+    purc_variant_t m_batch_vid;
+    pcfetcher_batch_handler m_handler;
+    void* m_ctxt;
+
+    Vector<RefPtr<PcFetcherLocalRequest>> m_requests;
+    std::atomic<size_t> m_nr_pending { 0 };
+};
+
+// The pollable fd of pcfetcher_get_fd(). It is ref counted as a request may
+// outlive pcfetcher_term(), a sync one still waiting on another thread.
+class PcFetcherLocal : public ThreadSafeRefCounted<PcFetcherLocal> {
+public:
+    static Ref<PcFetcherLocal> create() { return adoptRef(*new PcFetcherLocal); }
+
+    ~PcFetcherLocal()
+    {
+        if (m_eventFd >= 0)
+            close(m_eventFd);
+    }
+
+    int getFd(void)
+    {
+        auto locker = holdLock(m_responsesLock);
+        if (m_eventFd < 0)
+            m_eventFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        return m_eventFd;
+    }
+
+    // queues the response for pcfetcher_check_response() if the fd is used
+    bool queueResponse(PcFetcherLocalRequest& req);
+    int checkResponse(uint32_t timeout_ms);
+
+    // drops the queued responses, called by pcfetcher_term()
+    void invalidate(void)
+    {
+        auto locker = holdLock(m_responsesLock);
+        m_responses.clear();
+    }
+
+private:
+    PcFetcherLocal() = default;
+
+    Lock m_responsesLock;
+    int m_eventFd { -1 };
+    Deque<Ref<PcFetcherLocalRequest>> m_responses;
+};
+
+const struct purc_fetcher_local_client PcFetcherLocalRequest::s_client = {
+    PcFetcherLocalRequest::didReceiveResponse,
+    PcFetcherLocalRequest::didReceiveData,
+    PcFetcherLocalRequest::didFinish,
+};
+
+PcFetcherLocalRequest::PcFetcherLocalRequest(PcFetcherLocal& fetcher,
+        Type type, void* ctxt)
+    : m_fetcher(&fetcher)
+    , m_type(type)
+    , m_req_ctxt(ctxt)
+    , m_req_vid(PURC_VARIANT_INVALID)
+{
+    memset(&m_resp_header, 0, sizeof(m_resp_header));
+    if (m_type != Type::Sync) {
+        m_req_vid = purc_variant_make_ulongint(++s_lastRequestId);
+    }
+}
+
+PcFetcherLocalRequest::~PcFetcherLocalRequest()
+{
+    if (m_resp_rwstream) {
+        purc_rwstream_destroy(m_resp_rwstream);
+    }
+    if (m_resp_header.mime_type) {
+        free(m_resp_header.mime_type);
+    }
+}
+
+purc_rwstream_t PcFetcherLocalRequest::takeResponseStream(void)
+{
+    purc_rwstream_t resp = m_resp_rwstream;
+    m_resp_rwstream = NULL;
+    return resp;
+}
+
+void PcFetcherLocalRequest::setBatch(PcFetcherLocalBatch& batch)
+{
+    m_batch = &batch;
+}
+
+bool PcFetcherLocalRequest::start(const char* url,
+        enum pcfetcher_request_method method, uint32_t timeout)
+{
+    // the reference is released by didFinish
+    ref();
+    if (!purc_fetcher_local_load(url, transMethod(method), timeout,
+                &s_client, this)) {
+        deref();
+        return false;
+    }
+    return true;
+}
+
+void PcFetcherLocalRequest::didReceiveResponse(void* ctxt, int statusCode,
+        const char* mimeType, int64_t expectedLength)
+{
+    auto* req = static_cast<PcFetcherLocalRequest*>(ctxt);
+    req->m_resp_header.ret_code = statusCode;
+    if (req->m_resp_header.mime_type) {
+        free(req->m_resp_header.mime_type);
+    }
+    req->m_resp_header.mime_type = mimeType ? strdup(mimeType) : NULL;
+    req->m_resp_header.sz_resp = expectedLength > 0 ? expectedLength : 0;
+    if (req->m_type == Type::Stream) {
+        if (req->m_stream_handlers.on_header) {
+            req->m_stream_handlers.on_header(req->m_req_vid, req->m_req_ctxt,
+                    &req->m_resp_header);
+        }
+        return;
+    }
+
+    if (req->m_resp_rwstream) {
+        purc_rwstream_destroy(req->m_resp_rwstream);
+    }
+    size_t init = req->m_resp_header.sz_resp ?
+        req->m_resp_header.sz_resp : DEF_RWS_SIZE;
+    req->m_resp_rwstream = purc_rwstream_new_buffer(init, INT_MAX);
+}
+
+void PcFetcherLocalRequest::didReceiveData(void* ctxt, const char* data,
+        size_t size)
+{
+    auto* req = static_cast<PcFetcherLocalRequest*>(ctxt);
+    if (req->m_type == Type::Stream) {
+        // there is nothing to hold back the load with, see
+        // pcfetcher_local_pause_stream()
+        if (req->m_stream_handlers.on_chunk) {
+            req->m_stream_handlers.on_chunk(req->m_req_vid, req->m_req_ctxt,
+                    data, size);
+        }
+        return;
+    }
+
+    if (req->m_resp_rwstream) {
+        purc_rwstream_write(req->m_resp_rwstream, data, size);
+    }
+}
+
+void PcFetcherLocalRequest::didFinish(void* ctxt, int statusCode)
+{
+    Ref<PcFetcherLocalRequest> req = adoptRef(
+            *static_cast<PcFetcherLocalRequest*>(ctxt));
+    req->finish(statusCode);
+}
+
+void PcFetcherLocalRequest::finish(int statusCode)
+{
+    m_resp_header.ret_code = statusCode;
+    switch (m_type) {
+    case Type::Sync:
+        m_semaphore.signal();
+        return;
+
+    case Type::Stream:
+        if (m_stream_handlers.on_finish) {
+            m_stream_handlers.on_finish(m_req_vid, m_req_ctxt, &m_resp_header);
+        }
+        return;
+
+    case Type::Async:
+        break;
+    }
+
+    if (m_batch && !m_batch->requestFinished()) {
+        // the last request of the batch delivers all the responses
+        return;
+    }
+
+    if (m_fetcher->queueResponse(*this)) {
+        return;
+    }
+
+    deliverResponse();
+}
+
+void PcFetcherLocalRequest::deliverResponse(void)
+{
+    if (m_batch) {
+        RefPtr<PcFetcherLocalBatch> batch = m_batch;
+        batch->deliverResponse();
+        return;
+    }
+
+    if (!m_req_handler) {
+        return;
+    }
+
+    rewindResponse();
+
+    // the handler takes over the response stream
+    m_req_handler(m_req_vid, m_req_ctxt, &m_resp_header, m_resp_rwstream);
+    m_resp_rwstream = NULL;
+}
+
+void PcFetcherLocalRequest::rewindResponse(void)
+{
+    if (!m_resp_header.sz_resp && m_resp_rwstream) {
+        size_t sz_content = 0;
+        size_t sz_buffer = 0;
+        purc_rwstream_get_mem_buffer_ex(m_resp_rwstream, &sz_content,
+                &sz_buffer, false);
+        m_resp_header.sz_resp = sz_content;
+    }
+    if (m_resp_rwstream) {
+        purc_rwstream_seek(m_resp_rwstream, 0, SEEK_SET);
+    }
+}
+
+void PcFetcherLocalBatch::deliverResponse(void)
+{
+    Ref<PcFetcherLocalBatch> protectedThis(*this);
+
+    // the requests refer to the batch, drop them once delivered
+    auto requests = WTFMove(m_requests);
+
+    Vector<struct pcfetcher_batch_result> results;
+    results.reserveInitialCapacity(requests.size());
+    for (auto& req : requests) {
+        struct pcfetcher_batch_result result;
+        req->rewindResponse();
+        // the mime type stays owned by the request
+        result.header = req->responseHeader();
+        result.resp = req->takeResponseStream();
+        results.uncheckedAppend(result);
+    }
+
+    if (m_handler) {
+        // the handler takes over the response streams
+        m_handler(m_batch_vid, m_ctxt, results.size(), results.data());
+        return;
+    }
+
+    for (auto& result : results) {
+        if (result.resp) {
+            purc_rwstream_destroy(result.resp);
+        }
+    }
+}
+
+bool PcFetcherLocal::queueResponse(PcFetcherLocalRequest& req)
+{
+    int eventFd;
+    {
+        auto locker = holdLock(m_responsesLock);
+        if (m_eventFd < 0)
+            return false;
+        m_responses.append(req);
+        eventFd = m_eventFd;
+    }
+
+    uint64_t one = 1;
+    while (write(eventFd, &one, sizeof(one)) < 0 && errno == EINTR) { }
+    return true;
+}
+
+int PcFetcherLocal::checkResponse(uint32_t timeout_ms)
+{
+    int eventFd;
+    {
+        auto locker = holdLock(m_responsesLock);
+        eventFd = m_eventFd;
+    }
+    if (eventFd < 0)
+        return 0;
+
+    struct pollfd pfd = { eventFd, POLLIN, 0 };
+    int ret;
+    do {
+        ret = poll(&pfd, 1, timeout_ms);
+    } while (ret < 0 && errno == EINTR);
+
+    if (ret <= 0)
+        return 0;
+
+    uint64_t count;
+    while (read(eventFd, &count, sizeof(count)) < 0 && errno == EINTR) { }
+
+    Deque<Ref<PcFetcherLocalRequest>> responses;
+    {
+        auto locker = holdLock(m_responsesLock);
+        responses = WTFMove(m_responses);
+    }
+
+    int handled = 0;
+    while (!responses.isEmpty()) {
+        responses.takeFirst()->deliverResponse();
+        handled++;
+    }
+    return handled;
+}
+
+struct pcfetcher_local {
+    struct pcfetcher base;
+    PcFetcherLocal* local;
+};
+
 struct pcfetcher* pcfetcher_local_init(size_t max_conns, size_t cache_quota)
 {
-    struct pcfetcher* fetcher = (struct pcfetcher*)malloc(
-            sizeof(struct pcfetcher));
+    if (!purc_fetcher_local_start(max_conns, cache_quota)) {
+        return NULL;
+    }
+
+    struct pcfetcher_local* local = (struct pcfetcher_local*)malloc(
+            sizeof(struct pcfetcher_local));
 
+    struct pcfetcher* fetcher = (struct pcfetcher*) local;
     fetcher->max_conns = max_conns;
-    fetcher->cache_quota;
+    fetcher->cache_quota = cache_quota;
     fetcher->init = pcfetcher_local_init;
     fetcher->term = pcfetcher_local_term;
     fetcher->set_base_url = pcfetcher_local_set_base_url;
+    fetcher->set_max_conns = pcfetcher_local_set_max_conns;
+    fetcher->set_cache_quota = pcfetcher_local_set_cache_quota;
     fetcher->cookie_set = pcfetcher_cookie_local_set;
     fetcher->cookie_get = pcfetcher_cookie_local_get;
     fetcher->cookie_remove = pcfetcher_cookie_loccal_remove;
     fetcher->request_async = pcfetcher_local_request_async;
     fetcher->request_sync = pcfetcher_local_request_sync;
+    fetcher->request_stream = pcfetcher_local_request_stream;
+    fetcher->pause_stream = pcfetcher_local_pause_stream;
+    fetcher->resume_stream = pcfetcher_local_resume_stream;
+    fetcher->request_batch = pcfetcher_local_request_batch;
+    fetcher->get_fd = pcfetcher_local_get_fd;
     fetcher->check_response = pcfetcher_local_check_response;
+    fetcher->dump_ipc_stats = pcfetcher_local_dump_ipc_stats;
 
+    local->local = &PcFetcherLocal::create().leakRef();
     return fetcher;
 }
 
 int pcfetcher_local_term(struct pcfetcher* fetcher)
 {
-    free(fetcher);
+    // the loads in flight fail before the fetcher thread exits, so none of
+    // them calls back after this
+    purc_fetcher_local_stop();
+
+    struct pcfetcher_local* local = (struct pcfetcher_local*)fetcher;
+    local->local->invalidate();
+    local->local->deref();
+    free(local);
     return 0;
 }
-
 const char* pcfetcher_local_set_base_url(struct pcfetcher* fetcher,
         const char* base_url)
 {
@@ -65,6 +545,21 @@ const char* pcfetcher_local_set_base_url(struct pcfetcher* fetcher,
     return NULL;
 }
 
+int pcfetcher_local_set_max_conns(struct pcfetcher* fetcher, size_t max_conns)
+{
+    fetcher->max_conns = max_conns;
+    purc_fetcher_local_set_max_conns(max_conns);
+    return 0;
+}
+
+int pcfetcher_local_set_cache_quota(struct pcfetcher* fetcher,
+        size_t cache_quota)
+{
+    fetcher->cache_quota = cache_quota;
+    purc_fetcher_local_set_cache_quota(cache_quota);
+    return 0;
+}
+
 void pcfetcher_cookie_local_set(struct pcfetcher* fetcher,
         const char* domain, const char* path, const char* name,
         const char* content, time_t expire_time, bool secure)
@@ -110,14 +605,17 @@ purc_variant_t pcfetcher_local_request_async(
         response_handler handler,
         void* ctxt)
 {
-    UNUSED_PARAM(fetcher);
-    UNUSED_PARAM(url);
-    UNUSED_PARAM(method);
+    // TODO send params with http request
     UNUSED_PARAM(params);
-    UNUSED_PARAM(timeout);
-    UNUSED_PARAM(handler);
-    UNUSED_PARAM(ctxt);
-    return PURC_VARIANT_INVALID;
+
+    struct pcfetcher_local* local = (struct pcfetcher_local*)fetcher;
+    auto req = PcFetcherLocalRequest::create(*local->local,
+            PcFetcherLocalRequest::Type::Async, ctxt);
+    req->setResponseHandler(handler);
+    if (!req->start(url, method, timeout)) {
+        return PURC_VARIANT_INVALID;
+    }
+    return req->requestId();
 }
 
 
@@ -129,23 +627,147 @@ purc_rwstream_t pcfetcher_local_request_sync(
         uint32_t timeout,
         struct pcfetcher_resp_header *resp_header)
 {
-    UNUSED_PARAM(fetcher);
-    UNUSED_PARAM(url);
-    UNUSED_PARAM(method);
+    // TODO send params with http request
     UNUSED_PARAM(params);
-    UNUSED_PARAM(timeout);
-    UNUSED_PARAM(resp_header);
-    return NULL;
+
+    struct pcfetcher_local* local = (struct pcfetcher_local*)fetcher;
+    auto req = PcFetcherLocalRequest::create(*local->local,
+            PcFetcherLocalRequest::Type::Sync, NULL);
+    if (!req->start(url, method, timeout) || !req->wait(timeout)) {
+        // a late load still holds the request, it drops the response
+        if (resp_header) {
+            resp_header->ret_code = 408;
+            resp_header->mime_type = NULL;
+            resp_header->sz_resp = 0;
+        }
+        return NULL;
+    }
+
+    const struct pcfetcher_resp_header& header = req->responseHeader();
+    if (resp_header) {
+        resp_header->ret_code = header.ret_code;
+        resp_header->mime_type = header.mime_type ?
+            strdup(header.mime_type) : NULL;
+        resp_header->sz_resp = header.sz_resp;
+    }
+    return req->takeResponseStream();
+}
+
+
+purc_variant_t pcfetcher_local_request_stream(
+        struct pcfetcher* fetcher,
+        const char* url,
+        enum pcfetcher_request_method method,
+        purc_variant_t params,
+        uint32_t timeout,
+        const struct pcfetcher_stream_handlers *handlers,
+        void* ctxt)
+{
+    // TODO send params with http request
+    UNUSED_PARAM(params);
+
+    if (!handlers) {
+        return PURC_VARIANT_INVALID;
+    }
+
+    struct pcfetcher_local* local = (struct pcfetcher_local*)fetcher;
+    auto req = PcFetcherLocalRequest::create(*local->local,
+            PcFetcherLocalRequest::Type::Stream, ctxt);
+    req->setStreamHandlers(handlers);
+    if (!req->start(url, method, timeout)) {
+        return PURC_VARIANT_INVALID;
+    }
+    return req->requestId();
+}
+
+// The chunks are passed on as the fetcher thread gets them, there is no
+// connection to apply back pressure to, so a local stream can not pause.
+int pcfetcher_local_pause_stream(struct pcfetcher* fetcher,
+        purc_variant_t request_id)
+{
+    UNUSED_PARAM(fetcher);
+    UNUSED_PARAM(request_id);
+    return -1;
+}
+
+int pcfetcher_local_resume_stream(struct pcfetcher* fetcher,
+        purc_variant_t request_id)
+{
+    UNUSED_PARAM(fetcher);
+    UNUSED_PARAM(request_id);
+    return -1;
 }
 
+purc_variant_t pcfetcher_local_request_batch(
+        struct pcfetcher* fetcher,
+        const struct pcfetcher_batch_item *items,
+        size_t nr_items,
+        uint32_t timeout,
+        pcfetcher_batch_handler handler,
+        void* ctxt)
+{
+    if (!items || !nr_items) {
+        return PURC_VARIANT_INVALID;
+    }
+
+    // the loads of a batch start all or none, a bad item fails it as a whole
+    for (size_t i = 0; i < nr_items; i++) {
+        if (!items[i].url) {
+            return PURC_VARIANT_INVALID;
+        }
+    }
+
+    struct pcfetcher_local* local = (struct pcfetcher_local*)fetcher;
+    auto batch = PcFetcherLocalBatch::create(handler, ctxt);
+    Vector<Ref<PcFetcherLocalRequest>> requests;
+    requests.reserveInitialCapacity(nr_items);
+    for (size_t i = 0; i < nr_items; i++) {
+        auto req = PcFetcherLocalRequest::create(*local->local,
+                PcFetcherLocalRequest::Type::Async, NULL);
+        batch->addRequest(req.get());
+        requests.uncheckedAppend(WTFMove(req));
+    }
+
+    // all the requests are in the batch before the first one can finish
+    for (size_t i = 0; i < nr_items; i++) {
+        if (requests[i]->start(items[i].url, items[i].method, timeout)) {
+            continue;
+        }
+
+        if (!i) {
+            // the fetcher is not started, nothing is loading
+            batch->abandon();
+            return PURC_VARIANT_INVALID;
+        }
+
+        // the fetcher stopped in between: the loads started still finish,
+        // the others fail so that the handler is called once all the same
+        for (; i < nr_items; i++) {
+            requests[i]->fail(500);
+        }
+        break;
+    }
+    return batch->batchId();
+}
+
+int pcfetcher_local_get_fd(struct pcfetcher* fetcher)
+{
+    struct pcfetcher_local* local = (struct pcfetcher_local*)fetcher;
+    return local->local->getFd();
+}
 
 int pcfetcher_local_check_response(struct pcfetcher* fetcher,
         uint32_t timeout_ms)
 {
+    struct pcfetcher_local* local = (struct pcfetcher_local*)fetcher;
+    return local->local->checkResponse(timeout_ms);
+}
+
+char* pcfetcher_local_dump_ipc_stats(struct pcfetcher* fetcher)
+{
+    // no IPC in between
     UNUSED_PARAM(fetcher);
-    UNUSED_PARAM(timeout_ms);
-    return 0;
+    return NULL;
 }
 
 #endif // !ENABLE(LINK_PURC_FETCHER)
-
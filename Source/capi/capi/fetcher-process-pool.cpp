@@ -0,0 +1,367 @@
+/*
+ * @file fetcher-process-pool.cpp
+ * @author XueShuming
+ * @date 2021/11/17
+ * @brief The impl for the pool of fetcher processes.
+ *
+ * Copyright (C) 2021 FMSoft <https://www.fmsoft.cn>
+ *
+ * This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "fetcher-process-pool.h"
+#include "MessageStatistics.h"
+
+#include <wtf/HashFunctions.h>
+#include <wtf/URL.h>
+#include <wtf/text/StringBuilder.h>
+
+#include <algorithm>
+#include <errno.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+
+#define PURC_ENVV_FETCHER_PROCESS_POOL_SIZE "PURC_FETCHER_PROCESS_POOL_SIZE"
+
+using namespace PurCFetcher;
+
+PcFetcherProcessPool::PcFetcherProcessPool(struct pcfetcher* fetcher)
+    : m_fetcher(fetcher)
+{
+    // one process for each online CPU, unless the environment says
+    // otherwise; 0 there means the default as well
+    size_t poolSize = 0;
+    if (const char* size = getenv(PURC_ENVV_FETCHER_PROCESS_POOL_SIZE))
+        poolSize = strtoul(size, NULL, 10);
+    if (!poolSize) {
+        long nrCpus = sysconf(_SC_NPROCESSORS_ONLN);
+        poolSize = nrCpus > 0 ? nrCpus : DEF_PROCESS_POOL_SIZE;
+    }
+
+    for (size_t i = 0; i < poolSize; i++) {
+        m_shards.append(new PcFetcherProcess(m_fetcher, poolSize));
+        for (unsigned k = 0; k < DEF_PROCESS_POOL_VIRTUAL_NODES; k++) {
+            m_ring.append({ WTF::intHash((static_cast<uint64_t>(i) << 32) | k), i });
+        }
+    }
+
+    std::sort(m_ring.begin(), m_ring.end(),
+            [] (const RingNode& a, const RingNode& b) {
+        return a.hash < b.hash;
+    });
+}
+
+PcFetcherProcessPool::~PcFetcherProcessPool()
+{
+    auto locker = holdLock(m_shardsLock);
+    for (auto* process : m_shards) {
+        delete process;
+    }
+    for (auto* process : m_retired) {
+        delete process;
+    }
+    m_shards.clear();
+    m_retired.clear();
+
+    if (m_epollFd >= 0)
+        ::close(m_epollFd);
+}
+
+void PcFetcherProcessPool::connect()
+{
+    auto locker = holdLock(m_shardsLock);
+    for (auto* process : m_shards) {
+        process->connect();
+    }
+}
+
+void PcFetcherProcessPool::terminate()
+{
+    auto locker = holdLock(m_shardsLock);
+    for (auto* process : m_shards) {
+        process->terminate();
+    }
+}
+
+bool PcFetcherProcessPool::setMaxConnections(size_t maxConnections)
+{
+    // each process takes its share of the limit
+    bool sent = true;
+    auto locker = holdLock(m_shardsLock);
+    for (auto* process : m_shards) {
+        sent = process->setMaxConnections(maxConnections) && sent;
+    }
+    return sent;
+}
+
+bool PcFetcherProcessPool::setCacheQuota(size_t cacheQuota)
+{
+    bool sent = true;
+    auto locker = holdLock(m_shardsLock);
+    for (auto* process : m_shards) {
+        sent = process->setCacheQuota(cacheQuota) && sent;
+    }
+    return sent;
+}
+
+String PcFetcherProcessPool::dumpMessageStatistics()
+{
+    StringBuilder builder;
+    builder.append("client|", getpid(), '\n',
+            IPC::MessageStatistics::singleton().snapshot());
+
+    auto locker = holdLock(m_shardsLock);
+    for (auto* process : m_shards) {
+        builder.append("fetcher|", process->processIdentifier(), '\n',
+                process->dumpMessageStatistics());
+    }
+    return builder.toString();
+}
+
+PcFetcherProcess* PcFetcherProcessPool::startProcess(void)
+{
+    PcFetcherProcess* process = new PcFetcherProcess(m_fetcher,
+            m_shards.size());
+    process->connect();
+    if (m_epollFd >= 0)
+        watchProcess(process);
+    return process;
+}
+
+void PcFetcherProcessPool::watchProcess(PcFetcherProcess* process)
+{
+    int fd = process->getFd();
+    if (fd < 0)
+        return;
+
+    struct epoll_event event = { };
+    event.events = EPOLLIN;
+    event.data.fd = fd;
+    epoll_ctl(m_epollFd, EPOLL_CTL_ADD, fd, &event);
+}
+
+void PcFetcherProcessPool::reapRetiredProcesses(void)
+{
+    // checkResponse() walks the processes without the lock, it reaps them
+    // once done
+    if (m_checkingResponses)
+        return;
+
+    // The fd of a process leaves the epoll set when the process closes it.
+    // A process with no pending work runs no handler any more.
+    m_retired.removeAllMatching([] (PcFetcherProcess* process) {
+        if (process->hasPendingWork())
+            return false;
+
+        delete process;
+        return true;
+    });
+}
+
+size_t PcFetcherProcessPool::shardForHost(unsigned hostHash) const
+{
+    auto it = std::lower_bound(m_ring.begin(), m_ring.end(), hostHash,
+            [] (const RingNode& node, unsigned hash) {
+        return node.hash < hash;
+    });
+    if (it == m_ring.end())
+        it = m_ring.begin();
+    return it->shard;
+}
+
+PcFetcherProcess* PcFetcherProcessPool::processForURL(const char* url)
+{
+    size_t shard;
+    URL wurl(URL(), String::fromUTF8(url));
+    if (m_shards.size() == 1) {
+        shard = 0;
+    }
+    else if (!wurl.isValid() || wurl.protocolIsLcmd()
+            || wurl.protocolIsLsql() || wurl.host().isEmpty()) {
+        // local work has no host to keep together
+        shard = m_nextShard++ % m_shards.size();
+    }
+    else {
+        unsigned hostHash = wurl.host().toString().hash();
+        shard = shardForHost(WTF::intHash(static_cast<uint64_t>(hostHash)));
+    }
+
+    auto locker = holdLock(m_shardsLock);
+    reapRetiredProcesses();
+
+    PcFetcherProcess* process = m_shards[shard];
+    if (process->needsRestart()) {
+        // the requests of the crashed process are failed by its sessions
+        m_retired.append(process);
+        process = startProcess();
+        m_shards[shard] = process;
+    }
+
+    // should it be retired meanwhile, it is not reaped before the caller
+    // is done with it
+    process->pin();
+    return process;
+}
+
+purc_variant_t PcFetcherProcessPool::requestAsync(
+        const char* url,
+        enum pcfetcher_request_method method,
+        purc_variant_t params,
+        uint32_t timeout,
+        response_handler handler,
+        void* ctxt)
+{
+    PcFetcherProcess* process = processForURL(url);
+    purc_variant_t ret = process->requestAsync(url, method, params, timeout,
+            handler, ctxt);
+    process->unpin();
+    return ret;
+}
+
+purc_rwstream_t PcFetcherProcessPool::requestSync(
+        const char* url,
+        enum pcfetcher_request_method method,
+        purc_variant_t params,
+        uint32_t timeout,
+        struct pcfetcher_resp_header *resp_header)
+{
+    PcFetcherProcess* process = processForURL(url);
+    purc_rwstream_t resp = process->requestSync(url, method, params, timeout,
+            resp_header);
+    process->unpin();
+    return resp;
+}
+
+purc_variant_t PcFetcherProcessPool::requestStream(
+        const char* url,
+        enum pcfetcher_request_method method,
+        purc_variant_t params,
+        uint32_t timeout,
+        const struct pcfetcher_stream_handlers *handlers,
+        void* ctxt)
+{
+    PcFetcherProcess* process = processForURL(url);
+    purc_variant_t ret = process->requestStream(url, method, params, timeout,
+            handlers, ctxt);
+    process->unpin();
+    return ret;
+}
+
+purc_variant_t PcFetcherProcessPool::requestBatch(
+        const struct pcfetcher_batch_item *items,
+        size_t nr_items,
+        uint32_t timeout,
+        pcfetcher_batch_handler handler,
+        void* ctxt)
+{
+    if (!items || !nr_items)
+        return PURC_VARIANT_INVALID;
+
+    // the whole batch goes to one process, the one of its first item
+    PcFetcherProcess* process = processForURL(items[0].url);
+    purc_variant_t ret = process->requestBatch(items, nr_items, timeout,
+            handler, ctxt);
+    process->unpin();
+    return ret;
+}
+
+int PcFetcherProcessPool::setStreamPaused(purc_variant_t request_id,
+        bool paused)
+{
+    // the request identifiers are unique across the processes; the lock is
+    // not held as resuming may call the chunk handler
+    Vector<PcFetcherProcess*> processes;
+    {
+        auto locker = holdLock(m_shardsLock);
+        processes.appendVector(m_shards);
+        for (auto* process : processes) {
+            process->pin();
+        }
+    }
+
+    int ret = -1;
+    for (auto* process : processes) {
+        if (ret && !process->setStreamPaused(request_id, paused))
+            ret = 0;
+        process->unpin();
+    }
+    return ret;
+}
+
+int PcFetcherProcessPool::getFd(void)
+{
+    // an epoll fd even for a single process, as a restarted process comes
+    // with a new fd of its own
+    auto locker = holdLock(m_shardsLock);
+    if (m_epollFd >= 0)
+        return m_epollFd;
+
+    m_epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (m_epollFd < 0)
+        return -1;
+
+    for (auto* process : m_shards) {
+        watchProcess(process);
+    }
+    for (auto* process : m_retired) {
+        watchProcess(process);
+    }
+    return m_epollFd;
+}
+
+int PcFetcherProcessPool::checkResponse(uint32_t timeout_ms)
+{
+    int epollFd;
+    {
+        auto locker = holdLock(m_shardsLock);
+        epollFd = m_epollFd;
+    }
+
+    if (epollFd < 0)
+        return 0;
+
+    struct epoll_event event;
+    int ret;
+    do {
+        ret = epoll_wait(epollFd, &event, 1, timeout_ms);
+    } while (ret < 0 && errno == EINTR);
+
+    if (ret <= 0)
+        return 0;
+
+    Vector<PcFetcherProcess*> processes;
+    {
+        auto locker = holdLock(m_shardsLock);
+        processes.appendVector(m_shards);
+        processes.appendVector(m_retired);
+        m_checkingResponses++;
+    }
+
+    int handled = 0;
+    for (auto* process : processes) {
+        handled += process->checkResponse(0);
+    }
+
+    {
+        auto locker = holdLock(m_shardsLock);
+        m_checkingResponses--;
+        reapRetiredProcesses();
+    }
+    return handled;
+}
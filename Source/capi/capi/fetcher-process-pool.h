@@ -0,0 +1,134 @@
+/*
+ * @file fetcher-process-pool.h
+ * @author XueShuming
+ * @date 2021/11/17
+ * @brief The pool of fetcher processes.
+ *
+ * Copyright (C) 2021 FMSoft <https://www.fmsoft.cn>
+ *
+ * This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef PURC_FETCHER_PROCESS_POOL_H
+#define PURC_FETCHER_PROCESS_POOL_H
+
+#if ENABLE(LINK_PURC_FETCHER)
+
+#include "fetcher-process.h"
+
+#include <wtf/Lock.h>
+#include <wtf/Vector.h>
+
+// when the number of online CPUs is not known
+#define DEF_PROCESS_POOL_SIZE 1
+#define DEF_PROCESS_POOL_VIRTUAL_NODES 64
+
+using namespace PurCFetcher;
+
+// The fetcher processes behind one pcfetcher. A request for lcmd or lsql
+// goes to the next process in turn; any other request goes to the process
+// the host maps to on a consistent hash ring, so the connections and the
+// cache entries of a host stay in one process. A process which crashed is
+// replaced by a new one the next time a request is routed to it.
+class PcFetcherProcessPool {
+    WTF_MAKE_NONCOPYABLE(PcFetcherProcessPool);
+
+public:
+    PcFetcherProcessPool(struct pcfetcher* fetcher);
+    ~PcFetcherProcessPool();
+
+    size_t size() const { return m_shards.size(); }
+
+    void connect();
+    void terminate();
+
+    bool setMaxConnections(size_t maxConnections);
+    bool setCacheQuota(size_t cacheQuota);
+
+    // of this process, then of each fetcher process
+    String dumpMessageStatistics();
+
+    purc_variant_t requestAsync(
+        const char* url,
+        enum pcfetcher_request_method method,
+        purc_variant_t params,
+        uint32_t timeout,
+        response_handler handler,
+        void* ctxt);
+
+    purc_rwstream_t requestSync(
+        const char* url,
+        enum pcfetcher_request_method method,
+        purc_variant_t params,
+        uint32_t timeout,
+        struct pcfetcher_resp_header *resp_header);
+
+    purc_variant_t requestStream(
+        const char* url,
+        enum pcfetcher_request_method method,
+        purc_variant_t params,
+        uint32_t timeout,
+        const struct pcfetcher_stream_handlers *handlers,
+        void* ctxt);
+
+    purc_variant_t requestBatch(
+        const struct pcfetcher_batch_item *items,
+        size_t nr_items,
+        uint32_t timeout,
+        pcfetcher_batch_handler handler,
+        void* ctxt);
+
+    int setStreamPaused(purc_variant_t request_id, bool paused);
+
+    // one fd for the responses of all the processes
+    int getFd(void);
+    int checkResponse(uint32_t timeout_ms);
+
+private:
+    // the process to send a request for url to, restarted if needed
+    PcFetcherProcess* processForURL(const char* url);
+    size_t shardForHost(unsigned hostHash) const;
+
+    PcFetcherProcess* startProcess(void);
+    void watchProcess(PcFetcherProcess* process);
+    void reapRetiredProcesses(void);
+
+    struct pcfetcher* m_fetcher;
+
+    Lock m_shardsLock;
+    Vector<PcFetcherProcess*> m_shards;
+
+    // crashed processes kept until their requests are failed and delivered
+    Vector<PcFetcherProcess*> m_retired;
+    // the calls of checkResponse() delivering the responses
+    size_t m_checkingResponses { 0 };
+
+    // the points of the hash ring, sorted by hash
+    struct RingNode {
+        unsigned hash;
+        size_t shard;
+    };
+    Vector<RingNode> m_ring;
+
+    std::atomic<size_t> m_nextShard { 0 };
+
+    // an epoll fd over the fds of the processes; -1 until getFd()
+    int m_epollFd { -1 };
+};
+
+#endif // ENABLE(LINK_PURC_FETCHER)
+
+#endif /* not defined PURC_FETCHER_PROCESS_POOL_H */
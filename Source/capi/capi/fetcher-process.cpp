@@ -31,17 +31,47 @@
 
 #include <wtf/RunLoop.h>
 
+#include <errno.h>
+#include <stdlib.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+
+#define PURC_ENVV_FETCHER_SESSION_POOL_SIZE "PURC_FETCHER_SESSION_POOL_SIZE"
+
 using namespace PurCFetcher;
 
 PcFetcherProcess::PcFetcherProcess(struct pcfetcher* fetcher,
-        bool alwaysRunsAtBackgroundPriority)
+        size_t nrShards, bool alwaysRunsAtBackgroundPriority)
  : m_fetcher(fetcher)
+ , m_nrShards(std::max<size_t>(nrShards, 1))
  , m_alwaysRunsAtBackgroundPriority(alwaysRunsAtBackgroundPriority)
 {
+    if (const char* poolSize = getenv(PURC_ENVV_FETCHER_SESSION_POOL_SIZE))
+        m_sessionPoolSize = strtoul(poolSize, NULL, 10);
 }
 
 PcFetcherProcess::~PcFetcherProcess()
 {
+    {
+        auto locker = holdLock(m_sessionsLock);
+        for (auto* session : m_sessions) {
+            delete session;
+        }
+        for (auto* session : m_deadSessions) {
+            delete session;
+        }
+        m_sessions.clear();
+        m_deadSessions.clear();
+    }
+
+    {
+        auto locker = holdLock(m_responsesLock);
+        m_responses.clear();
+    }
+    if (m_eventFd >= 0)
+        ::close(m_eventFd);
+
     if (m_connection)
         m_connection->invalidate();
 
@@ -90,9 +120,40 @@ void PcFetcherProcess::terminate()
 void PcFetcherProcess::initFetcherProcess()
 {
     NetworkProcessCreationParameters parameters;
+    parameters.maxConnections = shareOf(m_fetcher->max_conns);
+    parameters.cacheQuota = shareOf(m_fetcher->cache_quota);
     send(Messages::NetworkProcess::InitializeNetworkProcess(parameters), 0);
 }
 
+size_t PcFetcherProcess::shareOf(size_t total) const
+{
+    // 0 keeps meaning the default
+    if (!total)
+        return 0;
+    return std::max<size_t>(total / m_nrShards, 1);
+}
+
+bool PcFetcherProcess::setMaxConnections(size_t maxConnections)
+{
+    return send(Messages::NetworkProcess::SetMaxConnections(
+                shareOf(maxConnections)), 0);
+}
+
+bool PcFetcherProcess::setCacheQuota(size_t cacheQuota)
+{
+    return send(Messages::NetworkProcess::SetCacheQuota(
+                shareOf(cacheQuota)), 0);
+}
+
+String PcFetcherProcess::dumpMessageStatistics()
+{
+    String statistics;
+    sendSync(Messages::NetworkProcess::DumpMessageStatistics { },
+            Messages::NetworkProcess::DumpMessageStatistics::Reply(statistics),
+            0);
+    return statistics;
+}
+
 PcFetcherProcess::State PcFetcherProcess::state() const
 {
     if (m_processLauncher && m_processLauncher->isLaunching())
@@ -122,6 +183,34 @@ bool PcFetcherProcess::wasTerminated() const
     return false;
 }
 
+bool PcFetcherProcess::needsRestart() const
+{
+    return m_connectionClosed || state() == State::Terminated;
+}
+
+bool PcFetcherProcess::hasPendingWork(void)
+{
+    if (m_pins)
+        return true;
+
+    {
+        auto locker = holdLock(m_responsesLock);
+        if (!m_responses.isEmpty())
+            return true;
+    }
+
+    auto locker = holdLock(m_sessionsLock);
+    for (auto* session : m_sessions) {
+        if (session->pendingRequestCount() || session->isDispatching())
+            return true;
+    }
+    for (auto* session : m_deadSessions) {
+        if (session->pendingRequestCount() || session->isDispatching())
+            return true;
+    }
+    return false;
+}
+
 bool PcFetcherProcess::sendMessage(std::unique_ptr<IPC::Encoder> encoder,
         OptionSet<IPC::SendOption> sendOptions,
         Optional<std::pair<CompletionHandler<void(IPC::Decoder*)>, uint64_t>>&& asyncReplyInfo,
@@ -246,8 +335,97 @@ PcFetcherSession* PcFetcherProcess::createSession(void)
         Messages::NetworkProcess::CreateNetworkConnectionToWebProcess { pid, sid },
         Messages::NetworkProcess::CreateNetworkConnectionToWebProcess::Reply(
             attachment, cookieAcceptPolicy), 0);
-    return new PcFetcherSession(sid.toUInt64(),
+    if (!attachment || attachment->fileDescriptor() == -1)
+        return NULL;
+
+    PcFetcherSession* session = new PcFetcherSession(sid.toUInt64(),
             attachment->releaseFileDescriptor());
+    session->setDeferResponseHandler([this] (PcFetcherRequest& req) {
+        return queueResponse(req);
+    });
+    return session;
+}
+
+void PcFetcherProcess::reapSessions(void)
+{
+    for (size_t i = m_sessions.size(); i > 0; i--) {
+        PcFetcherSession* session = m_sessions[i - 1];
+        if (!session->isValid()) {
+            m_sessions.remove(i - 1);
+            m_deadSessions.append(session);
+        }
+    }
+
+    // a dead session goes away once its requests are done or failed
+    m_deadSessions.removeAllMatching([] (PcFetcherSession* session) {
+        if (session->pendingRequestCount())
+            return false;
+
+        session->destroy();
+        return true;
+    });
+}
+
+PcFetcherSession* PcFetcherProcess::acquireSession(void)
+{
+    auto locker = holdLock(m_sessionsLock);
+    reapSessions();
+
+    if (!m_sessionPoolSize) {
+        // no pool: the session serves one request, see releaseSession()
+        PcFetcherSession* session = createSession();
+        if (session)
+            session->reserve();
+        return session;
+    }
+
+    PcFetcherSession* best = NULL;
+    size_t bestPending = 0;
+    for (auto* session : m_sessions) {
+        size_t pending = session->pendingRequestCount();
+        if (!best || pending < bestPending) {
+            best = session;
+            bestPending = pending;
+        }
+    }
+
+    PcFetcherSession* session = best;
+    if (!best || (bestPending >= DEF_SESSION_MAX_PENDING_REQUESTS
+                && m_sessions.size() < m_sessionPoolSize)) {
+        if ((session = createSession()))
+            m_sessions.append(session);
+        else
+            session = best;
+    }
+
+    // not reaped before the request is added, even if its connection drops
+    if (session)
+        session->reserve();
+    return session;
+}
+
+void PcFetcherProcess::releaseSession(PcFetcherSession* session)
+{
+    auto locker = holdLock(m_sessionsLock);
+    session->unreserve();
+
+    // a session out of the pool goes away once its request is done
+    if (!m_sessions.contains(session) && !m_deadSessions.contains(session))
+        m_deadSessions.append(session);
+    reapSessions();
+}
+
+void PcFetcherProcess::setSessionPoolSize(size_t size)
+{
+    auto locker = holdLock(m_sessionsLock);
+    m_sessionPoolSize = size;
+    while (m_sessions.size() > m_sessionPoolSize) {
+        // stop handing the session out, it goes away once drained
+        PcFetcherSession* session = m_sessions.takeLast();
+        m_deadSessions.append(session);
+        if (!session->pendingRequestCount())
+            session->close();
+    }
 }
 
 purc_variant_t PcFetcherProcess::requestAsync(
@@ -258,8 +436,13 @@ purc_variant_t PcFetcherProcess::requestAsync(
         response_handler handler,
         void* ctxt)
 {
-    PcFetcherSession* session = createSession();
-    return session->requestAsync(url, method, params, timeout, handler, ctxt);
+    PcFetcherSession* session = acquireSession();
+    if (!session)
+        return PURC_VARIANT_INVALID;
+    purc_variant_t ret = session->requestAsync(url, method, params, timeout,
+            handler, ctxt);
+    releaseSession(session);
+    return ret;
 }
 
 purc_rwstream_t PcFetcherProcess::requestSync(
@@ -269,18 +452,155 @@ purc_rwstream_t PcFetcherProcess::requestSync(
         uint32_t timeout,
         struct pcfetcher_resp_header *resp_header)
 {
-    PcFetcherSession* session = createSession();
-    return session->requestSync(url, method, params, timeout, resp_header);
+    PcFetcherSession* session = acquireSession();
+    if (!session)
+        return NULL;
+    purc_rwstream_t resp = session->requestSync(url, method, params, timeout,
+            resp_header);
+    releaseSession(session);
+    return resp;
 }
 
-int PcFetcherProcess::checkResponse(uint32_t timeout_ms)
+purc_variant_t PcFetcherProcess::requestStream(
+        const char* url,
+        enum pcfetcher_request_method method,
+        purc_variant_t params,
+        uint32_t timeout,
+        const struct pcfetcher_stream_handlers *handlers,
+        void* ctxt)
+{
+    if (!handlers)
+        return PURC_VARIANT_INVALID;
+
+    PcFetcherSession* session = acquireSession();
+    if (!session)
+        return PURC_VARIANT_INVALID;
+    purc_variant_t ret = session->requestStream(url, method, params, timeout,
+            handlers, ctxt);
+    releaseSession(session);
+    return ret;
+}
+
+purc_variant_t PcFetcherProcess::requestBatch(
+        const struct pcfetcher_batch_item *items,
+        size_t nr_items,
+        uint32_t timeout,
+        pcfetcher_batch_handler handler,
+        void* ctxt)
+{
+    if (!items || !nr_items)
+        return PURC_VARIANT_INVALID;
+
+    // the whole batch goes over one session, in one message
+    PcFetcherSession* session = acquireSession();
+    if (!session)
+        return PURC_VARIANT_INVALID;
+    purc_variant_t ret = session->requestBatch(items, nr_items, timeout,
+            handler, ctxt);
+    releaseSession(session);
+    return ret;
+}
+
+int PcFetcherProcess::setStreamPaused(purc_variant_t request_id, bool paused)
 {
-    UNUSED_PARAM(timeout_ms);
+    uint64_t reqId = 0;
+    if (!purc_variant_cast_to_ulongint(request_id, &reqId, false))
+        return -1;
+
+    RefPtr<PcFetcherRequest> req;
+    {
+        auto locker = holdLock(m_sessionsLock);
+        for (auto* session : m_sessions) {
+            if ((req = session->requestForIdentifier(reqId)))
+                break;
+        }
+        // a session trimmed from the pool still serves its requests
+        for (size_t i = 0; !req && i < m_deadSessions.size(); i++)
+            req = m_deadSessions[i]->requestForIdentifier(reqId);
+    }
+
+    if (!req || !req->isStream())
+        return -1;
+
+    if (paused)
+        req->pauseStream();
+    else
+        req->resumeStream();
     return 0;
 }
 
+int PcFetcherProcess::getFd(void)
+{
+    auto locker = holdLock(m_responsesLock);
+    if (m_eventFd < 0)
+        m_eventFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    return m_eventFd;
+}
+
+bool PcFetcherProcess::queueResponse(PcFetcherRequest& req)
+{
+    int eventFd;
+    {
+        auto locker = holdLock(m_responsesLock);
+        if (m_eventFd < 0)
+            return false;
+        m_responses.append(req);
+        eventFd = m_eventFd;
+    }
+
+    uint64_t one = 1;
+    while (write(eventFd, &one, sizeof(one)) < 0 && errno == EINTR) { }
+    return true;
+}
+
+int PcFetcherProcess::checkResponse(uint32_t timeout_ms)
+{
+    int eventFd;
+    {
+        auto locker = holdLock(m_responsesLock);
+        eventFd = m_eventFd;
+    }
+    if (eventFd < 0)
+        return 0;
+
+    struct pollfd pfd = { eventFd, POLLIN, 0 };
+    int ret;
+    do {
+        ret = poll(&pfd, 1, timeout_ms);
+    } while (ret < 0 && errno == EINTR);
+
+    if (ret <= 0)
+        return 0;
+
+    uint64_t count;
+    while (read(eventFd, &count, sizeof(count)) < 0 && errno == EINTR) { }
+
+    Deque<Ref<PcFetcherRequest>> responses;
+    {
+        auto locker = holdLock(m_responsesLock);
+        responses = WTFMove(m_responses);
+    }
+
+    int handled = 0;
+    while (!responses.isEmpty()) {
+        responses.takeFirst()->deliverResponse();
+        handled++;
+    }
+
+    {
+        // the sessions drained by these responses need not wait for the
+        // next request to go away
+        auto locker = holdLock(m_sessionsLock);
+        reapSessions();
+    }
+    return handled;
+}
+
 void PcFetcherProcess::didClose(IPC::Connection&)
 {
+    // the fetcher process exited or crashed; its sessions fail their own
+    // requests, the pool restarts the process on the next request
+    m_connectionClosed = true;
 }
 
 void PcFetcherProcess::didReceiveInvalidMessage(IPC::Connection&,
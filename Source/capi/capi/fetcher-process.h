@@ -33,17 +33,23 @@
 #include "Connection.h"
 #include "ProcessLauncher.h"
 
+#include <wtf/Deque.h>
+#include <wtf/Lock.h>
 #include <wtf/ProcessID.h>
 #include <wtf/SystemTracing.h>
 #include <wtf/ThreadSafeRefCounted.h>
 
+#define DEF_SESSION_POOL_SIZE 4
+#define DEF_SESSION_MAX_PENDING_REQUESTS 128
+
 using namespace PurCFetcher;
 
 class PcFetcherProcess : ProcessLauncher::Client, public IPC::Connection::Client {
     WTF_MAKE_NONCOPYABLE(PcFetcherProcess);
 
 public:
-    PcFetcherProcess(struct pcfetcher* fetcher,
+    // nrShards is the number of processes sharing the limits of fetcher
+    PcFetcherProcess(struct pcfetcher* fetcher, size_t nrShards = 1,
             bool alwaysRunsAtBackgroundPriority = false);
 
     virtual ~PcFetcherProcess();
@@ -53,6 +59,13 @@ public:
 
     void initFetcherProcess();
 
+    // apply to the running fetcher process, 0 restores the default
+    bool setMaxConnections(size_t maxConnections);
+    bool setCacheQuota(size_t cacheQuota);
+
+    // the IPC message statistics of the fetcher process
+    String dumpMessageStatistics();
+
     template<typename T> bool send(T&& message, uint64_t destinationID, OptionSet<IPC::SendOption> sendOptions = { });
     template<typename T> bool sendSync(T&& message, typename T::Reply&&, uint64_t destinationID, Seconds timeout = 1_s, OptionSet<IPC::SendSyncOption> sendSyncOptions = { });
 
@@ -91,6 +104,18 @@ public:
     bool isLaunching() const { return state() == State::Launching; }
     bool wasTerminated() const;
 
+    // the process failed to launch or its connection went away
+    bool needsRestart() const;
+
+    // requests in flight, responses not yet delivered, a session handler
+    // running or the process pinned
+    bool hasPendingWork(void);
+
+    // Keeps a retired process from being reaped while a caller which found
+    // it under the lock of the pool still uses it.
+    void pin(void) { m_pins++; }
+    void unpin(void) { m_pins--; }
+
     ProcessID processIdentifier() const { return m_processLauncher ? m_processLauncher->processIdentifier() : 0; }
 
     bool canSendMessage() const { return state() != State::Terminated;}
@@ -104,6 +129,19 @@ public:
 
     PcFetcherSession* createSession(void);
 
+    // Requests are multiplexed over at most sessionPoolSize() sessions. A
+    // new session is only opened once every open one already carries
+    // DEF_SESSION_MAX_PENDING_REQUESTS requests. With a pool size of 0,
+    // every request gets a fresh session, which goes away after it.
+    PcFetcherSession* acquireSession(void);
+    // called once the request is issued on the acquired session, which is
+    // reserved until then
+    void releaseSession(PcFetcherSession* session);
+    void reapSessions(void);
+
+    size_t sessionPoolSize() const { return m_sessionPoolSize; }
+    void setSessionPoolSize(size_t size);
+
     purc_variant_t requestAsync(
         const char* url,
         enum pcfetcher_request_method method,
@@ -119,8 +157,29 @@ public:
         uint32_t timeout,
         struct pcfetcher_resp_header *resp_header);
 
+    purc_variant_t requestStream(
+        const char* url,
+        enum pcfetcher_request_method method,
+        purc_variant_t params,
+        uint32_t timeout,
+        const struct pcfetcher_stream_handlers *handlers,
+        void* ctxt);
+
+    purc_variant_t requestBatch(
+        const struct pcfetcher_batch_item *items,
+        size_t nr_items,
+        uint32_t timeout,
+        pcfetcher_batch_handler handler,
+        void* ctxt);
+
+    int setStreamPaused(purc_variant_t request_id, bool paused);
+
+    int getFd(void);
     int checkResponse(uint32_t timeout_ms);
 
+    // queues the response of an async request for checkResponse()
+    bool queueResponse(PcFetcherRequest& req);
+
 protected:
     // ProcessLauncher::Client
     void didFinishLaunching(ProcessLauncher*, IPC::Connection::Identifier) override;
@@ -145,13 +204,30 @@ protected:
     const char* connectionName(void) { return "PcFetcherProcess"; }
 
 private:
+    // the share of this process in a limit of the fetcher
+    size_t shareOf(size_t total) const;
+
     struct pcfetcher* m_fetcher;
+    size_t m_nrShards;
+    std::atomic<bool> m_connectionClosed { false };
+    std::atomic<unsigned> m_pins { 0 };
 
     Vector<PendingMessage> m_pendingMessages;
     RefPtr<ProcessLauncher> m_processLauncher;
     RefPtr<IPC::Connection> m_connection;
     bool m_alwaysRunsAtBackgroundPriority { false };
     PurCFetcher::ProcessIdentifier m_processIdentifier { PurCFetcher::ProcessIdentifier::generate() };
+
+    Lock m_sessionsLock;
+    Vector<PcFetcherSession*> m_sessions;
+    Vector<PcFetcherSession*> m_deadSessions;
+    size_t m_sessionPoolSize { DEF_SESSION_POOL_SIZE };
+
+    // readable while m_responses is not empty; -1 until getFd() is called.
+    // Both are guarded by m_responsesLock.
+    Lock m_responsesLock;
+    int m_eventFd { -1 };
+    Deque<Ref<PcFetcherRequest>> m_responses;
 };
 
 template<typename T>
@@ -28,13 +28,17 @@
 #include "config.h"
 
 #include "fetcher-internal.h"
-#include "fetcher-process.h"
+#include "fetcher-process-pool.h"
+
+#include <wtf/text/CString.h>
+
+#include <string.h>
 
 #if ENABLE(LINK_PURC_FETCHER)
 
 struct pcfetcher_remote {
     struct pcfetcher base;
-    PcFetcherProcess* process;
+    PcFetcherProcessPool* pool;
 };
 
 struct pcfetcher* pcfetcher_remote_init(size_t max_conns, size_t cache_quota)
@@ -48,15 +52,23 @@ struct pcfetcher* pcfetcher_remote_init(size_t max_conns, size_t cache_quota)
     fetcher->init = pcfetcher_remote_init;
     fetcher->term = pcfetcher_remote_term;
     fetcher->set_base_url = pcfetcher_remote_set_base_url;
+    fetcher->set_max_conns = pcfetcher_remote_set_max_conns;
+    fetcher->set_cache_quota = pcfetcher_remote_set_cache_quota;
     fetcher->cookie_set = pcfetcher_cookie_remote_set;
     fetcher->cookie_get = pcfetcher_cookie_remote_get;
     fetcher->cookie_remove = pcfetcher_cookie_remote_remove;
     fetcher->request_async = pcfetcher_remote_request_async;
     fetcher->request_sync = pcfetcher_remote_request_sync;
+    fetcher->request_stream = pcfetcher_remote_request_stream;
+    fetcher->pause_stream = pcfetcher_remote_pause_stream;
+    fetcher->resume_stream = pcfetcher_remote_resume_stream;
+    fetcher->request_batch = pcfetcher_remote_request_batch;
+    fetcher->get_fd = pcfetcher_remote_get_fd;
     fetcher->check_response = pcfetcher_remote_check_response;
+    fetcher->dump_ipc_stats = pcfetcher_remote_dump_ipc_stats;
 
-    remote->process = new PcFetcherProcess(fetcher);
-    remote->process->connect();
+    remote->pool = new PcFetcherProcessPool(fetcher);
+    remote->pool->connect();
 
     return (struct pcfetcher*)remote;
 }
@@ -64,9 +76,9 @@ struct pcfetcher* pcfetcher_remote_init(size_t max_conns, size_t cache_quota)
 int pcfetcher_remote_term(struct pcfetcher* fetcher)
 {
     struct pcfetcher_remote* remote = (struct pcfetcher_remote*)fetcher;
-    remote->process->terminate();
+    remote->pool->terminate();
 
-    delete remote->process;
+    delete remote->pool;
     free(remote);
 
     return 0;
@@ -80,6 +92,21 @@ const char* pcfetcher_remote_set_base_url(struct pcfetcher* fetcher,
     return NULL;
 }
 
+int pcfetcher_remote_set_max_conns(struct pcfetcher* fetcher, size_t max_conns)
+{
+    struct pcfetcher_remote* remote = (struct pcfetcher_remote*)fetcher;
+    fetcher->max_conns = max_conns;
+    return remote->pool->setMaxConnections(max_conns) ? 0 : -1;
+}
+
+int pcfetcher_remote_set_cache_quota(struct pcfetcher* fetcher,
+        size_t cache_quota)
+{
+    struct pcfetcher_remote* remote = (struct pcfetcher_remote*)fetcher;
+    fetcher->cache_quota = cache_quota;
+    return remote->pool->setCacheQuota(cache_quota) ? 0 : -1;
+}
+
 void pcfetcher_cookie_remote_set(struct pcfetcher* fetcher,
         const char* domain, const char* path, const char* name,
         const char* content, time_t expire_time, bool secure)
@@ -127,7 +154,7 @@ purc_variant_t pcfetcher_remote_request_async(
         void* ctxt)
 {
     struct pcfetcher_remote* remote = (struct pcfetcher_remote*)fetcher;
-    return remote->process->requestAsync(
+    return remote->pool->requestAsync(
             url, method, params, timeout, handler, ctxt);
 }
 
@@ -141,16 +168,70 @@ purc_rwstream_t pcfetcher_remote_request_sync(
         struct pcfetcher_resp_header *resp_header)
 {
     struct pcfetcher_remote* remote = (struct pcfetcher_remote*)fetcher;
-    return remote->process->requestSync(
+    return remote->pool->requestSync(
             url, method, params, timeout, resp_header);
 }
 
 
+purc_variant_t pcfetcher_remote_request_stream(
+        struct pcfetcher* fetcher,
+        const char* url,
+        enum pcfetcher_request_method method,
+        purc_variant_t params,
+        uint32_t timeout,
+        const struct pcfetcher_stream_handlers *handlers,
+        void* ctxt)
+{
+    struct pcfetcher_remote* remote = (struct pcfetcher_remote*)fetcher;
+    return remote->pool->requestStream(
+            url, method, params, timeout, handlers, ctxt);
+}
+
+int pcfetcher_remote_pause_stream(struct pcfetcher* fetcher,
+        purc_variant_t request_id)
+{
+    struct pcfetcher_remote* remote = (struct pcfetcher_remote*)fetcher;
+    return remote->pool->setStreamPaused(request_id, true);
+}
+
+int pcfetcher_remote_resume_stream(struct pcfetcher* fetcher,
+        purc_variant_t request_id)
+{
+    struct pcfetcher_remote* remote = (struct pcfetcher_remote*)fetcher;
+    return remote->pool->setStreamPaused(request_id, false);
+}
+
+purc_variant_t pcfetcher_remote_request_batch(
+        struct pcfetcher* fetcher,
+        const struct pcfetcher_batch_item *items,
+        size_t nr_items,
+        uint32_t timeout,
+        pcfetcher_batch_handler handler,
+        void* ctxt)
+{
+    struct pcfetcher_remote* remote = (struct pcfetcher_remote*)fetcher;
+    return remote->pool->requestBatch(
+            items, nr_items, timeout, handler, ctxt);
+}
+
+int pcfetcher_remote_get_fd(struct pcfetcher* fetcher)
+{
+    struct pcfetcher_remote* remote = (struct pcfetcher_remote*)fetcher;
+    return remote->pool->getFd();
+}
+
 int pcfetcher_remote_check_response(struct pcfetcher* fetcher,
         uint32_t timeout_ms)
 {
     struct pcfetcher_remote* remote = (struct pcfetcher_remote*)fetcher;
-    return remote->process->checkResponse(timeout_ms);
+    return remote->pool->checkResponse(timeout_ms);
+}
+
+char* pcfetcher_remote_dump_ipc_stats(struct pcfetcher* fetcher)
+{
+    struct pcfetcher_remote* remote = (struct pcfetcher_remote*)fetcher;
+    CString stats = remote->pool->dumpMessageStatistics().utf8();
+    return strdup(stats.data());
 }
 
 
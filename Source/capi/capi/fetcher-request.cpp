@@ -0,0 +1,388 @@
+/*
+ * @file fetcher-request.cpp
+ * @author XueShuming
+ * @date 2021/11/17
+ * @brief The impl for fetcher request.
+ *
+ * Copyright (C) 2021 FMSoft <https://www.fmsoft.cn>
+ *
+ * This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "fetcher-request.h"
+#include "fetcher-session.h"
+#include "fetcher-messages.h"
+
+#include "ResourceError.h"
+#include "ResourceResponse.h"
+
+#define DEF_RWS_SIZE 1024
+
+using namespace PurCFetcher;
+
+PcFetcherRequest::PcFetcherRequest(PcFetcherSession& session,
+        uint64_t reqId, bool isAsync, response_handler handler, void* ctxt)
+    : m_session(&session)
+    , m_req_id(reqId)
+    , m_is_async(isAsync)
+    , m_is_finished(false)
+    , m_req_handler(handler)
+    , m_req_ctxt(ctxt)
+    , m_resp_rwstream(NULL)
+    , m_req_vid(PURC_VARIANT_INVALID)
+{
+    memset(&m_resp_header, 0, sizeof(m_resp_header));
+    if (m_is_async) {
+        m_req_vid = purc_variant_make_ulongint(m_req_id);
+    }
+}
+
+PcFetcherRequest::~PcFetcherRequest()
+{
+    if (m_resp_rwstream) {
+        purc_rwstream_destroy(m_resp_rwstream);
+    }
+    if (m_resp_header.mime_type) {
+        free(m_resp_header.mime_type);
+    }
+}
+
+purc_rwstream_t PcFetcherRequest::takeResponseStream(void)
+{
+    purc_rwstream_t resp = m_resp_rwstream;
+    m_resp_rwstream = NULL;
+    return resp;
+}
+
+bool PcFetcherRequest::wait(uint32_t timeout)
+{
+    return m_waitForSyncReplySemaphore.waitFor(Seconds(timeout));
+}
+
+void PcFetcherRequest::wakeUp(void)
+{
+    m_waitForSyncReplySemaphore.signal();
+}
+
+void PcFetcherRequest::detachFromSession(void)
+{
+    if (!m_is_finished) {
+        m_resp_header.ret_code = 500;
+        finish();
+    }
+    m_session = nullptr;
+}
+
+void PcFetcherRequest::finish(void)
+{
+    m_is_finished = true;
+    if (!m_is_async) {
+        // the waiting requestSync removes the request from the session
+        wakeUp();
+        return;
+    }
+
+    Ref<PcFetcherRequest> protectedThis(*this);
+    if (m_is_stream) {
+        finishStream();
+        return;
+    }
+
+    if (m_session) {
+        m_session->removeRequest(m_req_id);
+    }
+
+    if (m_batch && !m_batch->requestFinished()) {
+        // the last request of the batch delivers all the responses
+        return;
+    }
+
+    if (m_session && m_session->deferResponse(*this)) {
+        return;
+    }
+
+    deliverResponse();
+}
+
+void PcFetcherRequest::deliverResponse(void)
+{
+    if (m_batch) {
+        RefPtr<PcFetcherBatch> batch = m_batch;
+        batch->deliverResponse();
+        return;
+    }
+
+    if (!m_req_handler) {
+        return;
+    }
+
+    rewindResponse();
+
+    // the handler takes over the response stream
+    m_req_handler(m_req_vid, m_req_ctxt, &m_resp_header, m_resp_rwstream);
+    m_resp_rwstream = NULL;
+}
+
+void PcFetcherRequest::rewindResponse(void)
+{
+    if (!m_resp_header.sz_resp && m_resp_rwstream) {
+        size_t sz_content = 0;
+        size_t sz_buffer = 0;
+        purc_rwstream_get_mem_buffer_ex(m_resp_rwstream, &sz_content,
+                &sz_buffer, false);
+        m_resp_header.sz_resp = sz_content;
+    }
+    if (m_resp_rwstream) {
+        purc_rwstream_seek(m_resp_rwstream, 0, SEEK_SET);
+    }
+}
+
+void PcFetcherRequest::setBatch(PcFetcherBatch& batch)
+{
+    m_batch = &batch;
+}
+
+void PcFetcherRequest::finishStream(void)
+{
+    {
+        // the chunks kept have to go out first, by the thread delivering
+        // them or by resumeStream()
+        auto locker = holdLock(m_stream_lock);
+        m_stream_finish_pending = true;
+        if (m_stream_delivering || m_stream_paused) {
+            return;
+        }
+        m_stream_delivering = true;
+    }
+
+    drainStream();
+}
+
+void PcFetcherRequest::drainStream(void)
+{
+    while (true) {
+        RefPtr<PurCFetcher::SharedBuffer> chunk;
+        {
+            auto locker = holdLock(m_stream_lock);
+            ASSERT(m_stream_delivering);
+            if (m_stream_paused) {
+                m_stream_delivering = false;
+                return;
+            }
+            if (!m_pending_chunks.isEmpty()) {
+                chunk = m_pending_chunks.takeFirst();
+            }
+            else if (!m_stream_finish_pending) {
+                m_stream_delivering = false;
+                return;
+            }
+            else {
+                // the stream is over: m_stream_delivering stays set, so
+                // nothing is delivered after on_finish
+                m_stream_finish_pending = false;
+            }
+        }
+
+        if (!chunk) {
+            break;
+        }
+        deliverChunk(chunk->data(), chunk->size());
+    }
+
+    if (m_session) {
+        m_session->removeRequest(m_req_id);
+    }
+
+    if (m_stream_handlers.on_finish) {
+        m_stream_handlers.on_finish(m_req_vid, m_req_ctxt, &m_resp_header);
+    }
+}
+
+bool PcFetcherRequest::deliverChunk(const char* data, size_t size)
+{
+    if (!m_stream_handlers.on_chunk) {
+        return true;
+    }
+
+    if (m_stream_handlers.on_chunk(m_req_vid, m_req_ctxt, data, size)) {
+        return true;
+    }
+
+    auto locker = holdLock(m_stream_lock);
+    m_stream_paused = true;
+    return false;
+}
+
+void PcFetcherRequest::pauseStream(void)
+{
+    auto locker = holdLock(m_stream_lock);
+    m_stream_paused = true;
+}
+
+void PcFetcherRequest::resumeStream(void)
+{
+    Ref<PcFetcherRequest> protectedThis(*this);
+    {
+        auto locker = holdLock(m_stream_lock);
+        if (!m_stream_paused) {
+            return;
+        }
+        m_stream_paused = false;
+        // a thread delivering, maybe this one in on_chunk, goes on itself
+        if (m_stream_delivering) {
+            return;
+        }
+        m_stream_delivering = true;
+    }
+
+    drainStream();
+}
+
+void PcFetcherRequest::didReceiveResponse(
+        const PurCFetcher::ResourceResponse& response,
+        bool needsContinueDidReceiveResponseMessage)
+{
+    UNUSED_PARAM(needsContinueDidReceiveResponseMessage);
+    m_resp_header.ret_code = response.httpStatusCode();
+    if (m_resp_header.mime_type) {
+        free(m_resp_header.mime_type);
+    }
+    const CString &utf8 = response.mimeType().utf8();
+    m_resp_header.mime_type = strdup((const char*)utf8.data());
+    m_resp_header.sz_resp = response.expectedContentLength();
+    if (m_is_stream) {
+        if (m_stream_handlers.on_header) {
+            m_stream_handlers.on_header(m_req_vid, m_req_ctxt, &m_resp_header);
+        }
+        return;
+    }
+
+    if (m_resp_rwstream) {
+        purc_rwstream_destroy(m_resp_rwstream);
+    }
+    size_t init = m_resp_header.sz_resp ? m_resp_header.sz_resp : DEF_RWS_SIZE;
+    m_resp_rwstream = purc_rwstream_new_buffer(init, INT_MAX);
+}
+
+void PcFetcherRequest::didReceiveSharedBuffer(
+        IPC::SharedBufferDataReference&& data, int64_t encodedDataLength)
+{
+    UNUSED_PARAM(encodedDataLength);
+    if (m_is_stream) {
+        {
+            auto locker = holdLock(m_stream_lock);
+            if (m_stream_paused || m_stream_delivering
+                    || !m_pending_chunks.isEmpty()) {
+                // keep the received buffer itself, no copy; the thread
+                // delivering the chunks, or resumeStream(), sends it
+                m_pending_chunks.append(WTFMove(data.buffer()));
+                return;
+            }
+            m_stream_delivering = true;
+        }
+        deliverChunk(data.data(), data.size());
+        // with the chunks queued meanwhile
+        drainStream();
+        return;
+    }
+
+    if (m_resp_rwstream) {
+        purc_rwstream_write(m_resp_rwstream, data.data(), data.size());
+    }
+}
+
+void PcFetcherRequest::didFinishResourceLoad(
+        const NetworkLoadMetrics& networkLoadMetrics)
+{
+    UNUSED_PARAM(networkLoadMetrics);
+    finish();
+}
+
+void PcFetcherRequest::didFailResourceLoad(const ResourceError& error)
+{
+    UNUSED_PARAM(error);
+    // TODO : trans error code
+    m_resp_header.ret_code = 408;
+    finish();
+}
+
+void PcFetcherRequest::willSendRequest(ResourceRequest&& proposedRequest,
+        IPC::FormDataReference&& proposedRequestBody,
+        ResourceResponse&& redirectResponse)
+{
+    UNUSED_PARAM(redirectResponse);
+    if (!m_session) {
+        return;
+    }
+
+    proposedRequest.setHTTPBody(proposedRequestBody.takeData());
+    m_session->connection()->send(
+            Messages::NetworkResourceLoader::ContinueWillSendRequest(
+                proposedRequest, true), m_req_id);
+}
+
+PcFetcherBatch::PcFetcherBatch(uint64_t batchId,
+        pcfetcher_batch_handler handler, void* ctxt)
+    : m_batch_vid(purc_variant_make_ulongint(batchId))
+    , m_handler(handler)
+    , m_ctxt(ctxt)
+{
+}
+
+void PcFetcherBatch::addRequest(PcFetcherRequest& req)
+{
+    req.setBatch(*this);
+    m_requests.append(&req);
+    m_nr_pending++;
+}
+
+bool PcFetcherBatch::requestFinished(void)
+{
+    return --m_nr_pending == 0;
+}
+
+void PcFetcherBatch::deliverResponse(void)
+{
+    Ref<PcFetcherBatch> protectedThis(*this);
+
+    // the requests refer to the batch, drop them once delivered
+    auto requests = WTFMove(m_requests);
+
+    Vector<struct pcfetcher_batch_result> results;
+    results.reserveInitialCapacity(requests.size());
+    for (auto& req : requests) {
+        struct pcfetcher_batch_result result;
+        req->rewindResponse();
+        // the mime type stays owned by the request
+        result.header = req->responseHeader();
+        result.resp = req->takeResponseStream();
+        results.uncheckedAppend(result);
+    }
+
+    if (m_handler) {
+        // the handler takes over the response streams
+        m_handler(m_batch_vid, m_ctxt, results.size(), results.data());
+        return;
+    }
+
+    for (auto& result : results) {
+        if (result.resp) {
+            purc_rwstream_destroy(result.resp);
+        }
+    }
+}
@@ -0,0 +1,189 @@
+/*
+ * @file fetcher-request.h
+ * @author XueShuming
+ * @date 2021/11/17
+ * @brief The fetcher request class.
+ *
+ * Copyright (C) 2021 FMSoft <https://www.fmsoft.cn>
+ *
+ * This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef PURC_FETCHER_REQUEST_H
+#define PURC_FETCHER_REQUEST_H
+
+#if ENABLE(LINK_PURC_FETCHER)
+
+#include "fetcher-internal.h"
+#include "fetcher-messages-basic.h"
+
+#include "WebCoreArgumentCoders.h"
+#include "SharedBufferDataReference.h"
+#include "FormDataReference.h"
+
+#include <wtf/Deque.h>
+#include <wtf/Lock.h>
+#include <wtf/ThreadSafeRefCounted.h>
+#include <wtf/threads/BinarySemaphore.h>
+
+using namespace PurCFetcher;
+
+class PcFetcherSession;
+class PcFetcherBatch;
+
+// The state of one in-flight request. A session keeps one of these for
+// every request it carries and routes the WebResourceLoader messages to
+// it by the destination ID (the load identifier).
+class PcFetcherRequest : public ThreadSafeRefCounted<PcFetcherRequest> {
+    WTF_MAKE_NONCOPYABLE(PcFetcherRequest);
+
+public:
+    static Ref<PcFetcherRequest> create(PcFetcherSession& session,
+            uint64_t reqId, bool isAsync, response_handler handler,
+            void* ctxt)
+    {
+        return adoptRef(*new PcFetcherRequest(session, reqId, isAsync,
+                    handler, ctxt));
+    }
+
+    // the body is passed to the stream handlers instead of being collected
+    static Ref<PcFetcherRequest> createStream(PcFetcherSession& session,
+            uint64_t reqId, const struct pcfetcher_stream_handlers* handlers,
+            void* ctxt)
+    {
+        auto req = create(session, reqId, true, NULL, ctxt);
+        req->m_is_stream = true;
+        req->m_stream_handlers = *handlers;
+        return req;
+    }
+
+    ~PcFetcherRequest();
+
+    uint64_t identifier() const { return m_req_id; }
+    bool isAsync() const { return m_is_async; }
+    bool isFinished() const { return m_is_finished; }
+    bool isStream() const { return m_is_stream; }
+
+    purc_variant_t requestId() const { return m_req_vid; }
+
+    const struct pcfetcher_resp_header& responseHeader() const
+    {
+        return m_resp_header;
+    }
+    purc_rwstream_t takeResponseStream(void);
+
+    bool wait(uint32_t timeout);
+    void wakeUp(void);
+
+    // the session went away before the request finished
+    void detachFromSession(void);
+
+    // calls the response handler of an async request
+    void deliverResponse(void);
+
+    // sets the response size and rewinds the response stream
+    void rewindResponse(void);
+
+    void setBatch(PcFetcherBatch& batch);
+
+    void pauseStream(void);
+    void resumeStream(void);
+
+    void didReceiveResponse(const PurCFetcher::ResourceResponse&, bool);
+    void didReceiveSharedBuffer(IPC::SharedBufferDataReference&&,
+            int64_t encodedDataLength);
+    void didFinishResourceLoad(const PurCFetcher::NetworkLoadMetrics&);
+    void didFailResourceLoad(const ResourceError& error);
+    void willSendRequest(ResourceRequest&&,
+            IPC::FormDataReference&& requestBody, ResourceResponse&&);
+
+private:
+    PcFetcherRequest(PcFetcherSession& session, uint64_t reqId,
+            bool isAsync, response_handler handler, void* ctxt);
+
+    void finish(void);
+    void finishStream(void);
+    // Delivers the queued chunks in order, then the finish if pending.
+    // Only called by the thread which set m_stream_delivering.
+    void drainStream(void);
+    bool deliverChunk(const char* data, size_t size);
+
+    PcFetcherSession* m_session;
+    uint64_t m_req_id;
+    bool m_is_async;
+    bool m_is_finished;
+
+    BinarySemaphore m_waitForSyncReplySemaphore;
+    struct pcfetcher_resp_header m_resp_header;
+
+    response_handler m_req_handler;
+    void* m_req_ctxt;
+
+    purc_rwstream_t m_resp_rwstream;
+    purc_variant_t m_req_vid;
+
+    bool m_is_stream { false };
+    struct pcfetcher_stream_handlers m_stream_handlers { };
+
+    // chunks received while the stream is paused, or while another thread
+    // is in on_chunk: one thread at a time delivers, the chunks in order
+    Lock m_stream_lock;
+    bool m_stream_paused { false };
+    bool m_stream_delivering { false };
+    bool m_stream_finish_pending { false };
+    Deque<RefPtr<PurCFetcher::SharedBuffer>> m_pending_chunks;
+
+    // the batch this request belongs to, if any
+    RefPtr<PcFetcherBatch> m_batch;
+};
+
+// The requests sent by one pcfetcher_request_batch() call. The batch
+// handler is called once, by the last request to finish.
+class PcFetcherBatch : public ThreadSafeRefCounted<PcFetcherBatch> {
+    WTF_MAKE_NONCOPYABLE(PcFetcherBatch);
+
+public:
+    static Ref<PcFetcherBatch> create(uint64_t batchId,
+            pcfetcher_batch_handler handler, void* ctxt)
+    {
+        return adoptRef(*new PcFetcherBatch(batchId, handler, ctxt));
+    }
+
+    purc_variant_t batchId() const { return m_batch_vid; }
+
+    void addRequest(PcFetcherRequest& req);
+
+    // returns true if it was the last request of the batch
+    bool requestFinished(void);
+
+    void deliverResponse(void);
+
+private:
+    PcFetcherBatch(uint64_t batchId, pcfetcher_batch_handler handler,
+            void* ctxt);
+
+    purc_variant_t m_batch_vid;
+    pcfetcher_batch_handler m_handler;
+    void* m_ctxt;
+
+    // in the order of the batch items
+    Vector<RefPtr<PcFetcherRequest>> m_requests;
+    std::atomic<size_t> m_nr_pending { 0 };
+};
+
+#endif // ENABLE(LINK_PURC_FETCHER)
+
+#endif /* not defined PURC_FETCHER_REQUEST_H */
@@ -32,34 +32,101 @@
 #include "ResourceResponse.h"
 
 #include <wtf/RunLoop.h>
-
-#define DEF_RWS_SIZE 1024
+#include <wtf/Scope.h>
 
 using namespace PurCFetcher;
 
 PcFetcherSession::PcFetcherSession(uint64_t sessionId,
         IPC::Connection::Identifier identifier)
     : m_sessionId(sessionId)
-    , m_req_id(0)
-    , m_is_async(false)
+    , m_is_closed(false)
     , m_connection(IPC::Connection::createClientConnection(identifier, *this))
-    , m_req_handler(NULL)
-    , m_req_ctxt(NULL)
-    , m_resp_rwstream(NULL)
 {
-    memset(&m_resp_header, 0, sizeof(m_resp_header));
     m_connection->open();
 }
 
 PcFetcherSession::~PcFetcherSession()
 {
+    close();
+    detachRequests();
 }
 
 void PcFetcherSession::close()
 {
+    if (m_is_closed.exchange(true))
+        return;
+
     m_connection->invalidate();
 }
 
+void PcFetcherSession::destroy(void)
+{
+    close();
+
+    // A closed connection dispatches nothing more to the session, but one
+    // of its handlers may still run on the connection queue, maybe the one
+    // calling this: delete the session after it, on that queue.
+    RefPtr<IPC::Connection> connection = m_connection;
+    connection->dispatchOnConnectionQueue([this] {
+        delete this;
+    });
+}
+
+bool PcFetcherSession::isValid() const
+{
+    return !m_is_closed && m_connection && m_connection->isValid();
+}
+
+size_t PcFetcherSession::pendingRequestCount()
+{
+    auto locker = holdLock(m_requestsLock);
+    return m_requests.size() + m_reservations;
+}
+
+void PcFetcherSession::reserve(void)
+{
+    auto locker = holdLock(m_requestsLock);
+    m_reservations++;
+}
+
+void PcFetcherSession::unreserve(void)
+{
+    auto locker = holdLock(m_requestsLock);
+    ASSERT(m_reservations);
+    m_reservations--;
+}
+
+void PcFetcherSession::addRequest(PcFetcherRequest& req)
+{
+    auto locker = holdLock(m_requestsLock);
+    m_requests.add(req.identifier(), &req);
+}
+
+RefPtr<PcFetcherRequest> PcFetcherSession::requestForIdentifier(uint64_t reqId)
+{
+    auto locker = holdLock(m_requestsLock);
+    return m_requests.get(reqId);
+}
+
+void PcFetcherSession::removeRequest(uint64_t reqId)
+{
+    auto locker = holdLock(m_requestsLock);
+    m_requests.remove(reqId);
+}
+
+void PcFetcherSession::detachRequests(void)
+{
+    HashMap<uint64_t, RefPtr<PcFetcherRequest>> requests;
+    {
+        auto locker = holdLock(m_requestsLock);
+        requests = WTFMove(m_requests);
+    }
+
+    for (auto& req : requests.values()) {
+        req->detachFromSession();
+    }
+}
+
 static const char* transMethod(enum pcfetcher_request_method method)
 {
     switch (method)
@@ -78,42 +145,51 @@ static const char* transMethod(enum pcfetcher_request_method method)
     }
 }
 
-purc_variant_t PcFetcherSession::requestAsync(
-        const char* url,
-        enum pcfetcher_request_method method,
-        purc_variant_t params,
-        uint32_t timeout,
-        response_handler handler,
-        void* ctxt)
+NetworkResourceLoadParameters PcFetcherSession::loadParameters(
+        PcFetcherRequest& req, const char* url,
+        enum pcfetcher_request_method method, uint32_t timeout)
 {
-    // TODO send params with http request
-    UNUSED_PARAM(params);
-
-    m_req_handler = handler;
-    m_req_ctxt = ctxt;
-    m_is_async = true;
-
     std::unique_ptr<WTF::URL> wurl = makeUnique<URL>(URL(), url);;
     ResourceRequest request;
     request.setURL(*wurl);
     request.setHTTPMethod(transMethod(method));
     request.setTimeoutInterval(timeout);
 
-    m_req_id = ProcessIdentifier::generate().toUInt64();
     NetworkResourceLoadParameters loadParameters;
-    loadParameters.identifier = m_req_id;
+    loadParameters.identifier = req.identifier();
     loadParameters.request = request;
     loadParameters.webPageProxyID = WebPageProxyIdentifier::generate();
     loadParameters.webPageID = PageIdentifier::generate();
     loadParameters.webFrameID = FrameIdentifier::generate();
     loadParameters.parentPID = getpid();
+    return loadParameters;
+}
 
+void PcFetcherSession::scheduleRequest(PcFetcherRequest& req,
+        const char* url, enum pcfetcher_request_method method,
+        uint32_t timeout)
+{
     m_connection->send(
             Messages::NetworkConnectionToWebProcess::ScheduleResourceLoad(
-                loadParameters), 0);
+                loadParameters(req, url, method, timeout)), 0);
+}
+
+purc_variant_t PcFetcherSession::requestAsync(
+        const char* url,
+        enum pcfetcher_request_method method,
+        purc_variant_t params,
+        uint32_t timeout,
+        response_handler handler,
+        void* ctxt)
+{
+    // TODO send params with http request
+    UNUSED_PARAM(params);
 
-    m_req_vid = purc_variant_make_ulongint(m_req_id);
-    return m_req_vid;
+    auto req = PcFetcherRequest::create(*this,
+            ProcessIdentifier::generate().toUInt64(), true, handler, ctxt);
+    addRequest(req.get());
+    scheduleRequest(req.get(), url, method, timeout);
+    return req->requestId();
 }
 
 purc_rwstream_t PcFetcherSession::requestSync(
@@ -126,52 +202,92 @@ purc_rwstream_t PcFetcherSession::requestSync(
     // TODO send params with http request
     UNUSED_PARAM(params);
 
-    m_is_async = false;
+    auto req = PcFetcherRequest::create(*this,
+            ProcessIdentifier::generate().toUInt64(), false, NULL, NULL);
+    addRequest(req.get());
+    scheduleRequest(req.get(), url, method, timeout);
 
-    std::unique_ptr<WTF::URL> wurl = makeUnique<URL>(URL(), url);;
-    ResourceRequest request;
-    request.setURL(*wurl);
-    request.setHTTPMethod(transMethod(method));
-    request.setTimeoutInterval(timeout);
-
-    m_req_id = ProcessIdentifier::generate().toUInt64();
-    NetworkResourceLoadParameters loadParameters;
-    loadParameters.identifier = m_req_id;
-    loadParameters.request = request;
-    loadParameters.webPageProxyID = WebPageProxyIdentifier::generate();
-    loadParameters.webPageID = PageIdentifier::generate();
-    loadParameters.webFrameID = FrameIdentifier::generate();
-    loadParameters.parentPID = getpid();
-
-    m_connection->send(
-            Messages::NetworkConnectionToWebProcess::ScheduleResourceLoad(
-                loadParameters), 0);
+    bool finished = req->wait(timeout);
 
-    wait(timeout);
+    // Once removed, late replies for this request are simply dropped.
+    removeRequest(req->identifier());
 
-    if (resp_header) {
-        resp_header->ret_code = m_resp_header.ret_code;
-        if (m_resp_header.mime_type) {
-            resp_header->mime_type = strdup(m_resp_header.mime_type);
+    if (!finished) {
+        // the stream may still be written by a late reply, leave it to the
+        // request in that case
+        if (resp_header) {
+            resp_header->ret_code = 408;
+            resp_header->mime_type = NULL;
+            resp_header->sz_resp = 0;
         }
-        resp_header->sz_resp = m_resp_header.sz_resp;
+        return NULL;
     }
 
-    return m_resp_rwstream;
+    const struct pcfetcher_resp_header& header = req->responseHeader();
+    if (resp_header) {
+        resp_header->ret_code = header.ret_code;
+        resp_header->mime_type = header.mime_type ?
+            strdup(header.mime_type) : NULL;
+        resp_header->sz_resp = header.sz_resp;
+    }
+    return req->takeResponseStream();
 }
 
-void PcFetcherSession::wait(uint32_t timeout)
+purc_variant_t PcFetcherSession::requestStream(
+        const char* url,
+        enum pcfetcher_request_method method,
+        purc_variant_t params,
+        uint32_t timeout,
+        const struct pcfetcher_stream_handlers *handlers,
+        void* ctxt)
 {
-    m_waitForSyncReplySemaphore.waitFor(Seconds(timeout));
+    // TODO send params with http request
+    UNUSED_PARAM(params);
+
+    auto req = PcFetcherRequest::createStream(*this,
+            ProcessIdentifier::generate().toUInt64(), handlers, ctxt);
+    addRequest(req.get());
+    scheduleRequest(req.get(), url, method, timeout);
+    return req->requestId();
 }
 
-void PcFetcherSession::wakeUp(void)
+purc_variant_t PcFetcherSession::requestBatch(
+        const struct pcfetcher_batch_item *items,
+        size_t nr_items,
+        uint32_t timeout,
+        pcfetcher_batch_handler handler,
+        void* ctxt)
 {
-    m_waitForSyncReplySemaphore.signal();
+    auto batch = PcFetcherBatch::create(
+            ProcessIdentifier::generate().toUInt64(), handler, ctxt);
+
+    Vector<NetworkResourceLoadParameters> batchParameters;
+    batchParameters.reserveInitialCapacity(nr_items);
+    for (size_t i = 0; i < nr_items; i++) {
+        // TODO send params with http request
+        auto req = PcFetcherRequest::create(*this,
+                ProcessIdentifier::generate().toUInt64(), true, NULL, NULL);
+        batch->addRequest(req.get());
+        addRequest(req.get());
+        batchParameters.uncheckedAppend(loadParameters(req.get(),
+                    items[i].url, items[i].method, timeout));
+    }
+
+    m_connection->send(
+            Messages::NetworkConnectionToWebProcess::ScheduleResourceLoadBatch(
+                batchParameters), 0);
+    return batch->batchId();
 }
 
 void PcFetcherSession::didClose(IPC::Connection&)
 {
+    m_dispatching++;
+    auto dispatched = makeScopeExit([this] {
+        m_dispatching--;
+    });
+
+    m_is_closed = true;
+    detachRequests();
 }
 
 void PcFetcherSession::didReceiveInvalidMessage(IPC::Connection&,
@@ -182,29 +298,40 @@ void PcFetcherSession::didReceiveInvalidMessage(IPC::Connection&,
 void PcFetcherSession::didReceiveMessage(IPC::Connection&,
         IPC::Decoder& decoder)
 {
+    m_dispatching++;
+    auto dispatched = makeScopeExit([this] {
+        m_dispatching--;
+    });
+
+    RefPtr<PcFetcherRequest> req = requestForIdentifier(
+            decoder.destinationID());
+    if (!req) {
+        return;
+    }
+
     if (decoder.messageName() == Messages::WebResourceLoader::DidReceiveResponse::name()) {
         IPC::handleMessage<Messages::WebResourceLoader::DidReceiveResponse>(
-                decoder, this, &PcFetcherSession::didReceiveResponse);
+                decoder, req.get(), &PcFetcherRequest::didReceiveResponse);
         return;
     }
     if (decoder.messageName() == Messages::WebResourceLoader::DidReceiveSharedBuffer::name()) {
         IPC::handleMessage<Messages::WebResourceLoader::DidReceiveSharedBuffer>(
-                decoder, this, &PcFetcherSession::didReceiveSharedBuffer);
+                decoder, req.get(), &PcFetcherRequest::didReceiveSharedBuffer);
         return;
     }
     if (decoder.messageName() == Messages::WebResourceLoader::DidFinishResourceLoad::name()) {
         IPC::handleMessage<Messages::WebResourceLoader::DidFinishResourceLoad>(
-                decoder, this, &PcFetcherSession::didFinishResourceLoad);
+                decoder, req.get(), &PcFetcherRequest::didFinishResourceLoad);
         return;
     }
     if (decoder.messageName() == Messages::WebResourceLoader::DidFailResourceLoad::name()) {
         IPC::handleMessage<Messages::WebResourceLoader::DidFailResourceLoad>(
-                decoder, this, &PcFetcherSession::didFailResourceLoad);
+                decoder, req.get(), &PcFetcherRequest::didFailResourceLoad);
         return;
     }
     if (decoder.messageName() == Messages::WebResourceLoader::WillSendRequest::name()) {
         IPC::handleMessage<Messages::WebResourceLoader::WillSendRequest>(
-                decoder, this, &PcFetcherSession::willSendRequest);
+                decoder, req.get(), &PcFetcherRequest::willSendRequest);
         return;
     }
 }
@@ -216,94 +343,3 @@ void PcFetcherSession::didReceiveSyncMessage(IPC::Connection& connection,
     UNUSED_PARAM(decoder);
     UNUSED_PARAM(replyEncoder);
 }
-
-void PcFetcherSession::didReceiveResponse(
-        const PurCFetcher::ResourceResponse& response,
-        bool needsContinueDidReceiveResponseMessage)
-{
-    UNUSED_PARAM(needsContinueDidReceiveResponseMessage);
-    m_resp_header.ret_code = response.httpStatusCode();
-    if (m_resp_header.mime_type) {
-        free(m_resp_header.mime_type);
-    }
-    const CString &utf8 = response.mimeType().utf8();
-    m_resp_header.mime_type = strdup((const char*)utf8.data());
-    m_resp_header.sz_resp = response.expectedContentLength();
-    if (m_resp_rwstream) {
-        purc_rwstream_destroy(m_resp_rwstream);
-    }
-    size_t init = m_resp_header.sz_resp ? m_resp_header.sz_resp : DEF_RWS_SIZE;
-    m_resp_rwstream = purc_rwstream_new_buffer(init, INT_MAX);
-}
-
-void PcFetcherSession::didReceiveSharedBuffer(
-        IPC::SharedBufferDataReference&& data, int64_t encodedDataLength)
-{
-    UNUSED_PARAM(encodedDataLength);
-    purc_rwstream_write(m_resp_rwstream, data.data(), data.size());
-}
-
-void PcFetcherSession::didFinishResourceLoad(
-        const NetworkLoadMetrics& networkLoadMetrics)
-{
-    UNUSED_PARAM(networkLoadMetrics);
-
-    if (m_is_async) {
-        if (m_req_handler) {
-            if (!m_resp_header.sz_resp && m_resp_rwstream) {
-                size_t sz_content = 0;
-                size_t sz_buffer = 0;
-                purc_rwstream_get_mem_buffer_ex(m_resp_rwstream, &sz_content,
-                        &sz_buffer, false);
-                m_resp_header.sz_resp = sz_content;
-            }
-            if (m_resp_rwstream) {
-                purc_rwstream_seek(m_resp_rwstream, 0, SEEK_SET);
-            }
-            m_req_handler(m_req_vid, m_req_ctxt,
-                    &m_resp_header, m_resp_rwstream);
-        }
-    }
-    else {
-        wakeUp();
-    }
-}
-
-void PcFetcherSession::didFailResourceLoad(const ResourceError& error)
-{
-    UNUSED_PARAM(error);
-    // TODO : trans error code
-    m_resp_header.ret_code = 408;
-
-    if (m_is_async) {
-        if (m_req_handler) {
-            if (!m_resp_header.sz_resp && m_resp_rwstream) {
-                size_t sz_content = 0;
-                size_t sz_buffer = 0;
-                purc_rwstream_get_mem_buffer_ex(m_resp_rwstream, &sz_content,
-                        &sz_buffer, false);
-                m_resp_header.sz_resp = sz_content;
-            }
-            if (m_resp_rwstream) {
-                purc_rwstream_seek(m_resp_rwstream, 0, SEEK_SET);
-            }
-            m_req_handler(m_req_vid, m_req_ctxt,
-                    &m_resp_header, m_resp_rwstream);
-        }
-    }
-    else {
-        wakeUp();
-    }
-}
-
-void PcFetcherSession::willSendRequest(ResourceRequest&& proposedRequest,
-        IPC::FormDataReference&& proposedRequestBody,
-        ResourceResponse&& redirectResponse)
-{
-    UNUSED_PARAM(proposedRequestBody);
-    UNUSED_PARAM(redirectResponse);
-    proposedRequest.setHTTPBody(proposedRequestBody.takeData());
-    m_connection->send(
-            Messages::NetworkResourceLoader::ContinueWillSendRequest(
-                proposedRequest, true), m_req_id);
-}
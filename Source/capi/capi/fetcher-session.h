@@ -29,6 +29,7 @@
 
 #include "fetcher-internal.h"
 #include "fetcher-messages-basic.h"
+#include "fetcher-request.h"
 
 #include "WebCoreArgumentCoders.h"
 #include "SharedBufferDataReference.h"
@@ -36,14 +37,22 @@
 #include "MessageReceiverMap.h"
 #include "ProcessLauncher.h"
 #include "FormDataReference.h"
+#include "NetworkResourceLoadParameters.h"
 
+#include <wtf/HashMap.h>
+#include <wtf/Lock.h>
 #include <wtf/ProcessID.h>
 #include <wtf/SystemTracing.h>
 #include <wtf/ThreadSafeRefCounted.h>
-#include <wtf/threads/BinarySemaphore.h>
 
 using namespace PurCFetcher;
 
+// Returns true if it takes over the delivery of the response.
+typedef WTF::Function<bool(PcFetcherRequest&)> PcFetcherDeferResponseHandler;
+
+// One IPC connection to the fetcher process. Any number of requests can be
+// in flight on a session at the same time; each one is tracked by its load
+// identifier in m_requests.
 class PcFetcherSession : public IPC::Connection::Client {
     WTF_MAKE_NONCOPYABLE(PcFetcherSession);
 
@@ -61,6 +70,19 @@ public:
 
     void close();
 
+    // Closes the session and deletes it once no message handler of it runs.
+    void destroy(void);
+
+    bool isValid() const;
+    // the requests in flight and the reservations
+    size_t pendingRequestCount();
+    // held from PcFetcherProcess::acquireSession() until the request is
+    // added, so that the session is not reaped in between
+    void reserve(void);
+    void unreserve(void);
+    // a message handler runs, maybe one of the requests which are done
+    bool isDispatching() const { return m_dispatching; }
+
     purc_variant_t requestAsync(
         const char* url,
         enum pcfetcher_request_method method,
@@ -76,8 +98,32 @@ public:
         uint32_t timeout,
         struct pcfetcher_resp_header *resp_header);
 
-    void wait(uint32_t timeout);
-    void wakeUp(void);
+    purc_variant_t requestStream(
+        const char* url,
+        enum pcfetcher_request_method method,
+        purc_variant_t params,
+        uint32_t timeout,
+        const struct pcfetcher_stream_handlers *handlers,
+        void* ctxt);
+
+    purc_variant_t requestBatch(
+        const struct pcfetcher_batch_item *items,
+        size_t nr_items,
+        uint32_t timeout,
+        pcfetcher_batch_handler handler,
+        void* ctxt);
+
+    RefPtr<PcFetcherRequest> requestForIdentifier(uint64_t reqId);
+    void removeRequest(uint64_t reqId);
+
+    void setDeferResponseHandler(PcFetcherDeferResponseHandler&& handler)
+    {
+        m_defer_response_handler = WTFMove(handler);
+    }
+    bool deferResponse(PcFetcherRequest& req)
+    {
+        return m_defer_response_handler && m_defer_response_handler(req);
+    }
 
 protected:
     bool dispatchMessage(IPC::Connection&, IPC::Decoder&);
@@ -92,29 +138,27 @@ protected:
     void didReceiveSyncMessage(IPC::Connection&, IPC::Decoder&,
             std::unique_ptr<IPC::Encoder>&);
 
-    void didReceiveResponse(const PurCFetcher::ResourceResponse&, bool);
-    void didReceiveSharedBuffer(IPC::SharedBufferDataReference&&,
-            int64_t encodedDataLength);
-    void didFinishResourceLoad(const PurCFetcher::NetworkLoadMetrics&);
-    void didFailResourceLoad(const ResourceError& error);
-    void willSendRequest(ResourceRequest&&,
-            IPC::FormDataReference&& requestBody, ResourceResponse&&);
-
 private:
+    void addRequest(PcFetcherRequest& req);
+    NetworkResourceLoadParameters loadParameters(PcFetcherRequest& req,
+            const char* url, enum pcfetcher_request_method method,
+            uint32_t timeout);
+    void scheduleRequest(PcFetcherRequest& req, const char* url,
+            enum pcfetcher_request_method method, uint32_t timeout);
+    void detachRequests(void);
+
     uint64_t m_sessionId;
-    uint64_t m_req_id;
-    bool m_is_async;
+    std::atomic<bool> m_is_closed;
+    std::atomic<unsigned> m_dispatching { 0 };
 
     RefPtr<IPC::Connection> m_connection;
     IPC::MessageReceiverMap m_messageReceiverMap;
-    BinarySemaphore m_waitForSyncReplySemaphore;
-    struct pcfetcher_resp_header m_resp_header;
 
-    response_handler m_req_handler;
-    void* m_req_ctxt;
+    Lock m_requestsLock;
+    HashMap<uint64_t, RefPtr<PcFetcherRequest>> m_requests;
+    size_t m_reservations { 0 };
 
-    purc_rwstream_t m_resp_rwstream;
-    purc_variant_t m_req_vid;
+    PcFetcherDeferResponseHandler m_defer_response_handler;
 };
 
 
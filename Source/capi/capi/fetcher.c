@@ -60,6 +60,16 @@ const char* pcfetcher_set_base_url(const char* base_url)
     return s_fetcher ? s_fetcher->set_base_url(s_fetcher, base_url) : NULL;
 }
 
+int pcfetcher_set_max_conns(size_t max_conns)
+{
+    return s_fetcher ? s_fetcher->set_max_conns(s_fetcher, max_conns) : -1;
+}
+
+int pcfetcher_set_cache_quota(size_t cache_quota)
+{
+    return s_fetcher ? s_fetcher->set_cache_quota(s_fetcher, cache_quota) : -1;
+}
+
 void pcfetcher_cookie_set(const char* domain,
         const char* path, const char* name, const char* content,
         time_t expire_time, bool secure)
@@ -108,7 +118,43 @@ purc_rwstream_t pcfetcher_request_sync(
     return s_fetcher ? s_fetcher->request_sync(s_fetcher, url, method,
             params, timeout, resp_header) : NULL;
 }
+purc_variant_t pcfetcher_request_stream(
+        const char* url,
+        enum pcfetcher_request_method method,
+        purc_variant_t params,
+        uint32_t timeout,
+        const struct pcfetcher_stream_handlers *handlers,
+        void* ctxt)
+{
+    return s_fetcher ? s_fetcher->request_stream(s_fetcher, url, method,
+            params, timeout, handlers, ctxt) : PURC_VARIANT_INVALID;
+}
 
+int pcfetcher_pause_stream(purc_variant_t request_id)
+{
+    return s_fetcher ? s_fetcher->pause_stream(s_fetcher, request_id) : -1;
+}
+
+int pcfetcher_resume_stream(purc_variant_t request_id)
+{
+    return s_fetcher ? s_fetcher->resume_stream(s_fetcher, request_id) : -1;
+}
+
+purc_variant_t pcfetcher_request_batch(
+        const struct pcfetcher_batch_item *items,
+        size_t nr_items,
+        uint32_t timeout,
+        pcfetcher_batch_handler handler,
+        void* ctxt)
+{
+    return s_fetcher ? s_fetcher->request_batch(s_fetcher, items, nr_items,
+            timeout, handler, ctxt) : PURC_VARIANT_INVALID;
+}
+
+int pcfetcher_get_fd(void)
+{
+    return s_fetcher ? s_fetcher->get_fd(s_fetcher) : -1;
+}
 
 int pcfetcher_check_response(uint32_t timeout_ms)
 {
@@ -116,5 +162,10 @@ int pcfetcher_check_response(uint32_t timeout_ms)
             timeout_ms) : 0;
 }
 
+char* pcfetcher_dump_ipc_stats(void)
+{
+    return s_fetcher ? s_fetcher->dump_ipc_stats(s_fetcher) : NULL;
+}
+
 
 
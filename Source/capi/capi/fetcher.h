@@ -51,17 +51,69 @@ typedef void (*response_handler)(
         const struct pcfetcher_resp_header *resp_header,
         purc_rwstream_t resp);
 
+typedef void (*pcfetcher_header_handler)(
+        purc_variant_t request_id, void* ctxt,
+        const struct pcfetcher_resp_header *resp_header);
+
+/* Returns false to pause the delivery, see pcfetcher_pause_stream(). */
+typedef bool (*pcfetcher_chunk_handler)(
+        purc_variant_t request_id, void* ctxt,
+        const char* data, size_t sz_data);
+
+typedef void (*pcfetcher_finish_handler)(
+        purc_variant_t request_id, void* ctxt,
+        const struct pcfetcher_resp_header *resp_header);
+
+struct pcfetcher_stream_handlers {
+    pcfetcher_header_handler on_header;
+    pcfetcher_chunk_handler on_chunk;
+    pcfetcher_finish_handler on_finish;
+};
+
+struct pcfetcher_batch_item {
+    const char* url;
+    enum pcfetcher_request_method method;
+    purc_variant_t params;
+};
+
+struct pcfetcher_batch_result {
+    struct pcfetcher_resp_header header;
+    purc_rwstream_t resp;
+};
+
+/*
+ * Called once all the requests of a batch are finished. results[i] is the
+ * response of items[i]; the handler takes over the resp streams.
+ */
+typedef void (*pcfetcher_batch_handler)(
+        purc_variant_t batch_id, void* ctxt,
+        size_t nr_results, const struct pcfetcher_batch_result *results);
+
 
 #ifdef __cplusplus
 extern "C" {
 #endif  /* __cplusplus */
 
+/*
+ * Spawns one fetcher process per online CPU and spreads the requests over
+ * them; the limits are shared out among them. The environment variable
+ * PURC_FETCHER_PROCESS_POOL_SIZE overrides the number of processes.
+ */
 int pcfetcher_init(size_t max_conns, size_t cache_quota);
 
 int pcfetcher_term(void);
 
 const char* pcfetcher_set_base_url(const char* base_url);
 
+/*
+ * Change the limits given to pcfetcher_init() at runtime. max_conns caps
+ * the connections of the network session and cache_quota the size of the
+ * disk cache in bytes; 0 restores the defaults.
+ */
+int pcfetcher_set_max_conns(size_t max_conns);
+
+int pcfetcher_set_cache_quota(size_t cache_quota);
+
 void pcfetcher_cookie_set(const char* domain,
         const char* path, const char* name, const char* content,
         time_t expire_time, bool secure);
@@ -88,8 +140,66 @@ purc_rwstream_t pcfetcher_request_sync(
         uint32_t timeout,
         struct pcfetcher_resp_header *resp_header);
 
+/*
+ * Like pcfetcher_request_async(), but the body is not collected: every
+ * chunk is passed to on_chunk as soon as it arrives. The handlers are
+ * called on the thread receiving the responses.
+ */
+purc_variant_t pcfetcher_request_stream(
+        const char* url,
+        enum pcfetcher_request_method method,
+        purc_variant_t params,
+        uint32_t timeout,
+        const struct pcfetcher_stream_handlers *handlers,
+        void* ctxt);
+
+/*
+ * Stops calling on_chunk for the stream request; chunks arriving in the
+ * meantime are kept until pcfetcher_resume_stream() is called.
+ */
+int pcfetcher_pause_stream(purc_variant_t request_id);
+
+int pcfetcher_resume_stream(purc_variant_t request_id);
+
+/*
+ * Sends all the requests in a single message to the fetcher and calls
+ * handler once, when the last of them is finished.
+ */
+purc_variant_t pcfetcher_request_batch(
+        const struct pcfetcher_batch_item *items,
+        size_t nr_items,
+        uint32_t timeout,
+        pcfetcher_batch_handler handler,
+        void* ctxt);
+
+/*
+ * Returns a file descriptor which becomes readable when responses of
+ * async requests are ready, or -1 if the fetcher does not support it.
+ *
+ * Once this function is called, the response handlers of async requests
+ * are no longer called on the thread receiving the responses; they are
+ * called by pcfetcher_check_response() on the calling thread instead.
+ */
+int pcfetcher_get_fd(void);
+
+/*
+ * Waits at most timeout_ms milliseconds for ready responses and calls
+ * their handlers. Returns the number of handled responses.
+ */
 int pcfetcher_check_response(uint32_t timeout_ms);
 
+/*
+ * Returns the IPC message statistics of this process and of every fetcher
+ * process: the count and bytes of each message, and percentiles of the
+ * time between sending and dispatching it. The caller frees the text.
+ * Returns NULL if the fetcher runs in this process.
+ *
+ * Setting PURC_FETCHER_IPC_STATS_INTERVAL to a number of seconds makes
+ * every process write the statistics periodically to stderr, or to the
+ * file named by PURC_FETCHER_IPC_STATS_FILE.
+ */
+char* pcfetcher_dump_ipc_stats(void);
+
 #ifdef __cplusplus
 }
 #endif  /* __cplusplus */
@@ -96,6 +96,7 @@ template<typename AsyncReplyResult> struct AsyncReplyError {
 };
 
 class MachMessage;
+class MessageRing;
 class UnixMessage;
 
 class Connection : public ThreadSafeRefCounted<Connection, WTF::DestructionThread::MainRunLoop> {
@@ -168,6 +169,10 @@ public:
     void invalidate();
     void markCurrentlyDispatchedMessageAsInvalid();
 
+    // Thread-safe. Runs the function on the work queue the messages are
+    // dispatched on, after the message being dispatched, if any.
+    void dispatchOnConnectionQueue(WTF::Function<void()>&&);
+
     void postConnectionDidCloseOnConnectionWorkQueue();
 
     template<typename T, typename C> void sendWithAsyncReply(T&& message, C&& completionHandler, uint64_t destinationID = 0, OptionSet<SendOption> = { }); // Thread-safe.
@@ -364,6 +369,12 @@ private:
     Vector<int> m_fileDescriptors;
     int m_socketDescriptor;
     std::unique_ptr<UnixMessage> m_pendingOutputMessage;
+
+    // the rings for the bodies of large messages, see MessageRing
+    bool sendBodyThroughRing(UnixMessage&);
+    RefPtr<MessageRing> m_sendRing;
+    RefPtr<MessageRing> m_receiveRing;
+    bool m_sendRingFailed { false };
 #if USE(GLIB)
     GRefPtr<GSocket> m_socket;
     GSocketMonitor m_readSocketMonitor;
@@ -30,6 +30,7 @@
 #include "MessageNames.h"
 #include "StringReference.h"
 //#include <PurCFetcher/ContextMenuItem.h>
+#include <wtf/MonotonicTime.h>
 #include <wtf/OptionSet.h>
 #include <wtf/Vector.h>
 
@@ -74,6 +75,10 @@ public:
 
     size_t length() const { return m_bufferEnd - m_buffer; }
 
+    // The send time of the encoder, when the transport carries it.
+    void setSendTime(MonotonicTime sendTime) { m_sendTime = sendTime; }
+    MonotonicTime sendTime() const { return m_sendTime; }
+
     WARN_UNUSED_RETURN bool isValid() const { return m_bufferPos != nullptr; }
     void markInvalid() { m_bufferPos = nullptr; }
 
@@ -187,6 +192,8 @@ private:
 
     uint64_t m_destinationID;
 
+    MonotonicTime m_sendTime;
+
 #if PLATFORM(MAC)
     std::unique_ptr<ImportanceAssertion> m_importanceAssertion;
 #endif
@@ -30,6 +30,7 @@
 #include "MessageNames.h"
 #include "StringReference.h"
 //#include <PurCFetcher/ContextMenuItem.h>
+#include <wtf/MonotonicTime.h>
 #include <wtf/OptionSet.h>
 #include <wtf/Vector.h>
 
@@ -56,6 +57,10 @@ public:
     void setShouldDispatchMessageWhenWaitingForSyncReply(ShouldDispatchWhenWaitingForSyncReply);
     ShouldDispatchWhenWaitingForSyncReply shouldDispatchMessageWhenWaitingForSyncReply() const;
 
+    // When the message was handed to the connection, for the queueing delay.
+    void setSendTime(MonotonicTime sendTime) { m_sendTime = sendTime; }
+    MonotonicTime sendTime() const { return m_sendTime; }
+
     void setFullySynchronousModeForTesting();
 
     void wrapForTesting(std::unique_ptr<Encoder>);
@@ -126,6 +131,8 @@ private:
     size_t m_bufferCapacity;
 
     Vector<Attachment> m_attachments;
+
+    MonotonicTime m_sendTime;
 };
 
 } // namespace IPC
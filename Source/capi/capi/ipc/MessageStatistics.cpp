@@ -0,0 +1,237 @@
+/* 
+ * Copyright (C) 2020 Beijing FMSoft Technologies Co., Ltd.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ * 
+ * Or,
+ * 
+ * As this component is a program released under LGPLv3, which claims
+ * explicitly that the program could be modified by any end user
+ * even if the program is conveyed in non-source form on the system it runs.
+ * Generally, if you distribute this program in embedded devices,
+ * you might not satisfy this condition. Under this situation or you can
+ * not accept any condition of LGPLv3, you need to get a commercial license
+ * from FMSoft, along with a patent license for the patents owned by FMSoft.
+ * 
+ * If you have got a commercial/patent license of this program, please use it
+ * under the terms and conditions of the commercial license.
+ * 
+ * For more information about the commercial license and patent license,
+ * please refer to
+ * <https://hybridos.fmsoft.cn/blog/hybridos-licensing-policy/>.
+ * 
+ * Also note that the LGPLv3 license does not apply to any entity in the
+ * Exception List published by Beijing FMSoft Technologies Co., Ltd.
+ * 
+ * If you are or the entity you represent is listed in the Exception List,
+ * the above open source or free software license does not apply to you
+ * or the entity you represent. Regardless of the purpose, you should not
+ * use the software in any way whatsoever, including but not limited to
+ * downloading, viewing, copying, distributing, compiling, and running.
+ * If you have already downloaded it, you MUST destroy all of its copies.
+ * 
+ * The Exception List is published by FMSoft and may be updated
+ * from time to time. For more information, please see
+ * <https://www.fmsoft.cn/exception-list>.
+ */ 
+
+#include "config.h"
+#include "MessageStatistics.h"
+
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <wtf/MonotonicTime.h>
+#include <wtf/NeverDestroyed.h>
+#include <wtf/StdLibExtras.h>
+#include <wtf/Threading.h>
+#include <wtf/text/StringBuilder.h>
+
+#define PURC_ENVV_FETCHER_IPC_STATS "PURC_FETCHER_IPC_STATS"
+#define PURC_ENVV_FETCHER_IPC_STATS_INTERVAL "PURC_FETCHER_IPC_STATS_INTERVAL"
+#define PURC_ENVV_FETCHER_IPC_STATS_FILE "PURC_FETCHER_IPC_STATS_FILE"
+
+namespace IPC {
+
+unsigned MessageStatistics::Histogram::bucketIndex(uint64_t value)
+{
+    if (value < subBucketCount)
+        return value;
+
+    unsigned exponent = 63 - clz(value);
+    unsigned subBucket = (value >> (exponent - subBucketBits)) & (subBucketCount - 1);
+    return (exponent - subBucketBits + 1) * subBucketCount + subBucket;
+}
+
+uint64_t MessageStatistics::Histogram::highestEquivalentValue(unsigned index)
+{
+    if (index < subBucketCount)
+        return index;
+
+    unsigned exponent = index / subBucketCount + subBucketBits - 1;
+    uint64_t subBucket = index % subBucketCount;
+    uint64_t width = uint64_t(1) << (exponent - subBucketBits);
+    return (subBucketCount + subBucket) * width + width - 1;
+}
+
+void MessageStatistics::Histogram::record(uint64_t value)
+{
+    m_buckets[bucketIndex(value)]++;
+    m_count++;
+    if (value > m_max)
+        m_max = value;
+}
+
+uint64_t MessageStatistics::Histogram::valueAtPercentile(double percentile) const
+{
+    if (!m_count)
+        return 0;
+
+    uint64_t wanted = std::max<uint64_t>(1, static_cast<uint64_t>(m_count * percentile / 100 + 0.5));
+    uint64_t seen = 0;
+    for (unsigned i = 0; i < bucketCount; ++i) {
+        seen += m_buckets[i];
+        if (seen >= wanted)
+            return std::min(highestEquivalentValue(i), m_max);
+    }
+    return m_max;
+}
+
+MessageStatistics& MessageStatistics::singleton()
+{
+    static NeverDestroyed<MessageStatistics> statistics;
+    return statistics;
+}
+
+MessageStatistics::MessageStatistics()
+{
+    const char* enabled = getenv(PURC_ENVV_FETCHER_IPC_STATS);
+    if (enabled && atoi(enabled) > 0)
+        m_enabled.store(true, std::memory_order_relaxed);
+
+    const char* interval = getenv(PURC_ENVV_FETCHER_IPC_STATS_INTERVAL);
+    if (!interval)
+        return;
+
+    double seconds = atof(interval);
+    if (seconds > 0) {
+        m_enabled.store(true, std::memory_order_relaxed);
+        startPeriodicSnapshots(Seconds(seconds), getenv(PURC_ENVV_FETCHER_IPC_STATS_FILE));
+    }
+}
+
+void MessageStatistics::startPeriodicSnapshots(Seconds interval, const char* path)
+{
+    CString filePath = path ? CString(path) : CString();
+    Thread::create("IPC statistics", [this, interval, filePath] {
+        while (true) {
+            sleep(interval);
+
+            CString text = snapshot().utf8();
+            FILE* file = filePath.isNull() ? stderr : fopen(filePath.data(), "a");
+            if (!file)
+                continue;
+
+            fprintf(file, "ipc-stats|%d|%.3f\n%s", getpid(), MonotonicTime::now().secondsSinceEpoch().seconds(), text.data());
+            if (file == stderr)
+                fflush(file);
+            else
+                fclose(file);
+        }
+    })->detach();
+}
+
+MessageStatistics::Entry& MessageStatistics::entry(MessageName messageName)
+{
+    size_t index = static_cast<size_t>(messageName);
+    if (index >= m_entries.size())
+        m_entries.grow(index + 1);
+
+    auto& entry = m_entries[index];
+    if (!entry)
+        entry = makeUnique<Entry>();
+    return *entry;
+}
+
+void MessageStatistics::didSend(MessageName messageName, size_t bytes, size_t sendQueueDepth)
+{
+    if (!isEnabled())
+        return;
+
+    auto locker = holdLock(m_lock);
+    auto& statistics = entry(messageName);
+    statistics.sent++;
+    statistics.sentBytes += bytes;
+    m_sendQueueDepth.record(sendQueueDepth);
+}
+
+void MessageStatistics::didReceive(MessageName messageName, size_t bytes)
+{
+    if (!isEnabled())
+        return;
+
+    auto locker = holdLock(m_lock);
+    auto& statistics = entry(messageName);
+    statistics.received++;
+    statistics.receivedBytes += bytes;
+}
+
+void MessageStatistics::didDispatch(MessageName messageName, Seconds queueingDelay)
+{
+    if (!isEnabled())
+        return;
+
+    // The clocks of both ends are the same monotonic clock, but a message
+    // from a process started before ours may still see a tiny negative value.
+    uint64_t microseconds = queueingDelay > 0_s ? static_cast<uint64_t>(queueingDelay.microseconds()) : 0;
+
+    auto locker = holdLock(m_lock);
+    entry(messageName).queueingDelay.record(microseconds);
+}
+
+String MessageStatistics::snapshot()
+{
+    m_enabled.store(true, std::memory_order_relaxed);
+
+    auto locker = holdLock(m_lock);
+
+    Vector<std::pair<MessageName, const Entry*>> busiest;
+    for (size_t i = 0; i < m_entries.size(); ++i) {
+        if (m_entries[i])
+            busiest.append({ static_cast<MessageName>(i), m_entries[i].get() });
+    }
+    std::sort(busiest.begin(), busiest.end(), [](auto& a, auto& b) {
+        return a.second->sent + a.second->received > b.second->sent + b.second->received;
+    });
+
+    StringBuilder builder;
+    for (auto& item : busiest) {
+        auto& statistics = *item.second;
+        auto& delay = statistics.queueingDelay;
+        builder.append(description(item.first),
+            "|sent=", statistics.sent, "|sent_bytes=", statistics.sentBytes,
+            "|recv=", statistics.received, "|recv_bytes=", statistics.receivedBytes,
+            "|delay_us_p50=", delay.valueAtPercentile(50),
+            "|p90=", delay.valueAtPercentile(90),
+            "|p99=", delay.valueAtPercentile(99),
+            "|max=", delay.max(), '\n');
+    }
+    builder.append("SendQueue|depth_p50=", m_sendQueueDepth.valueAtPercentile(50),
+        "|p99=", m_sendQueueDepth.valueAtPercentile(99),
+        "|max=", m_sendQueueDepth.max(), '\n');
+    return builder.toString();
+}
+
+} // namespace IPC
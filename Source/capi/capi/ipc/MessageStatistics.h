@@ -0,0 +1,135 @@
+/* 
+ * Copyright (C) 2020 Beijing FMSoft Technologies Co., Ltd.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ * 
+ * Or,
+ * 
+ * As this component is a program released under LGPLv3, which claims
+ * explicitly that the program could be modified by any end user
+ * even if the program is conveyed in non-source form on the system it runs.
+ * Generally, if you distribute this program in embedded devices,
+ * you might not satisfy this condition. Under this situation or you can
+ * not accept any condition of LGPLv3, you need to get a commercial license
+ * from FMSoft, along with a patent license for the patents owned by FMSoft.
+ * 
+ * If you have got a commercial/patent license of this program, please use it
+ * under the terms and conditions of the commercial license.
+ * 
+ * For more information about the commercial license and patent license,
+ * please refer to
+ * <https://hybridos.fmsoft.cn/blog/hybridos-licensing-policy/>.
+ * 
+ * Also note that the LGPLv3 license does not apply to any entity in the
+ * Exception List published by Beijing FMSoft Technologies Co., Ltd.
+ * 
+ * If you are or the entity you represent is listed in the Exception List,
+ * the above open source or free software license does not apply to you
+ * or the entity you represent. Regardless of the purpose, you should not
+ * use the software in any way whatsoever, including but not limited to
+ * downloading, viewing, copying, distributing, compiling, and running.
+ * If you have already downloaded it, you MUST destroy all of its copies.
+ * 
+ * The Exception List is published by FMSoft and may be updated
+ * from time to time. For more information, please see
+ * <https://www.fmsoft.cn/exception-list>.
+ */ 
+
+#pragma once
+
+#include "MessageNames.h"
+#include <atomic>
+#include <wtf/Lock.h>
+#include <wtf/Seconds.h>
+#include <wtf/Vector.h>
+#include <wtf/text/WTFString.h>
+
+namespace IPC {
+
+// Counts the messages and bytes sent and received for every MessageName of
+// the connections in this process, along with the time the messages spend
+// queued between Connection::sendMessage() and Connection::dispatchMessage().
+//
+// The statistics of a process can be fetched with the DumpMessageStatistics
+// message, or written every PURC_FETCHER_IPC_STATS_INTERVAL seconds to
+// stderr (or to PURC_FETCHER_IPC_STATS_FILE, when set).
+//
+// Nothing is recorded, and no lock is taken on the message path, until
+// PURC_FETCHER_IPC_STATS or PURC_FETCHER_IPC_STATS_INTERVAL is set, or a
+// first snapshot is taken; the first dump of a process then only starts
+// the counting.
+class MessageStatistics {
+    WTF_MAKE_NONCOPYABLE(MessageStatistics);
+    WTF_MAKE_FAST_ALLOCATED;
+public:
+    static MessageStatistics& singleton();
+
+    // A log-linear histogram in microseconds with 8 buckets per power of
+    // two, so any value is recorded with a relative error below 12.5%.
+    class Histogram {
+    public:
+        void record(uint64_t value);
+        uint64_t count() const { return m_count; }
+        uint64_t max() const { return m_max; }
+
+        // The highest value equivalent to the given percentile.
+        uint64_t valueAtPercentile(double percentile) const;
+
+    private:
+        static constexpr unsigned subBucketBits = 3;
+        static constexpr unsigned subBucketCount = 1 << subBucketBits;
+        static constexpr unsigned bucketCount = (64 - subBucketBits + 1) * subBucketCount;
+
+        static unsigned bucketIndex(uint64_t value);
+        static uint64_t highestEquivalentValue(unsigned index);
+
+        uint64_t m_buckets[bucketCount] { };
+        uint64_t m_count { 0 };
+        uint64_t m_max { 0 };
+    };
+
+    bool isEnabled() const { return m_enabled.load(std::memory_order_relaxed); }
+
+    void didSend(MessageName, size_t bytes, size_t sendQueueDepth);
+    void didReceive(MessageName, size_t bytes);
+    void didDispatch(MessageName, Seconds queueingDelay);
+
+    // One line for each message with traffic, busiest first, and a last
+    // line with the send-queue depth.
+    String snapshot();
+
+private:
+    friend class NeverDestroyed<MessageStatistics>;
+    MessageStatistics();
+
+    struct Entry {
+        WTF_MAKE_STRUCT_FAST_ALLOCATED;
+
+        uint64_t sent { 0 };
+        uint64_t sentBytes { 0 };
+        uint64_t received { 0 };
+        uint64_t receivedBytes { 0 };
+        Histogram queueingDelay;
+    };
+
+    Entry& entry(MessageName);
+    void startPeriodicSnapshots(Seconds interval, const char* path);
+
+    std::atomic<bool> m_enabled { false };
+    Lock m_lock;
+    Vector<std::unique_ptr<Entry>> m_entries;
+    Histogram m_sendQueueDepth;
+};
+
+} // namespace IPC
@@ -29,6 +29,7 @@
 #include "Connection.h"
 
 #include "DataReference.h"
+#include "MessageRing.h"
 #include "SharedMemory.h"
 #include "UnixMessage.h"
 #include <sys/socket.h>
@@ -123,6 +124,10 @@ void Connection::platformInvalidate()
 
     m_socketDescriptor = -1;
     m_isConnected = false;
+
+    // the decoders still holding a body keep the receiving ring alive
+    m_sendRing = nullptr;
+    m_receiveRing = nullptr;
 }
 
 bool Connection::processMessage()
@@ -135,12 +140,12 @@ bool Connection::processMessage()
     memcpy(&messageInfo, messageData, sizeof(messageInfo));
     messageData += sizeof(messageInfo);
 
-    if (messageInfo.attachmentCount() > attachmentMaxAmount || (!messageInfo.isBodyOutOfLine() && messageInfo.bodySize() > messageMaxSize)) {
+    if (messageInfo.attachmentCount() > attachmentMaxAmount || (messageInfo.isBodyInline() && messageInfo.bodySize() > messageMaxSize)) {
         ASSERT_NOT_REACHED();
         return false;
     }
 
-    size_t messageLength = sizeof(MessageInfo) + messageInfo.attachmentCount() * sizeof(AttachmentInfo) + (messageInfo.isBodyOutOfLine() ? 0 : messageInfo.bodySize());
+    size_t messageLength = sizeof(MessageInfo) + messageInfo.attachmentCount() * sizeof(AttachmentInfo) + (messageInfo.isBodyInline() ? messageInfo.bodySize() : 0);
     if (m_readBuffer.size() < messageLength)
         return false;
 
@@ -165,7 +170,7 @@ bool Connection::processMessage()
             }
         }
 
-        if (messageInfo.isBodyOutOfLine())
+        if (messageInfo.isBodyOutOfLine() || messageInfo.carriesRing())
             attachmentCount--;
     }
 
@@ -211,13 +216,41 @@ bool Connection::processMessage()
         }
     }
 
-    ASSERT(attachments.size() == (messageInfo.isBodyOutOfLine() ? messageInfo.attachmentCount() - 1 : messageInfo.attachmentCount()));
+    if (messageInfo.carriesRing()) {
+        if (attachmentInfo[attachmentCount].isNull()) {
+            ASSERT_NOT_REACHED();
+            return false;
+        }
+
+        PurCFetcher::SharedMemory::Handle handle;
+        handle.adoptAttachment(IPC::Attachment(m_fileDescriptors[attachmentFileDescriptorCount - 1], attachmentInfo[attachmentCount].size()));
+
+        m_receiveRing = MessageRing::map(handle);
+        if (!m_receiveRing) {
+            ASSERT_NOT_REACHED();
+            return false;
+        }
+    }
+
+    ASSERT(attachments.size() == (messageInfo.isBodyOutOfLine() || messageInfo.carriesRing() ? messageInfo.attachmentCount() - 1 : messageInfo.attachmentCount()));
 
     uint8_t* messageBody = messageData;
     if (messageInfo.isBodyOutOfLine())
         messageBody = reinterpret_cast<uint8_t*>(oolMessageBody->data());
 
-    auto decoder = makeUnique<Decoder>(messageBody, messageInfo.bodySize(), nullptr, WTFMove(attachments));
+    std::unique_ptr<Decoder> decoder;
+    if (messageInfo.isBodyInRing()) {
+        // Decoded in place, the decoder gives the space back to the ring.
+        const uint8_t* ringBody = m_receiveRing ? m_receiveRing->body(messageInfo.bodyOffset(), messageInfo.bodySize()) : nullptr;
+        if (!ringBody) {
+            ASSERT_NOT_REACHED();
+            return false;
+        }
+        decoder = makeUnique<Decoder>(ringBody, messageInfo.bodySize(), MessageRing::releaseBody, WTFMove(attachments));
+    } else
+        decoder = makeUnique<Decoder>(messageBody, messageInfo.bodySize(), nullptr, WTFMove(attachments));
+
+    decoder->setSendTime(MonotonicTime::fromRawSeconds(messageInfo.sendTime()));
 
     //fprintf(stderr, "purc|%d|0x%lX|%s|fd=%d|receive|%s\n", getpid(), pthread_self(), this->client().connectionName(), m_socketDescriptor, description(decoder->messageName()));
     processIncomingMessage(WTFMove(decoder));
@@ -393,6 +426,9 @@ bool Connection::sendOutgoingMessage(std::unique_ptr<Encoder> encoder)
     }
 
     size_t messageSizeWithBodyInline = sizeof(MessageInfo) + (outputMessage.attachments().size() * sizeof(AttachmentInfo)) + outputMessage.bodySize();
+    if (messageSizeWithBodyInline > messageMaxSize && outputMessage.bodySize() && sendBodyThroughRing(outputMessage))
+        return sendOutputMessage(outputMessage);
+
     if (messageSizeWithBodyInline > messageMaxSize && outputMessage.bodySize()) {
         RefPtr<PurCFetcher::SharedMemory> oolMessageBody = PurCFetcher::SharedMemory::allocate(encoder->bufferSize());
         if (!oolMessageBody)
@@ -412,6 +448,46 @@ bool Connection::sendOutgoingMessage(std::unique_ptr<Encoder> encoder)
     return sendOutputMessage(outputMessage);
 }
 
+bool Connection::sendBodyThroughRing(UnixMessage& outputMessage)
+{
+    // Called on the connection queue only, so there is one writer.
+    if (m_sendRingFailed || outputMessage.bodySize() > MessageRing::maxBodySize)
+        return false;
+
+    bool carriesRing = false;
+    if (!m_sendRing) {
+        m_sendRing = MessageRing::create();
+        if (!m_sendRing) {
+            m_sendRingFailed = true;
+            return false;
+        }
+        carriesRing = true;
+    }
+
+    // The first message in the ring hands the ring over.
+    PurCFetcher::SharedMemory::Handle handle;
+    if (carriesRing && !m_sendRing->createHandle(handle)) {
+        m_sendRing = nullptr;
+        m_sendRingFailed = true;
+        return false;
+    }
+
+    uint64_t offset;
+    if (!m_sendRing->write(outputMessage.body(), outputMessage.bodySize(), offset)) {
+        // The ring is full, or the body too large for it.
+        if (carriesRing)
+            m_sendRing = nullptr;
+        return false;
+    }
+
+    outputMessage.messageInfo().setBodyInRing(offset);
+    if (carriesRing) {
+        outputMessage.messageInfo().setCarriesRing();
+        outputMessage.appendAttachment(handle.releaseAttachment());
+    }
+    return true;
+}
+
 bool Connection::sendOutputMessage(UnixMessage& outputMessage)
 {
     ASSERT(!m_pendingOutputMessage);
@@ -483,7 +559,7 @@ bool Connection::sendOutputMessage(UnixMessage& outputMessage)
         ++iovLength;
     }
 
-    if (!messageInfo.isBodyOutOfLine() && outputMessage.bodySize()) {
+    if (messageInfo.isBodyInline() && outputMessage.bodySize()) {
         iov[iovLength].iov_base = reinterpret_cast<void*>(outputMessage.body());
         iov[iovLength].iov_len = outputMessage.bodySize();
         ++iovLength;
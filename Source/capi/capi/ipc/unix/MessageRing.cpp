@@ -0,0 +1,238 @@
+/* 
+ * Copyright (C) 2020 Beijing FMSoft Technologies Co., Ltd.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ * 
+ * Or,
+ * 
+ * As this component is a program released under LGPLv3, which claims
+ * explicitly that the program could be modified by any end user
+ * even if the program is conveyed in non-source form on the system it runs.
+ * Generally, if you distribute this program in embedded devices,
+ * you might not satisfy this condition. Under this situation or you can
+ * not accept any condition of LGPLv3, you need to get a commercial license
+ * from FMSoft, along with a patent license for the patents owned by FMSoft.
+ * 
+ * If you have got a commercial/patent license of this program, please use it
+ * under the terms and conditions of the commercial license.
+ * 
+ * For more information about the commercial license and patent license,
+ * please refer to
+ * <https://hybridos.fmsoft.cn/blog/hybridos-licensing-policy/>.
+ * 
+ * Also note that the LGPLv3 license does not apply to any entity in the
+ * Exception List published by Beijing FMSoft Technologies Co., Ltd.
+ * 
+ * If you are or the entity you represent is listed in the Exception List,
+ * the above open source or free software license does not apply to you
+ * or the entity you represent. Regardless of the purpose, you should not
+ * use the software in any way whatsoever, including but not limited to
+ * downloading, viewing, copying, distributing, compiling, and running.
+ * If you have already downloaded it, you MUST destroy all of its copies.
+ * 
+ * The Exception List is published by FMSoft and may be updated
+ * from time to time. For more information, please see
+ * <https://www.fmsoft.cn/exception-list>.
+ */ 
+
+#include "config.h"
+#include "MessageRing.h"
+
+#if USE(UNIX_DOMAIN_SOCKETS)
+
+#include <atomic>
+#include <wtf/NeverDestroyed.h>
+#include <wtf/StdLibExtras.h>
+#include <wtf/Vector.h>
+
+namespace IPC {
+
+static constexpr size_t slotAlignment = 64;
+
+// The positions only grow; the offset in the data is position % capacity.
+struct MessageRing::Control {
+    std::atomic<uint64_t> head; // written by the sender
+    uint8_t padding1[slotAlignment - sizeof(uint64_t)];
+    std::atomic<uint64_t> tail; // written by the receiver
+    uint8_t padding2[slotAlignment - sizeof(uint64_t)];
+};
+
+struct MessageRing::Slot {
+    uint32_t size; // of the whole slot, a multiple of slotAlignment
+    std::atomic<uint32_t> released;
+    uint64_t reserved;
+};
+
+static_assert(sizeof(std::atomic<uint64_t>) == sizeof(uint64_t), "The ring control is shared between processes.");
+static_assert(!(sizeof(MessageRing::Slot) % alignof(uint64_t)), "Bodies in the ring must be aligned for the decoder.");
+
+// The receiver rings, to find the ring of a body given back by a decoder.
+static Lock receiverRingsLock;
+static Vector<MessageRing*>& receiverRings()
+{
+    static NeverDestroyed<Vector<MessageRing*>> rings;
+    return rings;
+}
+
+RefPtr<MessageRing> MessageRing::create(size_t size)
+{
+    auto memory = PurCFetcher::SharedMemory::allocate(size);
+    if (!memory)
+        return nullptr;
+
+    auto ring = adoptRef(*new MessageRing(memory.releaseNonNull()));
+    ring->control()->head.store(0, std::memory_order_relaxed);
+    ring->control()->tail.store(0, std::memory_order_relaxed);
+    return ring;
+}
+
+RefPtr<MessageRing> MessageRing::map(const PurCFetcher::SharedMemory::Handle& handle)
+{
+    auto memory = PurCFetcher::SharedMemory::map(handle, PurCFetcher::SharedMemory::Protection::ReadWrite);
+    if (!memory || memory->size() <= sizeof(Control) + slotAlignment)
+        return nullptr;
+
+    auto ring = adoptRef(*new MessageRing(memory.releaseNonNull()));
+    auto locker = holdLock(receiverRingsLock);
+    receiverRings().append(ring.ptr());
+    return ring;
+}
+
+MessageRing::MessageRing(Ref<PurCFetcher::SharedMemory>&& memory)
+    : m_memory(WTFMove(memory))
+    , m_capacity((m_memory->size() - sizeof(Control)) / slotAlignment * slotAlignment)
+{
+}
+
+MessageRing::~MessageRing()
+{
+    auto locker = holdLock(receiverRingsLock);
+    receiverRings().removeFirst(this);
+}
+
+bool MessageRing::createHandle(PurCFetcher::SharedMemory::Handle& handle)
+{
+    return m_memory->createHandle(handle, PurCFetcher::SharedMemory::Protection::ReadWrite);
+}
+
+MessageRing::Control* MessageRing::control() const
+{
+    return static_cast<Control*>(m_memory->data());
+}
+
+uint8_t* MessageRing::data() const
+{
+    return static_cast<uint8_t*>(m_memory->data()) + sizeof(Control);
+}
+
+MessageRing::Slot* MessageRing::slotAt(uint64_t position) const
+{
+    return reinterpret_cast<Slot*>(data() + position % m_capacity);
+}
+
+bool MessageRing::contains(const uint8_t* body) const
+{
+    return body >= data() && body < data() + m_capacity;
+}
+
+bool MessageRing::write(const uint8_t* body, size_t bodySize, uint64_t& offset)
+{
+    size_t slotSize = roundUpToMultipleOf(slotAlignment, sizeof(Slot) + bodySize);
+    if (slotSize > m_capacity / 2)
+        return false;
+
+    uint64_t head = control()->head.load(std::memory_order_relaxed);
+    uint64_t tail = control()->tail.load(std::memory_order_acquire);
+
+    // A slot never wraps around; the end of the data is skipped instead.
+    size_t contiguous = m_capacity - head % m_capacity;
+    size_t skipped = slotSize > contiguous ? contiguous : 0;
+    if (head + skipped + slotSize - tail > m_capacity)
+        return false;
+
+    if (skipped) {
+        Slot* slot = slotAt(head);
+        slot->size = skipped;
+        slot->released.store(1, std::memory_order_relaxed);
+        head += skipped;
+    }
+
+    Slot* slot = slotAt(head);
+    slot->size = slotSize;
+    slot->released.store(0, std::memory_order_relaxed);
+    memcpy(reinterpret_cast<uint8_t*>(slot) + sizeof(Slot), body, bodySize);
+
+    offset = head % m_capacity;
+    control()->head.store(head + slotSize, std::memory_order_release);
+    return true;
+}
+
+const uint8_t* MessageRing::body(uint64_t offset, size_t bodySize)
+{
+    // The offset comes from the other process, check it.
+    if (offset % slotAlignment || offset >= m_capacity
+        || bodySize > m_capacity - offset - sizeof(Slot))
+        return nullptr;
+
+    // Kept alive by the decoder, see releaseBody().
+    ref();
+    return data() + offset + sizeof(Slot);
+}
+
+void MessageRing::releaseBody(const uint8_t* body, size_t)
+{
+    MessageRing* ring = nullptr;
+    {
+        auto locker = holdLock(receiverRingsLock);
+        for (auto* receiverRing : receiverRings()) {
+            if (receiverRing->contains(body)) {
+                ring = receiverRing;
+                break;
+            }
+        }
+    }
+
+    ASSERT(ring);
+    if (!ring)
+        return;
+
+    ring->release(body);
+    ring->deref();
+}
+
+void MessageRing::release(const uint8_t* body)
+{
+    auto locker = holdLock(m_releaseLock);
+
+    auto* slot = reinterpret_cast<Slot*>(const_cast<uint8_t*>(body) - sizeof(Slot));
+    slot->released.store(1, std::memory_order_release);
+
+    uint64_t tail = control()->tail.load(std::memory_order_relaxed);
+    uint64_t head = control()->head.load(std::memory_order_acquire);
+    while (tail < head) {
+        Slot* tailSlot = slotAt(tail);
+        if (!tailSlot->released.load(std::memory_order_acquire))
+            break;
+
+        size_t slotSize = tailSlot->size;
+        if (!slotSize || slotSize % slotAlignment || slotSize > m_capacity - tail % m_capacity)
+            break;
+        tail += slotSize;
+    }
+    control()->tail.store(tail, std::memory_order_release);
+}
+
+} // namespace IPC
+
+#endif // USE(UNIX_DOMAIN_SOCKETS)
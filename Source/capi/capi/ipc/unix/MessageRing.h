@@ -0,0 +1,109 @@
+/* 
+ * Copyright (C) 2020 Beijing FMSoft Technologies Co., Ltd.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ * 
+ * Or,
+ * 
+ * As this component is a program released under LGPLv3, which claims
+ * explicitly that the program could be modified by any end user
+ * even if the program is conveyed in non-source form on the system it runs.
+ * Generally, if you distribute this program in embedded devices,
+ * you might not satisfy this condition. Under this situation or you can
+ * not accept any condition of LGPLv3, you need to get a commercial license
+ * from FMSoft, along with a patent license for the patents owned by FMSoft.
+ * 
+ * If you have got a commercial/patent license of this program, please use it
+ * under the terms and conditions of the commercial license.
+ * 
+ * For more information about the commercial license and patent license,
+ * please refer to
+ * <https://hybridos.fmsoft.cn/blog/hybridos-licensing-policy/>.
+ * 
+ * Also note that the LGPLv3 license does not apply to any entity in the
+ * Exception List published by Beijing FMSoft Technologies Co., Ltd.
+ * 
+ * If you are or the entity you represent is listed in the Exception List,
+ * the above open source or free software license does not apply to you
+ * or the entity you represent. Regardless of the purpose, you should not
+ * use the software in any way whatsoever, including but not limited to
+ * downloading, viewing, copying, distributing, compiling, and running.
+ * If you have already downloaded it, you MUST destroy all of its copies.
+ * 
+ * The Exception List is published by FMSoft and may be updated
+ * from time to time. For more information, please see
+ * <https://www.fmsoft.cn/exception-list>.
+ */ 
+
+#pragma once
+
+#if USE(UNIX_DOMAIN_SOCKETS)
+
+#include "SharedMemory.h"
+#include <wtf/Lock.h>
+#include <wtf/ThreadSafeRefCounted.h>
+
+namespace IPC {
+
+// A ring of shared memory for the bodies of large messages, one for each
+// direction of a connection. The sender copies the body into the ring and
+// only sends its offset over the socket; the receiver decodes the body in
+// place and gives the space back once the decoder is done with it. The
+// slots may be given back in any order, the tail only passes the ones
+// given back.
+class MessageRing : public ThreadSafeRefCounted<MessageRing> {
+public:
+    static constexpr size_t defaultSize = 4 * 1024 * 1024;
+
+    // larger bodies keep going through a shared memory of their own
+    static constexpr size_t maxBodySize = defaultSize / 4;
+
+    static RefPtr<MessageRing> create(size_t size = defaultSize);
+    static RefPtr<MessageRing> map(const PurCFetcher::SharedMemory::Handle&);
+    ~MessageRing();
+
+    bool createHandle(PurCFetcher::SharedMemory::Handle&);
+
+    // Sender side. Returns false if the body does not fit in the free
+    // space; the caller falls back to a shared memory of its own then.
+    bool write(const uint8_t* body, size_t bodySize, uint64_t& offset);
+
+    // Receiver side. The body stays in place until releaseBody() is called
+    // with it, the ring is kept alive until then.
+    const uint8_t* body(uint64_t offset, size_t bodySize);
+    static void releaseBody(const uint8_t* body, size_t bodySize);
+
+    // the layout shared with the other process
+    struct Control;
+    struct Slot;
+
+private:
+    MessageRing(Ref<PurCFetcher::SharedMemory>&&);
+
+    Control* control() const;
+    uint8_t* data() const;
+    Slot* slotAt(uint64_t position) const;
+    bool contains(const uint8_t*) const;
+    void release(const uint8_t* body);
+
+    Ref<PurCFetcher::SharedMemory> m_memory;
+    size_t m_capacity;
+
+    // serializes moving the tail forward
+    Lock m_releaseLock;
+};
+
+} // namespace IPC
+
+#endif // USE(UNIX_DOMAIN_SOCKETS)
@@ -528,6 +528,8 @@ const char* description(MessageName name)
         return "WebIDBServer::GetAllDatabaseNamesAndVersions";
     case MessageName::NetworkConnectionToWebProcess_ScheduleResourceLoad:
         return "NetworkConnectionToWebProcess::ScheduleResourceLoad";
+    case MessageName::NetworkConnectionToWebProcess_ScheduleResourceLoadBatch:
+        return "NetworkConnectionToWebProcess::ScheduleResourceLoadBatch";
     case MessageName::NetworkConnectionToWebProcess_PerformSynchronousLoad:
         return "NetworkConnectionToWebProcess::PerformSynchronousLoad";
     case MessageName::NetworkConnectionToWebProcess_TestProcessIncomingSyncMessagesWhenWaitingForSyncReply:
@@ -754,6 +756,12 @@ const char* description(MessageName name)
         return "NetworkProcess::SetCacheModel";
     case MessageName::NetworkProcess_SetCacheModelSynchronouslyForTesting:
         return "NetworkProcess::SetCacheModelSynchronouslyForTesting";
+    case MessageName::NetworkProcess_SetCacheQuota:
+        return "NetworkProcess::SetCacheQuota";
+    case MessageName::NetworkProcess_SetMaxConnections:
+        return "NetworkProcess::SetMaxConnections";
+    case MessageName::NetworkProcess_DumpMessageStatistics:
+        return "NetworkProcess::DumpMessageStatistics";
     case MessageName::NetworkProcess_ProcessDidTransitionToBackground:
         return "NetworkProcess::ProcessDidTransitionToBackground";
     case MessageName::NetworkProcess_ProcessDidTransitionToForeground:
@@ -5467,6 +5475,7 @@ ReceiverName receiverName(MessageName messageName)
     case MessageName::WebIDBServer_GetAllDatabaseNamesAndVersions:
         return ReceiverName::WebIDBServer;
     case MessageName::NetworkConnectionToWebProcess_ScheduleResourceLoad:
+    case MessageName::NetworkConnectionToWebProcess_ScheduleResourceLoadBatch:
     case MessageName::NetworkConnectionToWebProcess_PerformSynchronousLoad:
     case MessageName::NetworkConnectionToWebProcess_TestProcessIncomingSyncMessagesWhenWaitingForSyncReply:
     case MessageName::NetworkConnectionToWebProcess_LoadPing:
@@ -5592,6 +5601,9 @@ ReceiverName receiverName(MessageName messageName)
     case MessageName::NetworkProcess_AllowSpecificHTTPSCertificateForHost:
     case MessageName::NetworkProcess_SetCacheModel:
     case MessageName::NetworkProcess_SetCacheModelSynchronouslyForTesting:
+    case MessageName::NetworkProcess_SetCacheQuota:
+    case MessageName::NetworkProcess_SetMaxConnections:
+    case MessageName::NetworkProcess_DumpMessageStatistics:
     case MessageName::NetworkProcess_ProcessDidTransitionToBackground:
     case MessageName::NetworkProcess_ProcessDidTransitionToForeground:
     case MessageName::NetworkProcess_ProcessWillSuspendImminentlyForTestingSync:
@@ -9201,6 +9213,8 @@ bool isValidMessageName(MessageName messageName)
         return true;
     if (messageName == IPC::MessageName::NetworkConnectionToWebProcess_ScheduleResourceLoad)
         return true;
+    if (messageName == IPC::MessageName::NetworkConnectionToWebProcess_ScheduleResourceLoadBatch)
+        return true;
     if (messageName == IPC::MessageName::NetworkConnectionToWebProcess_PerformSynchronousLoad)
         return true;
     if (messageName == IPC::MessageName::NetworkConnectionToWebProcess_TestProcessIncomingSyncMessagesWhenWaitingForSyncReply)
@@ -9427,6 +9441,12 @@ bool isValidMessageName(MessageName messageName)
         return true;
     if (messageName == IPC::MessageName::NetworkProcess_SetCacheModelSynchronouslyForTesting)
         return true;
+    if (messageName == IPC::MessageName::NetworkProcess_SetCacheQuota)
+        return true;
+    if (messageName == IPC::MessageName::NetworkProcess_SetMaxConnections)
+        return true;
+    if (messageName == IPC::MessageName::NetworkProcess_DumpMessageStatistics)
+        return true;
     if (messageName == IPC::MessageName::NetworkProcess_ProcessDidTransitionToBackground)
         return true;
     if (messageName == IPC::MessageName::NetworkProcess_ProcessDidTransitionToForeground)
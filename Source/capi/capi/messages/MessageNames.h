@@ -413,6 +413,7 @@ enum class MessageName : uint16_t {
     , WebIDBServer_OpenDBRequestCancelled = 222
     , WebIDBServer_GetAllDatabaseNamesAndVersions = 223
     , NetworkConnectionToWebProcess_ScheduleResourceLoad = 224
+    , NetworkConnectionToWebProcess_ScheduleResourceLoadBatch = 1989
     , NetworkConnectionToWebProcess_PerformSynchronousLoad = 225
     , NetworkConnectionToWebProcess_TestProcessIncomingSyncMessagesWhenWaitingForSyncReply = 226
     , NetworkConnectionToWebProcess_LoadPing = 227
@@ -544,6 +545,9 @@ enum class MessageName : uint16_t {
     , NetworkProcess_AllowSpecificHTTPSCertificateForHost = 317
     , NetworkProcess_SetCacheModel = 318
     , NetworkProcess_SetCacheModelSynchronouslyForTesting = 319
+    , NetworkProcess_SetCacheQuota = 1987
+    , NetworkProcess_SetMaxConnections = 1988
+    , NetworkProcess_DumpMessageStatistics = 1990
     , NetworkProcess_ProcessDidTransitionToBackground = 320
     , NetworkProcess_ProcessDidTransitionToForeground = 321
     , NetworkProcess_ProcessWillSuspendImminentlyForTestingSync = 322
@@ -87,12 +87,35 @@ private:
     Arguments m_arguments;
 };
 
+class ScheduleResourceLoadBatch {
+public:
+    using Arguments = std::tuple<const Vector<PurCFetcher::NetworkResourceLoadParameters>&>;
+
+    static IPC::MessageName name() { return IPC::MessageName::NetworkConnectionToWebProcess_ScheduleResourceLoadBatch; }
+    static const bool isSync = false;
+
+    explicit ScheduleResourceLoadBatch(const Vector<PurCFetcher::NetworkResourceLoadParameters>& resourceLoadParameters)
+        : m_arguments(resourceLoadParameters)
+    {
+    }
+
+    const Arguments& arguments() const
+    {
+        return m_arguments;
+    }
+
+private:
+    Arguments m_arguments;
+};
+
 } // namespace NetworkConnectionToWebProcess
 
 namespace NetworkProcess {
 
 using CreateNetworkConnectionToWebProcessDelayedReply = CompletionHandler<void(const Optional<IPC::Attachment>& connectionIdentifier, PurCFetcher::HTTPCookieAcceptPolicy cookieAcceptPolicy)>;
 
+using DumpMessageStatisticsDelayedReply = CompletionHandler<void(const String& statistics)>;
+
 static inline IPC::ReceiverName messageReceiverName()
 {
     return IPC::ReceiverName::NetworkProcess;
@@ -144,6 +167,68 @@ private:
     Arguments m_arguments;
 };
 
+class SetCacheQuota {
+public:
+    using Arguments = std::tuple<uint64_t>;
+
+    static IPC::MessageName name() { return IPC::MessageName::NetworkProcess_SetCacheQuota; }
+    static const bool isSync = false;
+
+    explicit SetCacheQuota(uint64_t cacheQuota)
+        : m_arguments(cacheQuota)
+    {
+    }
+
+    const Arguments& arguments() const
+    {
+        return m_arguments;
+    }
+
+private:
+    Arguments m_arguments;
+};
+
+class SetMaxConnections {
+public:
+    using Arguments = std::tuple<uint64_t>;
+
+    static IPC::MessageName name() { return IPC::MessageName::NetworkProcess_SetMaxConnections; }
+    static const bool isSync = false;
+
+    explicit SetMaxConnections(uint64_t maxConnections)
+        : m_arguments(maxConnections)
+    {
+    }
+
+    const Arguments& arguments() const
+    {
+        return m_arguments;
+    }
+
+private:
+    Arguments m_arguments;
+};
+
+class DumpMessageStatistics {
+public:
+    using Arguments = std::tuple<>;
+
+    static IPC::MessageName name() { return IPC::MessageName::NetworkProcess_DumpMessageStatistics; }
+    static const bool isSync = true;
+
+    using DelayedReply = DumpMessageStatisticsDelayedReply;
+    static void send(std::unique_ptr<IPC::Encoder>&&, IPC::Connection&, const String& statistics);
+    using Reply = std::tuple<String&>;
+    using ReplyArguments = std::tuple<String>;
+    const Arguments& arguments() const
+    {
+        return m_arguments;
+    }
+
+private:
+    Arguments m_arguments;
+};
+
 } // namespace NetworkProcess
 
 namespace NetworkResourceLoader {
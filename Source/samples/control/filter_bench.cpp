@@ -0,0 +1,150 @@
+#include "config.h"
+#include "CmdFilterManager.h"
+
+#include <wtf/MonotonicTime.h>
+
+#include <atomic>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Measures the cmdfilter pipeline of lcmd on a generated output, like the
+// one of `ls -l`: the time and the number of memory allocations per line,
+// from the lines to the JSON of the records.
+//
+// usage: filter_bench [lines] [cmdfilter]
+//
+// The default filters split the lines into columns and keep the size and
+// the name of the files:
+//     delimiter(' ');cignore(5,3);ctail(3);cpick(1,1);keys('size,name')
+//
+// It also compares compiling the cmdfilter with taking the plan from the
+// cache, as a request does.
+//
+// Run it with Malloc=1 in the environment, so that bmalloc leaves the
+// allocations to the system allocator, where they are counted.
+
+#if defined(__GLIBC__)
+static std::atomic<size_t> allocation_count;
+
+extern "C" {
+void* __libc_malloc(size_t);
+void* __libc_calloc(size_t, size_t);
+void* __libc_realloc(void*, size_t);
+
+void* malloc(size_t size)
+{
+    allocation_count++;
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size)
+{
+    allocation_count++;
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size)
+{
+    allocation_count++;
+    return __libc_realloc(ptr, size);
+}
+}
+
+static size_t allocations(void)
+{
+    return allocation_count;
+}
+#else
+static size_t allocations(void)
+{
+    return 0;
+}
+#endif
+
+static const char* default_filter =
+    "delimiter(' ');cignore(5,3);ctail(3);cpick(1,1);keys('size,name')";
+
+static Vector<char> make_output(int count)
+{
+    Vector<char> output;
+    char line[256];
+    for (int i = 0; i < count; i++) {
+        int len = snprintf(line, sizeof(line),
+                "-rw-r--r-- 1 user group %d Oct 16 12:%02d file-%d.txt\n",
+                i * 37 % 100000, i % 60, i);
+        output.append(line, len);
+    }
+    return output;
+}
+
+static Vector<StringView> index_lines(const Vector<char>& output)
+{
+    Vector<StringView> lines;
+    const char* start = output.data();
+    const char* end = output.data() + output.size();
+    while (start < end) {
+        const char* lf = (const char*)memchr(start, '\n', end - start);
+        if (!lf) {
+            lf = end;
+        }
+        if (lf > start) {
+            lines.append(StringView((const LChar*)start, lf - start));
+        }
+        start = lf + 1;
+    }
+    return lines;
+}
+
+int main(int argc, char** argv)
+{
+    int count = argc > 1 ? atoi(argv[1]) : 100000;
+    if (count <= 0) {
+        count = 100000;
+    }
+
+    String cmdfilter = String::fromUTF8(argc > 2 ? argv[2] : default_filter);
+
+    const int compile_count = 10000;
+    MonotonicTime start = MonotonicTime::now();
+    for (int i = 0; i < compile_count; i++) {
+        CmdFilterManager::compile(cmdfilter);
+    }
+    double compile_time = (MonotonicTime::now() - start).microseconds();
+
+    start = MonotonicTime::now();
+    for (int i = 0; i < compile_count; i++) {
+        CmdFilterManager::planFor(cmdfilter);
+    }
+    double cached_time = (MonotonicTime::now() - start).microseconds();
+
+    auto manager = CmdFilterManager::planFor(cmdfilter);
+
+    Vector<char> output = make_output(count);
+    Vector<StringView> lines = index_lines(output);
+
+    // warm up the allocators and the filters
+    manager->doFilter(lines);
+
+    size_t allocated = allocations();
+    start = MonotonicTime::now();
+    CmdFilterPipeline pipeline(manager.get());
+    pipeline.pushLines(lines);
+    pipeline.finish();
+    Ref<SharedBuffer> json = pipeline.takeRecords();
+    double elapsed = (MonotonicTime::now() - start).milliseconds();
+    allocated = allocations() - allocated;
+
+    fprintf(stderr, "plan(us)|compiled=%.2f|cached=%.2f\n",
+            compile_time / compile_count, cached_time / compile_count);
+#if !defined(__GLIBC__)
+    fprintf(stderr, "the allocations are only counted with glibc\n");
+#endif
+    fprintf(stderr, "lines=%zu|records=%zu|json(bytes)=%zu|time(ms)=%.1f|ns/line=%.0f\n",
+            lines.size(), pipeline.recordCount(), json->size(), elapsed,
+            elapsed * 1000000 / lines.size());
+    fprintf(stderr, "allocations=%zu|per line=%.2f\n",
+            allocated, (double)allocated / lines.size());
+
+    return 0;
+}
@@ -0,0 +1,100 @@
+#include "purc_fetcher_local.h"
+
+#include <wtf/MonotonicTime.h>
+#include <wtf/threads/BinarySemaphore.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+// Measures the per-request latency of sequential loads on the in-process
+// fetcher, without any IPC. Run req_latency with the same arguments to
+// compare it with the fetcher process.
+//
+// usage: local_latency [url] [count]
+
+struct load_state {
+    BinarySemaphore semaphore;
+    size_t size;
+    int status_code;
+};
+
+static void did_receive_response(void* ctxt, int status_code,
+        const char* mime_type, int64_t expected_length)
+{
+    UNUSED_PARAM(mime_type);
+    UNUSED_PARAM(expected_length);
+    struct load_state* state = (struct load_state*)ctxt;
+    state->status_code = status_code;
+}
+
+static void did_receive_data(void* ctxt, const char* data, size_t size)
+{
+    UNUSED_PARAM(data);
+    struct load_state* state = (struct load_state*)ctxt;
+    state->size += size;
+}
+
+static void did_finish(void* ctxt, int status_code)
+{
+    struct load_state* state = (struct load_state*)ctxt;
+    state->status_code = status_code;
+    state->semaphore.signal();
+}
+
+static const struct purc_fetcher_local_client client = {
+    did_receive_response,
+    did_receive_data,
+    did_finish,
+};
+
+int main(int argc, char** argv)
+{
+    const char* def_url = "lcmd:///bin/true";
+    const char* url = argc > 1 ? argv[1] : def_url;
+    int count = argc > 2 ? atoi(argv[2]) : 100;
+    if (count <= 0) {
+        count = 100;
+    }
+
+    if (!purc_fetcher_local_start(0, 0)) {
+        fprintf(stderr, "failed to start the local fetcher\n");
+        return 1;
+    }
+
+    double total = 0;
+    double min = 0;
+    double max = 0;
+    int failed = 0;
+    for (int i = 0; i < count; i++) {
+        struct load_state state;
+        state.size = 0;
+        state.status_code = 0;
+        MonotonicTime start = MonotonicTime::now();
+        if (!purc_fetcher_local_load(url, "GET", 10, &client, &state)
+                || !state.semaphore.waitFor(Seconds(10))) {
+            // a late load would still refer to the state
+            fprintf(stderr, "load %d did not finish\n", i);
+            return 1;
+        }
+        double elapsed = (MonotonicTime::now() - start).microseconds();
+
+        if (state.status_code != 200) {
+            failed++;
+        }
+
+        total += elapsed;
+        if (i == 0 || elapsed < min) {
+            min = elapsed;
+        }
+        if (elapsed > max) {
+            max = elapsed;
+        }
+    }
+
+    fprintf(stderr, "url=%s|count=%d|failed=%d\n", url, count, failed);
+    fprintf(stderr, "latency(us)|avg=%.1f|min=%.1f|max=%.1f\n",
+            total / count, min, max);
+
+    return 0;
+}
@@ -0,0 +1,45 @@
+#include "config.h"
+#include "NetworkDataTaskLsql.h"
+
+#include <stdio.h>
+
+// Checks which $name parameters of an lsql query go into its SQL text: only
+// the table names, the other values are left to be bound.
+//
+// usage: lsql_params
+
+struct sql_case {
+    const char* sql;
+    const char* expected;
+};
+
+static const struct sql_case cases[] = {
+    { "SELECT * FROM t WHERE id=$id", "SELECT * FROM t WHERE id=$id" },
+    { "SELECT * FROM t WHERE id = $missing", "SELECT * FROM t WHERE id = $missing" },
+    { "SELECT * FROM $table WHERE id=$id", "SELECT * FROM users WHERE id=$id" },
+    { "INSERT INTO $table VALUES($id, $name)", "INSERT INTO users VALUES($id, $name)" },
+    { "UPDATE $table SET name=$name", "UPDATE users SET name=$name" },
+    { "SELECT '$$' FROM t", "SELECT '$' FROM t" },
+};
+
+int main(void)
+{
+    HashMap<String, String> params;
+    params.set("table", "users");
+    params.set("id", "1 OR 1=1");
+    params.set("name", "x'); DROP TABLE users; --");
+
+    int failed = 0;
+    for (auto& item : cases) {
+        String sql = PurCFetcher::NetworkDataTaskLsql::substituteSqlParameters(
+                String::fromUTF8(item.sql), params);
+        bool passed = sql == String::fromUTF8(item.expected);
+        if (!passed) {
+            failed++;
+        }
+        fprintf(stderr, "%s|%s|%s\n", passed ? "ok" : "FAILED", item.sql,
+                sql.utf8().data());
+    }
+
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,74 @@
+#include "purc/purc.h"
+#include "capi/fetcher.h"
+
+#include <wtf/MonotonicTime.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+// Measures the per-request latency of sequential sync requests.
+//
+// usage: req_latency [url] [count]
+//
+// PURC_FETCHER_SESSION_POOL_SIZE limits the number of IPC connections the
+// requests are multiplexed over; run it with PURC_FETCHER_SESSION_POOL_SIZE=0
+// too, which opens a connection per request, to compare.
+//
+// Built with ENABLE_LINK_PURC_FETCHER off, the requests go to the in-process
+// fetcher instead; local_latency times the loads of that fetcher directly.
+
+int main(int argc, char** argv)
+{
+    const char* def_url = "lcmd:///bin/true";
+    const char* url = argc > 1 ? argv[1] : def_url;
+    int count = argc > 2 ? atoi(argv[2]) : 100;
+    if (count <= 0) {
+        count = 100;
+    }
+
+    purc_instance_extra_info info = {};
+    purc_init ("cn.fmsoft.hybridos.sample", "pcfetcher", &info);
+
+    double total = 0;
+    double min = 0;
+    double max = 0;
+    int failed = 0;
+    for (int i = 0; i < count; i++) {
+        struct pcfetcher_resp_header resp_header = {};
+        MonotonicTime start = MonotonicTime::now();
+        purc_rwstream_t resp = pcfetcher_request_sync(
+            url,
+            PCFETCHER_REQUEST_METHOD_GET,
+            NULL,
+            10,
+            &resp_header);
+        double elapsed = (MonotonicTime::now() - start).microseconds();
+
+        if (!resp) {
+            failed++;
+        }
+        else {
+            purc_rwstream_destroy(resp);
+        }
+        if (resp_header.mime_type) {
+            free(resp_header.mime_type);
+        }
+
+        total += elapsed;
+        if (i == 0 || elapsed < min) {
+            min = elapsed;
+        }
+        if (elapsed > max) {
+            max = elapsed;
+        }
+    }
+
+    fprintf(stderr, "url=%s|count=%d|failed=%d\n", url, count, failed);
+    fprintf(stderr, "latency(us)|avg=%.1f|min=%.1f|max=%.1f\n",
+            total / count, min, max);
+
+    purc_cleanup();
+
+    return 0;
+}
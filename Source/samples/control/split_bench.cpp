@@ -0,0 +1,108 @@
+#include "config.h"
+#include "FilterBase.h"
+
+#include <wtf/MonotonicTime.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// Measures the splitting of the split and delimiter filters of lcmd, on a
+// generated tabular output, against splitting with String::split() on
+// each delimiter in turn, as the filters used to do.
+//
+// usage: split_bench [lines] [columns]
+//
+// The delimiter sets go from one character to more than the vector
+// instructions compare with, where the splitter uses its table.
+
+static const char* delimiter_sets[] = {
+    "\t",
+    " \t",
+    ",;| \t",
+    ",;:|/ \t-_=+.",
+};
+
+static String make_output(int line_count, int column_count)
+{
+    StringBuilder output;
+    static const char separators[] = "\t\t\t ,;|";
+    for (int i = 0; i < line_count; i++) {
+        for (int j = 0; j < column_count; j++) {
+            if (j) {
+                output.append(separators[(i + j) % (sizeof(separators) - 1)]);
+            }
+            output.append("cell");
+            output.appendNumber(i * column_count + j);
+            output.append("-value");
+        }
+        output.append('\n');
+    }
+    return output.toString();
+}
+
+static void split_with_strings(const String& text, const String& delimiters,
+        unsigned index, Vector<String>& cells)
+{
+    if (index == delimiters.length()) {
+        cells.append(text);
+        return;
+    }
+
+    for (auto& piece : text.split(delimiters[index])) {
+        split_with_strings(piece, delimiters, index + 1, cells);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    int line_count = argc > 1 ? atoi(argv[1]) : 20000;
+    if (line_count <= 0) {
+        line_count = 20000;
+    }
+    int column_count = argc > 2 ? atoi(argv[2]) : 64;
+    if (column_count <= 0) {
+        column_count = 64;
+    }
+
+    String output = make_output(line_count, column_count);
+    Vector<StringView> lines;
+    for (auto line : StringView(output).split('\n')) {
+        lines.append(line);
+    }
+    double megabytes = output.length() / (1024.0 * 1024.0);
+
+    fprintf(stderr, "lines=%zu|bytes=%u\n", lines.size(), output.length());
+    for (auto* set : delimiter_sets) {
+        String delimiters = String::fromUTF8(set);
+        PurCFetcher::DelimiterSet delimiter_set(delimiters);
+
+        size_t cell_count = 0;
+        PurCFetcher::Row cells;
+        MonotonicTime start = MonotonicTime::now();
+        for (auto& line : lines) {
+            cells.shrink(0);
+            PurCFetcher::FilterBase::splitByCharacters(line, delimiter_set,
+                    cells);
+            cell_count += cells.size();
+        }
+        double splitter_time = (MonotonicTime::now() - start).seconds();
+
+        size_t string_cell_count = 0;
+        Vector<String> string_cells;
+        start = MonotonicTime::now();
+        for (auto& line : lines) {
+            string_cells.shrink(0);
+            split_with_strings(line.toString(), delimiters, 0, string_cells);
+            string_cell_count += string_cells.size();
+        }
+        double string_time = (MonotonicTime::now() - start).seconds();
+
+        fprintf(stderr, "delimiters=%u|cells=%zu%s|splitter(MB/s)=%.0f"
+                "|String::split(MB/s)=%.0f\n",
+                delimiters.length(), cell_count,
+                cell_count == string_cell_count ? "" : "(MISMATCH)",
+                megabytes / splitter_time, megabytes / string_time);
+    }
+
+    return 0;
+}